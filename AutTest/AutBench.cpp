@@ -0,0 +1,905 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutBench.cpp
+//
+
+#include "AutBench.h"
+
+#include "AutAnim.h"
+#include "AutAnimOutputs.h"
+#include "AutEase.h"
+#include "AutClip.h"
+#include "AutVec.h"
+#include "AutRunningAverage.h"
+#include "AutConcurrentRunningAverage.h"
+#include "AutRunningAverageTable.h"
+#include "AutRunningQuantile.h"
+#include "AutFixedRunningAverage.h"
+#include "AutMultiRunningAverage.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace Aut
+{
+    namespace
+    {
+        // Time a function that is called repeatedly, returning nanoseconds
+        // per call.
+        
+        template <typename F>
+        double nsPerCall(F f, size_t calls)
+        {
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < calls; i++)
+                f(i);
+            std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+            return std::chrono::duration<double, std::nano>(t1 - t0).count() / calls;
+        }
+        
+        // Keep the optimizer from discarding results.
+        
+        volatile float sink;
+        
+        // The original storage in Aut::RunningAverage<T>, a deque, which
+        // allocates and frees blocks as values pass through it, with the
+        // original treatment of the time window.  The sum is kept as in
+        // Aut::RunningAverage<T>, so mainly the storage differs.
+        
+        template <typename T>
+        class DequeAverage
+        {
+        public:
+            DequeAverage(size_t capacity, std::chrono::milliseconds window) :
+                _capacity(capacity), _window(window) {}
+            
+            void add(const T& x)
+            {
+                std::chrono::time_point<std::chrono::system_clock> now =
+                    std::chrono::system_clock::now();
+                if (now - _time > _window)
+                {
+                    _deque.clear();
+                    _sum.clear();
+                }
+                _time = now;
+                _deque.push_back(x);
+                _sum.add(x);
+                if (_deque.size() > _capacity)
+                {
+                    _sum.subtract(_deque.front());
+                    _deque.pop_front();
+                }
+            }
+            
+            T operator()() const
+            {
+                return _deque.empty() ? T() : _sum() / _deque.size();
+            }
+            
+        private:
+            size_t                                              _capacity;
+            std::chrono::milliseconds                           _window;
+            std::chrono::time_point<std::chrono::system_clock>  _time;
+            std::deque<T>                                       _deque;
+            RunningSum<T>                                       _sum;
+        };
+        
+        // The original segment lookup in Aut::Anim<T>, which checked each
+        // segment (with its heap-allocated data) from the first until finding
+        // the one containing the time.
+        
+        struct LinearSegment
+        {
+            float*                                val;
+            float                                 val0;
+            float                                 val1;
+            std::chrono::seconds                  duration;
+            std::chrono::steady_clock::time_point t0;
+        };
+        
+        bool linearEval(const std::vector<std::unique_ptr<LinearSegment>>& segments,
+                        std::chrono::steady_clock::time_point t)
+        {
+            for (const std::unique_ptr<LinearSegment>& s : segments)
+            {
+                if ((s->t0 <= t) && (t < s->t0 + s->duration))
+                {
+                    float tt0 = std::chrono::duration_cast<std::chrono::milliseconds>(t - s->t0).count();
+                    float t1t0 = std::chrono::duration_cast<std::chrono::milliseconds>(s->duration).count();
+                    *s->val = s->val0 + ((1 - cosf(tt0 / t1t0 * M_PI)) / 2.0f) * (s->val1 - s->val0);
+                    return true;
+                }
+            }
+            return false;
+        }
+        
+        // The original easing in Aut::Anim<T>, computed from milliseconds with
+        // cosf() and a double-precision pi.
+        
+        float cosfEval(std::chrono::steady_clock::time_point t,
+                       std::chrono::steady_clock::time_point t0,
+                       std::chrono::steady_clock::time_point t1,
+                       float val0, float val1)
+        {
+            float tt0 = std::chrono::duration_cast<std::chrono::milliseconds>(t - t0).count();
+            float t1t0 = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
+            return val0 + ((1 - cosf(tt0 / t1t0 * M_PI)) / 2.0f) * (val1 - val0);
+        }
+        
+        // Time evaluating an animation with a particular easing policy.
+        
+        template <typename Ease>
+        double animEaseNs(std::chrono::steady_clock::time_point t0, size_t evals)
+        {
+            float val = 0.0f;
+            Anim<float, Ease> anim;
+            anim.emplaceSegment(&val, 0.0f, 1.0f, std::chrono::seconds(100));
+            anim.start(t0);
+            std::chrono::steady_clock::duration step =
+                std::chrono::steady_clock::duration(std::chrono::seconds(100)) / evals;
+            return nsPerCall([&](size_t i)
+            {
+                anim.eval(t0 + step * i, Anim<float, Ease>::StopAfterEnd);
+                sink = val;
+            }, evals);
+        }
+        
+        // Time just the easing function of a policy.
+        
+        template <typename Ease>
+        double easeNs(size_t evals)
+        {
+            float step = 1.0f / evals;
+            return nsPerCall([&](size_t i)
+            {
+                sink = Ease::eval(i * step);
+            }, evals);
+        }
+        
+        // A four-float vector with plain scalar arithmetic, for comparison
+        // with Vec<4>.
+        
+        struct Float4
+        {
+            float v[4];
+        };
+        
+        Float4 operator+(const Float4& a, const Float4& b)
+        {
+            Float4 r = {{ a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] }};
+            return r;
+        }
+        
+        Float4 operator-(const Float4& a, const Float4& b)
+        {
+            Float4 r = {{ a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] }};
+            return r;
+        }
+        
+        Float4 operator*(float s, const Float4& a)
+        {
+            Float4 r = {{ s * a.v[0], s * a.v[1], s * a.v[2], s * a.v[3] }};
+            return r;
+        }
+        
+        float component(float val)          { return val; }
+        float component(const Float4& val)  { return val.v[3]; }
+        float component(const Vec<3>& val)  { return val[2]; }
+        float component(const Vec<4>& val)  { return val[3]; }
+        float component(const Quat& val)    { return val.w; }
+        
+        // Time evaluating an animation of a particular type.
+        
+        template <typename T>
+        double animTypeNs(std::chrono::steady_clock::time_point t0, const T& val0,
+                          const T& val1, size_t evals)
+        {
+            T val = val0;
+            Anim<T> anim;
+            anim.emplaceSegment(&val, val0, val1, std::chrono::seconds(100));
+            anim.start(t0);
+            std::chrono::steady_clock::duration step =
+                std::chrono::steady_clock::duration(std::chrono::seconds(100)) / evals;
+            return nsPerCall([&](size_t i)
+            {
+                anim.eval(t0 + step * i, Anim<T>::StopAfterEnd);
+                sink = component(val);
+            }, evals);
+        }
+    }
+    
+    void benchAnimSegmentLookup()
+    {
+        std::cerr << "Starting Aut::benchAnimSegmentLookup()\n";
+        
+        const size_t evals = 200000;
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        
+        for (size_t count : {4, 32, 256, 1024})
+        {
+            float val = 0.0f;
+            std::vector<Anim<float>::Segment> segments;
+            std::vector<std::unique_ptr<LinearSegment>> linear;
+            std::chrono::steady_clock::time_point t = t0;
+            for (size_t i = 0; i < count; i++)
+            {
+                std::chrono::seconds d(1 + i % 3);
+                segments.push_back(Anim<float>::Segment(&val, float(i), float(i + 1), d));
+                LinearSegment s = { &val, float(i), float(i + 1), d, t };
+                linear.push_back(std::unique_ptr<LinearSegment>(new LinearSegment(s)));
+                t += d;
+            }
+            std::chrono::steady_clock::duration total = t - t0;
+            
+            Anim<float> anim;
+            anim.set(segments);
+            anim.start(t0);
+            
+            // Time moving forward through the whole animation, as in playback.
+            
+            std::chrono::steady_clock::duration step = total / evals;
+            double forwardNew = nsPerCall([&](size_t i)
+            {
+                anim.eval(t0 + step * i, Anim<float>::StopAfterEnd);
+                sink = val;
+            }, evals);
+            double forwardOld = nsPerCall([&](size_t i)
+            {
+                linearEval(linear, t0 + step * i);
+                sink = val;
+            }, evals);
+            
+            // Times jumping around the animation, as in scrubbing.
+            
+            std::chrono::steady_clock::duration jump = total / 7919;
+            double randomNew = nsPerCall([&](size_t i)
+            {
+                anim.eval(t0 + jump * ((i * 104729) % 7919), Anim<float>::StopAfterEnd);
+                sink = val;
+            }, evals);
+            double randomOld = nsPerCall([&](size_t i)
+            {
+                linearEval(linear, t0 + jump * ((i * 104729) % 7919));
+                sink = val;
+            }, evals);
+            
+            std::cerr << count << " segments: forward " << forwardOld << " ns -> "
+                      << forwardNew << " ns (" << forwardOld / forwardNew << "x), random "
+                      << randomOld << " ns -> " << randomNew << " ns ("
+                      << randomOld / randomNew << "x)\n";
+        }
+        
+        std::cerr << "ok\n";
+    }
+    
+    void benchAnimEasing()
+    {
+        std::cerr << "Starting Aut::benchAnimEasing()\n";
+        
+        const size_t evals = 1000000;
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::time_point t1 = t0 + std::chrono::seconds(100);
+        std::chrono::steady_clock::duration step = t1 - t0;
+        step /= evals;
+        
+        double original = nsPerCall([&](size_t i)
+        {
+            sink = cosfEval(t0 + step * i, t0, t1, 0.0f, 1.0f);
+        }, evals);
+        
+        std::cerr << "original cosf path: " << original << " ns (ease only)\n";
+        std::cerr << "policy: ease only, full Anim::eval\n";
+        std::cerr << "CosineEase: " << easeNs<CosineEase>(evals) << " ns, "
+                  << animEaseNs<CosineEase>(t0, evals) << " ns\n";
+        std::cerr << "FastCosineEase: " << easeNs<FastCosineEase>(evals) << " ns, "
+                  << animEaseNs<FastCosineEase>(t0, evals) << " ns\n";
+        std::cerr << "SmoothstepEase: " << easeNs<SmoothstepEase>(evals) << " ns, "
+                  << animEaseNs<SmoothstepEase>(t0, evals) << " ns\n";
+        std::cerr << "BezierEaseInOut: " << easeNs<BezierEaseInOut>(evals) << " ns, "
+                  << animEaseNs<BezierEaseInOut>(t0, evals) << " ns\n";
+        std::cerr << "LinearEase: " << easeNs<LinearEase>(evals) << " ns, "
+                  << animEaseNs<LinearEase>(t0, evals) << " ns\n";
+        std::cerr << "StepEase: " << easeNs<StepEase>(evals) << " ns, "
+                  << animEaseNs<StepEase>(t0, evals) << " ns\n";
+        
+        std::cerr << "ok\n";
+    }
+    
+    void benchClipLoad()
+    {
+        std::cerr << "Starting Aut::benchClipLoad()\n";
+        
+        // Loading canned clips by building animations from segments, compared
+        // with mapping a clip file and setting up players for its clips.  Each
+        // load is timed until every clip has been evaluated once, so both
+        // include touching their segments, and the best of several rounds is
+        // reported.  Mapping a file that is not in the page cache also reads
+        // it from the disk, which is reported separately where the file can
+        // be evicted from the cache.
+        
+        const size_t clips = 5000;
+        const size_t segments = 16;
+        const int rounds = 5;
+        std::vector<float> vals(clips);
+        
+        ClipWriter<float> writer;
+        for (size_t i = 0; i < clips; i++)
+        {
+            writer.beginClip();
+            for (size_t j = 0; j < segments; j++)
+                writer.addSegment(float(j), float(j + 1), std::chrono::seconds(1));
+        }
+        const char* dir = getenv("TMPDIR");
+        std::string path = std::string(dir ? dir : "/tmp") + "/AutBenchClip.autc";
+        writer.write(path);
+        
+        auto build = [&]() -> double
+        {
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            std::unique_ptr<Anim<float>[]> anims(new Anim<float>[clips]);
+            for (size_t i = 0; i < clips; i++)
+            {
+                std::vector<Anim<float>::Segment> s;
+                for (size_t j = 0; j < segments; j++)
+                    s.push_back(Anim<float>::Segment(&vals[i], float(j), float(j + 1),
+                                                     std::chrono::seconds(1)));
+                anims[i].set(std::move(s));
+                anims[i].start(t0);
+                anims[i].eval(t0 + std::chrono::milliseconds(7500));
+            }
+            sink = vals[clips - 1];
+            return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+        };
+        
+        auto map = [&]() -> double
+        {
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            ClipFile<float> file(path);
+            std::vector<ClipPlayer<float>> players(file.size());
+            for (size_t i = 0; i < file.size(); i++)
+            {
+                players[i].set(&vals[i], file.clip(i));
+                players[i].start(t0);
+                players[i].eval(t0 + std::chrono::milliseconds(7500));
+            }
+            sink = vals[clips - 1];
+            return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+        };
+        
+        double built = 1.0e30, mapped = 1.0e30;
+        for (int i = 0; i < rounds; i++)
+        {
+            built = std::min(built, build());
+            mapped = std::min(mapped, map());
+        }
+        std::cerr << clips << " clips of " << segments << " segments: built "
+                  << built << " us, mapped " << mapped << " us ("
+                  << built / mapped << "x)\n";
+        
+#if defined(POSIX_FADV_DONTNEED)
+        double cold = 1.0e30;
+        for (int i = 0; i < rounds; i++)
+        {
+            int fd = open(path.c_str(), O_RDONLY);
+            fdatasync(fd);
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            close(fd);
+            cold = std::min(cold, map());
+        }
+        std::cerr << "mapped from outside the page cache " << cold << " us ("
+                  << built / cold << "x)\n";
+#endif
+        
+        remove(path.c_str());
+        
+        std::cerr << "ok\n";
+    }
+    
+    void benchAnimTypes()
+    {
+        std::cerr << "Starting Aut::benchAnimTypes()\n";
+        
+        const size_t evals = 1000000;
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        Float4 f0 = {{ 0.0f, 0.0f, 0.0f, 0.0f }};
+        Float4 f1 = {{ 1.0f, 2.0f, 3.0f, 4.0f }};
+        
+        std::cerr << "float: " << animTypeNs(t0, 0.0f, 1.0f, evals) << " ns\n";
+        std::cerr << "scalar 4 floats: " << animTypeNs(t0, f0, f1, evals) << " ns\n";
+        std::cerr << "Vec<3>: " << animTypeNs(t0, Vec<3>(), Vec<3>({ 1.0f, 2.0f, 3.0f }), evals)
+                  << " ns\n";
+        std::cerr << "Vec<4>: " << animTypeNs(t0, Vec<4>(), Vec<4>({ 1.0f, 2.0f, 3.0f, 4.0f }), evals)
+                  << " ns\n";
+        std::cerr << "Quat (nlerp): "
+                  << animTypeNs(t0, Quat(), Quat::axisAngle(0.0f, 1.0f, 0.0f, 2.0f), evals)
+                  << " ns\n";
+        
+        std::cerr << "ok\n";
+    }
+    
+    void benchBakedAnim()
+    {
+        std::cerr << "Starting Aut::benchBakedAnim()\n";
+        
+        // An animation of many segments, evaluated with time moving forward
+        // and with times jumping around, compared with its baked versions.
+        
+        const size_t segments = 64;
+        const size_t evals = 1000000;
+        float val = 0.0f;
+        Anim<float, CosineEase> anim;
+        for (size_t i = 0; i < segments; i++)
+        {
+            float v = float(i % 3);
+            anim.emplaceSegment(&val, v, float((i + 1) % 3), std::chrono::seconds(1 + i % 2));
+        }
+        BakedAnim<float> full = anim.bake(120.0f);
+        BakedAnim<float> reduced = anim.bake(120.0f, 0.001f);
+        
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::duration total = std::chrono::seconds(segments * 3 / 2);
+        std::chrono::steady_clock::duration step = total / evals;
+        std::vector<std::chrono::steady_clock::time_point> random(evals);
+        unsigned seed = 1;
+        for (size_t i = 0; i < evals; i++)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            random[i] = t0 + total * (seed >> 8) / (1 << 24);
+        }
+        
+        anim.start(t0);
+        full.start(t0);
+        reduced.start(t0);
+        double animForward = nsPerCall([&](size_t i) { anim.eval(t0 + step * i); sink = val; }, evals);
+        double fullForward = nsPerCall([&](size_t i) { full.eval(t0 + step * i); sink = val; }, evals);
+        double reducedForward = nsPerCall([&](size_t i) { reduced.eval(t0 + step * i); sink = val; }, evals);
+        double animRandom = nsPerCall([&](size_t i) { anim.eval(random[i]); sink = val; }, evals);
+        double fullRandom = nsPerCall([&](size_t i) { full.eval(random[i]); sink = val; }, evals);
+        double reducedRandom = nsPerCall([&](size_t i) { reduced.eval(random[i]); sink = val; }, evals);
+        
+        std::cerr << "samples: " << full.size() << " full, " << reduced.size() << " reduced\n";
+        std::cerr << "forward: Anim " << animForward << " ns, baked " << fullForward
+                  << " ns, reduced " << reducedForward << " ns\n";
+        std::cerr << "random: Anim " << animRandom << " ns, baked " << fullRandom
+                  << " ns, reduced " << reducedRandom << " ns\n";
+        
+        std::cerr << "ok\n";
+    }
+    
+    void benchAnimOutputs()
+    {
+        std::cerr << "Starting Aut::benchAnimOutputs()\n";
+        
+        // Many animations writing through pointers to separately allocated
+        // objects, in no particular order, compared with the same animations
+        // bound to handles in an AnimOutputs<T> array.  Each frame evaluates
+        // every animation and then reads every value.
+        
+        struct Object
+        {
+            float   other[15];
+            float   val;
+        };
+        
+        const size_t count = 100000;
+        const size_t frames = 50;
+        std::vector<std::unique_ptr<Object>> objects(count);
+        for (size_t i = 0; i < count; i++)
+            objects[i].reset(new Object());
+        unsigned seed = 1;
+        for (size_t i = count - 1; i > 0; i--)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            std::swap(objects[i], objects[(seed >> 8) % (i + 1)]);
+        }
+        
+        std::vector<Anim<float>> scattered(count);
+        std::vector<Anim<float>> bound(count);
+        AnimOutputs<float> outputs;
+        outputs.reserve(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            scattered[i].emplaceSegment(&objects[i]->val, 0.0f, 1.0f, std::chrono::seconds(1 + i % 3));
+            bound[i].emplaceSegment(nullptr, 0.0f, 1.0f, std::chrono::seconds(1 + i % 3));
+            bound[i].bind(outputs, outputs.add());
+        }
+        
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::duration step = std::chrono::milliseconds(16);
+        for (size_t i = 0; i < count; i++)
+        {
+            scattered[i].start(t0);
+            bound[i].start(t0);
+        }
+        
+        double scatteredTime = nsPerCall([&](size_t frame)
+        {
+            for (Anim<float>& anim : scattered)
+                anim.eval(t0 + step * frame);
+            float sum = 0.0f;
+            for (const std::unique_ptr<Object>& object : objects)
+                sum += object->val;
+            sink = sum;
+        }, frames) / count;
+        double boundTime = nsPerCall([&](size_t frame)
+        {
+            for (Anim<float>& anim : bound)
+                anim.eval(t0 + step * frame);
+            float sum = 0.0f;
+            const float* data = outputs.data();
+            for (size_t i = 0; i < outputs.size(); i++)
+                sum += data[i];
+            sink = sum;
+        }, frames) / count;
+        
+        std::cerr << "per animation: pointers " << scatteredTime << " ns, outputs "
+                  << boundTime << " ns\n";
+        
+        std::cerr << "ok\n";
+    }
+    
+    void benchRunningAverage()
+    {
+        std::cerr << "Starting Aut::benchRunningAverage()\n";
+        
+        // Adding a value and reading the average, with the values stored in
+        // a ring buffer and in a deque, for a small and a large capacity.
+        
+        const size_t calls = 2000000;
+        for (size_t capacity : { size_t(5), size_t(1000) })
+        {
+            RunningAverage<float> ring(capacity, std::chrono::hours(1));
+            DequeAverage<float> deque(capacity, std::chrono::hours(1));
+            double ringTime = nsPerCall([&](size_t i) { ring.add(float(i % 7)); sink = ring(); }, calls);
+            double dequeTime = nsPerCall([&](size_t i) { deque.add(float(i % 7)); sink = deque(); }, calls);
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            double timedTime = nsPerCall([&](size_t i)
+            {
+                ring.add(float(i % 7), t0 + std::chrono::microseconds(i));
+                sink = ring();
+            }, calls);
+            std::cerr << "capacity " << capacity << ": ring " << ringTime << " ns, deque "
+                      << dequeTime << " ns, ring with times given " << timedTime << " ns\n";
+        }
+        
+        // Many averagers, each getting a value in turn, as when averaging
+        // values for many tracked objects.
+        
+        const size_t averagers = 10000;
+        std::vector<std::unique_ptr<RunningAverage<float>>> rings(averagers);
+        std::vector<std::unique_ptr<DequeAverage<float>>> deques(averagers);
+        for (size_t i = 0; i < averagers; i++)
+        {
+            rings[i].reset(new RunningAverage<float>(16, std::chrono::hours(1)));
+            deques[i].reset(new DequeAverage<float>(16, std::chrono::hours(1)));
+        }
+        double ringsTime = nsPerCall([&](size_t i)
+        {
+            RunningAverage<float>& avg = *rings[i % averagers];
+            avg.add(float(i % 7));
+            sink = avg();
+        }, calls);
+        double dequesTime = nsPerCall([&](size_t i)
+        {
+            DequeAverage<float>& avg = *deques[i % averagers];
+            avg.add(float(i % 7));
+            sink = avg();
+        }, calls);
+        std::cerr << averagers << " averagers: ring " << ringsTime << " ns, deque "
+                  << dequesTime << " ns\n";
+        
+        // Both read the clock on every add, which is a large part of the time.
+        
+        double clockTime = nsPerCall([&](size_t)
+        {
+            sink = float(std::chrono::system_clock::now().time_since_epoch().count() & 1);
+        }, calls);
+        std::cerr << "clock: " << clockTime << " ns\n";
+        
+        std::cerr << "ok\n";
+    }
+    
+    void benchConcurrentRunningAverage()
+    {
+        std::cerr << "Starting Aut::benchConcurrentRunningAverage()\n";
+        
+        // Several threads adding values while another reads the average,
+        // with Aut::ConcurrentRunningAverage<T> and with an
+        // Aut::RunningAverage<T> guarded by a mutex.
+        
+        const size_t threads = 4;
+        const size_t adds = 200000;
+        RunningAverage<float> guarded(16, std::chrono::hours(1));
+        std::mutex mutex;
+        ConcurrentRunningAverage<float> concurrent(16, std::chrono::hours(1));
+        
+        auto run = [&](std::function<void(float)> add, std::function<float()> read)
+        {
+            std::atomic<bool> done(false);
+            std::thread reader([&] { while (!done) sink = read(); });
+            std::vector<std::thread> producers;
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            for (size_t p = 0; p < threads; p++)
+                producers.push_back(std::thread([&] { for (size_t i = 0; i < adds; i++) add(float(i % 7)); }));
+            for (std::thread& producer : producers)
+                producer.join();
+            std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+            done = true;
+            reader.join();
+            return std::chrono::duration<double, std::nano>(t1 - t0).count() / (threads * adds);
+        };
+        
+        double guardedTime = run([&](float x) { std::lock_guard<std::mutex> lock(mutex); guarded.add(x); },
+                                 [&] { std::lock_guard<std::mutex> lock(mutex); return guarded(); });
+        double concurrentTime = run([&](float x) { concurrent.add(x); },
+                                    [&] { return concurrent(); });
+        std::cerr << threads << " threads, per add: mutex " << guardedTime << " ns, concurrent "
+                  << concurrentTime << " ns\n";
+        
+        std::cerr << "ok\n";
+    }
+    
+    void benchRunningAverageTable()
+    {
+        std::cerr << "Starting Aut::benchRunningAverageTable()\n";
+        
+        // Frames adding a value to each of many streams, with a table and
+        // with a map of Aut::RunningAverage<T> instances.
+        
+        const size_t streams = 200000;
+        const size_t frames = 10;
+        std::vector<int> keys(streams);
+        std::vector<float> values(streams);
+        for (size_t i = 0; i < streams; i++)
+            keys[i] = int(i * 7919);
+        
+        RunningAverageTable<int, float> table(5, std::chrono::hours(1));
+        std::unordered_map<int, std::unique_ptr<RunningAverage<float>>> map;
+        
+        double tableTime = nsPerCall([&](size_t frame)
+        {
+            for (size_t i = 0; i < streams; i++)
+                values[i] = float((i + frame) % 7);
+            table.add(keys, values);
+            sink = table(keys[frame]);
+        }, frames) / streams;
+        double mapTime = nsPerCall([&](size_t frame)
+        {
+            for (size_t i = 0; i < streams; i++)
+            {
+                std::unique_ptr<RunningAverage<float>>& avg = map[keys[i]];
+                if (!avg)
+                    avg.reset(new RunningAverage<float>(5, std::chrono::hours(1)));
+                avg->add(float((i + frame) % 7));
+            }
+            sink = (*map[keys[frame]])();
+        }, frames) / streams;
+        
+        std::cerr << streams << " streams, per value: table " << tableTime << " ns, map "
+                  << mapTime << " ns\n";
+        
+        std::cerr << "ok\n";
+    }
+    
+    void benchRunningQuantile()
+    {
+        std::cerr << "Starting Aut::benchRunningQuantile()\n";
+        
+        // Adding a value and reading the median and 99th percentile of the
+        // last 1000 values, estimated and computed exactly by sorting.
+        
+        const size_t capacity = 1000;
+        const size_t calls = 20000;
+        std::vector<float> values(calls);
+        unsigned seed = 1;
+        for (size_t i = 0; i < calls; i++)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            values[i] = expf(float(seed >> 8) / float(1 << 24) * 8.0f);
+        }
+        
+        RunningQuantile<float> estimated(capacity, std::chrono::hours(1));
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        double estimatedTime = nsPerCall([&](size_t i)
+        {
+            estimated.add(values[i], t0);
+            sink = estimated.quantile(0.5) + estimated.quantile(0.99);
+        }, calls);
+        
+        std::deque<float> window;
+        std::vector<float> sorted;
+        double exactTime = nsPerCall([&](size_t i)
+        {
+            window.push_back(values[i]);
+            if (window.size() > capacity)
+                window.pop_front();
+            sorted.assign(window.begin(), window.end());
+            std::sort(sorted.begin(), sorted.end());
+            size_t n = sorted.size() - 1;
+            sink = sorted[size_t(0.5 * n)] + sorted[size_t(0.99 * n)];
+        }, calls);
+        
+        std::cerr << "capacity " << capacity << ": estimated " << estimatedTime << " ns, sorted "
+                  << exactTime << " ns\n";
+        
+        std::cerr << "ok\n";
+    }
+    
+    void benchFixedRunningAverage()
+    {
+        std::cerr << "Starting Aut::benchFixedRunningAverage()\n";
+        
+        // Adding a value and reading the average, with the times given so
+        // that reading the clock does not dominate, for the capacity fixed
+        // at compile time and set at run time.
+        
+        const size_t calls = 5000000;
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        FixedRunningAverage<float, 5> fixed5(std::chrono::hours(1));
+        RunningAverage<float> running5(5, std::chrono::hours(1));
+        FixedRunningAverage<float, 16> fixed16(std::chrono::hours(1));
+        RunningAverage<float> running16(16, std::chrono::hours(1));
+        double fixed5Time = nsPerCall([&](size_t i)
+        {
+            fixed5.add(float(i % 7), t0 + std::chrono::microseconds(i));
+            sink = fixed5();
+        }, calls);
+        double running5Time = nsPerCall([&](size_t i)
+        {
+            running5.add(float(i % 7), t0 + std::chrono::microseconds(i));
+            sink = running5();
+        }, calls);
+        double fixed16Time = nsPerCall([&](size_t i)
+        {
+            fixed16.add(float(i % 7), t0 + std::chrono::microseconds(i));
+            sink = fixed16();
+        }, calls);
+        double running16Time = nsPerCall([&](size_t i)
+        {
+            running16.add(float(i % 7), t0 + std::chrono::microseconds(i));
+            sink = running16();
+        }, calls);
+        std::cerr << "capacity 5: fixed " << fixed5Time << " ns, running " << running5Time << " ns\n";
+        std::cerr << "capacity 16: fixed " << fixed16Time << " ns, running " << running16Time << " ns\n";
+        
+        std::cerr << "ok\n";
+    }
+    
+    void benchMultiRunningAverage()
+    {
+        std::cerr << "Starting Aut::benchMultiRunningAverage()\n";
+        
+        // Frames of the x and y coordinates of 68 points, averaged with one
+        // Aut::MultiRunningAverage<> and with an Aut::RunningAverage<T> per
+        // channel, each reading the clock or given the frame's time.
+        
+        const size_t channels = 136;
+        const size_t frames = 50000;
+        std::vector<float> frame(channels);
+        std::vector<float> averages(channels);
+        MultiRunningAverage<> multi(channels, 5, std::chrono::hours(1));
+        std::vector<std::unique_ptr<RunningAverage<float>>> singles;
+        for (size_t c = 0; c < channels; c++)
+            singles.push_back(std::unique_ptr<RunningAverage<float>>(
+                new RunningAverage<float>(5, std::chrono::hours(1))));
+        
+        double multiTime = nsPerCall([&](size_t i)
+        {
+            for (size_t c = 0; c < channels; c++)
+                frame[c] = float((i + c) % 7);
+            multi.add(frame.data());
+            sink = multi()[i % channels];
+        }, frames);
+        double singlesTime = nsPerCall([&](size_t i)
+        {
+            for (size_t c = 0; c < channels; c++)
+            {
+                singles[c]->add(float((i + c) % 7));
+                averages[c] = (*singles[c])();
+            }
+            sink = averages[i % channels];
+        }, frames);
+        double timedTime = nsPerCall([&](size_t i)
+        {
+            std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+            for (size_t c = 0; c < channels; c++)
+            {
+                singles[c]->add(float((i + c) % 7), t);
+                averages[c] = (*singles[c])();
+            }
+            sink = averages[i % channels];
+        }, frames);
+        std::cerr << channels << " channels per frame: multi " << multiTime << " ns, single "
+                  << singlesTime << " ns, single with the time given " << timedTime << " ns\n";
+        
+        std::cerr << "ok\n";
+    }
+    
+    void benchSnapshot()
+    {
+        std::cerr << "Starting Aut::benchSnapshot()\n";
+        
+        // Restoring a table of many streams from a snapshot file, and
+        // rebuilding it by adding the same values again.
+        
+        const size_t streams = 200000;
+        const size_t capacity = 5;
+        std::vector<int> keys(streams);
+        std::vector<float> values(streams);
+        for (size_t i = 0; i < streams; i++)
+            keys[i] = int(i * 7919);
+        
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        RunningAverageTable<int, float> table(capacity, std::chrono::hours(1));
+        for (size_t frame = 0; frame < capacity; frame++)
+        {
+            for (size_t i = 0; i < streams; i++)
+                values[i] = float((i + frame) % 7);
+            table.add(keys, values, t0);
+        }
+        const char* dir = getenv("TMPDIR");
+        std::string path = std::string(dir ? dir : "/tmp") + "/AutBenchSnapshot.auts";
+        table.save(path, t0);
+        
+        double restoreTime = nsPerCall([&](size_t)
+        {
+            RunningAverageTable<int, float> restored;
+            restored.restore(path, t0);
+            sink = restored(keys[0]);
+        }, 10);
+        double replayTime = nsPerCall([&](size_t)
+        {
+            RunningAverageTable<int, float> replayed(capacity, std::chrono::hours(1));
+            for (size_t frame = 0; frame < capacity; frame++)
+            {
+                for (size_t i = 0; i < streams; i++)
+                    values[i] = float((i + frame) % 7);
+                replayed.add(keys, values, t0);
+            }
+            sink = replayed(keys[0]);
+        }, 10);
+        std::cerr << streams << " streams: restore " << restoreTime / 1.0e6 << " ms, replay "
+                  << replayTime / 1.0e6 << " ms\n";
+        remove(path.c_str());
+        
+        std::cerr << "ok\n";
+    }
+    
+}
@@ -27,16 +27,76 @@
 #include "AutTest.h"
 
 #include "AutRunningAverage.h"
+#include "AutConcurrentRunningAverage.h"
+#include "AutRunningAverageTable.h"
+#include "AutRunningStats.h"
+#include "AutRunningQuantile.h"
+#include "AutRollupAverage.h"
+#include "AutFixedRunningAverage.h"
+#include "AutMultiRunningAverage.h"
 #include "AutAnim.h"
+#include "AutAnimSystem.h"
+#include "AutEase.h"
+#include "AutAnimScheduler.h"
+#include "AutAnimBuffer.h"
+#include "AutAnimManager.h"
+#include "AutTimerWheel.h"
+#include "AutClip.h"
+#include "AutVec.h"
+#include "AutTimeline.h"
+#include "AutAnimBlend.h"
+#include "AutAnimOutputs.h"
+#include "AutAlert.h"
 
+#include <algorithm>
+#include <map>
+#include <string>
 #include <thread>
+#include <atomic>
 #include <chrono>
 #include <iostream>
+#include <fstream>
+#include <iterator>
 #include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 namespace Aut
 {
     
+    // A clock whose time is set by the test.
+    
+    struct TestClock
+    {
+        typedef std::chrono::milliseconds               duration;
+        typedef duration::rep                           rep;
+        typedef duration::period                        period;
+        typedef std::chrono::time_point<TestClock>      time_point;
+        static const bool                               is_steady = true;
+        
+        static time_point now() { return time_point(duration(ms)); }
+        static int ms;
+    };
+    
+    int TestClock::ms = 0;
+    
+    // A linear congruential generator, so the tests draw the same values
+    // on every platform.  Each draw is 32 bits; unit() maps the top 24 to
+    // [0, 1).
+    
+    struct TestRandom
+    {
+        TestRandom() : seed(1) {}
+        
+        unsigned next() { return seed = seed * 1664525u + 1013904223u; }
+        double uniform() { return unit(next()); }
+        static double unit(unsigned r) { return double(r >> 8) / double(1 << 24); }
+        
+        unsigned seed;
+    };
+    
     void testRunningAverage()
     {
         std::cerr << "Starting Aut::testRunningAverage()\n";
@@ -68,6 +128,69 @@ namespace Aut
         avg.add(12.0);
         assert (avg() == 12.0);
         
+        // An empty average is T(), and dropping values (by capacity or by
+        // time) keeps the sum exact even when they dwarf the others.
+        
+        RunningAverage<float> empty;
+        assert (empty() == 0.0f);
+        
+        RunningAverage<float> big(2, std::chrono::hours(1));
+        big.add(1.0e8f);
+        big.add(1.0f);
+        big.add(1.0f);
+        assert (big() == 1.0f);
+        big.setCapacity(1);
+        assert (big() == 1.0f);
+        for (int i = 0; i < 100000; i++)
+            big.add((i % 2) ? 1.0e8f : 0.1f);
+        big.setCapacity(2);
+        big.add(0.1f);
+        big.add(0.3f);
+        assert (fabsf(big() - 0.2f) < 1.0e-7f);
+        
+        // Changing the capacity keeps the most recent values.
+        
+        RunningAverage<float> ring(3, std::chrono::hours(1));
+        for (int i = 1; i <= 5; i++)
+            ring.add(float(i));
+        assert (ring() == 4.0f);
+        ring.setCapacity(2);
+        assert (ring() == 4.5f);
+        ring.setCapacity(4);
+        assert (ring.capacity() == 4);
+        ring.add(6.0f);
+        assert (ring() == 5.0f);
+        ring.add(7.0f);
+        ring.add(8.0f);
+        assert (ring() == 6.5f);
+        ring.setCapacity(0);
+        ring.add(9.0f);
+        assert (ring() == 0.0f);
+        
+        // Each value expires on its own once it is older than the window.
+        
+        typedef std::chrono::milliseconds ms;
+        RunningAverage<float, TestClock> timed(4, ms(100));
+        TestClock::ms = 1000;
+        timed.add(1.0f);
+        TestClock::ms = 1050;
+        timed.add(2.0f);
+        timed.add(3.0f, TestClock::time_point(ms(1080)));
+        assert (timed() == 2.0f);
+        TestClock::ms = 1120;
+        timed.add(6.0f);
+        assert (timed() == 11.0f / 3.0f);
+        timed.add(7.0f, TestClock::time_point(ms(1185)));
+        assert (timed() == 6.5f);
+        timed.add(8.0f, TestClock::time_point(ms(1500)));
+        assert (timed() == 8.0f);
+        
+        RunningAverage<int> ints(4);
+        assert (ints() == 0);
+        for (int i = 1; i <= 10; i++)
+            ints.add(i);
+        assert (ints() == (7 + 8 + 9 + 10) / 4);
+        
         std::cerr << "ok\n";
     }
     
@@ -120,6 +243,1803 @@ namespace Aut
         assert (D == 5.0);
         assert (I == 300);
         
+        // Evaluating at explicit times, which need not move forward, tests
+        // finding the segment containing each time.
+        
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        animD.start(t0);
+        animD.eval(t0 + std::chrono::milliseconds(1500));
+        assert (fabs(D - 7.5) < 1.0e-4);
+        animD.eval(t0 + std::chrono::milliseconds(250));
+        assert (fabs(D - 5.0 * (1.0 - cos(M_PI / 4.0))) < 1.0e-4);
+        animD.eval(t0 + std::chrono::milliseconds(1000));
+        assert (D == 10.0);
+        assert (animD.running());
+        
+        // An animation built in place, or from a moved vector, should behave
+        // the same as one built from a copied vector.
+        
+        double E = 0.0, F = 0.0;
+        Aut::Anim<double> animE, animF;
+        animE.reserve(2);
+        animE.emplaceSegment(&E, 0.0, 10.0, std::chrono::seconds(1));
+        animE.emplaceSegment(&E, 10.0, 5.0, std::chrono::seconds(1));
+        std::vector<Aut::Anim<double>::Segment> segmentsF;
+        segmentsF.push_back(Aut::Anim<double>::Segment(&F, 0.0, 10.0, std::chrono::seconds(1)));
+        segmentsF.push_back(Aut::Anim<double>::Segment(&F, 10.0, 5.0, std::chrono::seconds(1)));
+        animF.set(std::move(segmentsF));
+        animE.start(t0);
+        animF.start(t0);
+        for (int ms = 0; ms < 2000; ms += 100)
+        {
+            animD.eval(t0 + std::chrono::milliseconds(ms));
+            animE.eval(t0 + std::chrono::milliseconds(ms));
+            animF.eval(t0 + std::chrono::milliseconds(ms));
+            assert ((D == E) && (D == F));
+        }
+        animE.clear();
+        assert (!animE.running());
+        
+        // A cycling animation's phase comes from the time since the start,
+        // so a long jump lands at the same point in the cycle.  Playing back
+        // and forth mirrors every other cycle.
+        
+        animD.start(t0);
+        animD.eval(t0 + std::chrono::milliseconds(1500));
+        double D1500 = D;
+        animD.eval(t0 + std::chrono::seconds(2000) + std::chrono::milliseconds(1500));
+        assert (D == D1500);
+        assert (animD.cycle() == 1000);
+        
+        animD.start(t0);
+        animD.eval(t0 + std::chrono::milliseconds(2500), Aut::Anim<double>::PingPongAfterEnd);
+        assert (animD.reversed());
+        assert (D == D1500);
+        animD.eval(t0 + std::chrono::milliseconds(4250), Aut::Anim<double>::PingPongAfterEnd);
+        assert (!animD.reversed());
+        assert (fabs(D - 5.0 * (1.0 - cos(M_PI / 4.0))) < 1.0e-4);
+        
+        // A limited number of cycles ends with the value at the end of the
+        // last cycle, which for an even number of back-and-forth cycles is
+        // the value at the start.
+        
+        animD.setLoopCount(3);
+        animD.start(t0);
+        animD.eval(t0 + std::chrono::milliseconds(5500));
+        assert (animD.running());
+        animD.eval(t0 + std::chrono::seconds(7));
+        assert (!animD.running());
+        assert (D == 5.0);
+        animD.setLoopCount(2);
+        animD.start(t0);
+        animD.eval(t0 + std::chrono::seconds(100), Aut::Anim<double>::PingPongAfterEnd);
+        assert (!animD.running());
+        assert (D == 0.0);
+        animD.setLoopCount(0);
+        
+        std::cerr << "ok\n";
+    }
+    
+    void testAnimSystem()
+    {
+        std::cerr << "Starting Aut::testAnimSystem()\n";
+        
+        // Evaluating at explicit times makes it possible to compare the tracks
+        // of an Aut::AnimSystem<T> against equivalent Aut::Anim<T> instances
+        // while they are running, not just after they end.
+        
+        const size_t n = 37;
+        std::vector<float> sysVals(n, 0.0f), animVals(n, 0.0f);
+        std::vector<std::unique_ptr<Aut::Anim<float>>> anims;
+        Aut::AnimSystem<float> sys;
+        
+        for (size_t i = 0; i < n; i++)
+        {
+            std::vector<Aut::Anim<float>::Segment> segments;
+            std::vector<Aut::Anim<float>::Segment> sysSegments;
+            for (size_t j = 0; j <= i % 4; j++)
+            {
+                float v0 = float(i + j), v1 = float(i) - float(j * 3);
+                std::chrono::seconds d(1 + (i + j) % 3);
+                segments.push_back(Aut::Anim<float>::Segment(&animVals[i], v0, v1, d));
+                sysSegments.push_back(Aut::Anim<float>::Segment(&sysVals[i], v0, v1, d));
+            }
+            anims.push_back(std::unique_ptr<Aut::Anim<float>>(new Aut::Anim<float>));
+            anims.back()->set(segments);
+            assert (sys.add(sysSegments) == i);
+        }
+        assert (sys.size() == n);
+        
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < n; i++)
+        {
+            if (i == 5)
+                continue;
+            anims[i]->start(t0);
+            sys.start(i, t0);
+        }
+        assert (!sys.running(5));
+        
+        for (int ms = 0; ms < 15000; ms += 125)
+        {
+            std::chrono::steady_clock::time_point t = t0 + std::chrono::milliseconds(ms);
+            for (size_t i = 0; i < n; i++)
+                anims[i]->eval(t);
+            sys.eval(t);
+            for (size_t i = 0; i < n; i++)
+                assert (fabsf(sysVals[i] - animVals[i]) < 1.0e-4f * (1.0f + fabsf(animVals[i])));
+        }
+        assert (sysVals[5] == 0.0f);
+        
+        std::chrono::steady_clock::time_point tEnd = t0 + std::chrono::seconds(60);
+        sys.eval(tEnd, Aut::Anim<float>::StopAfterEnd);
+        for (size_t i = 0; i < n; i++)
+        {
+            assert (!sys.running(i));
+            if (i != 5)
+                assert (sysVals[i] == float(i) - float((i % 4) * 3));
+        }
+        
+        // Playing back and forth, with steps that land on the ends of the
+        // cycles as well as between them, should also match.
+        
+        for (size_t i = 0; i < n; i++)
+        {
+            if (i == 5)
+                continue;
+            anims[i]->start(t0);
+            sys.start(i, t0);
+        }
+        for (int ms = 0; ms < 40000; ms += 125)
+        {
+            std::chrono::steady_clock::time_point t = t0 + std::chrono::milliseconds(ms);
+            for (size_t i = 0; i < n; i++)
+                anims[i]->eval(t, Aut::Anim<float>::PingPongAfterEnd);
+            sys.eval(t, Aut::Anim<float>::PingPongAfterEnd);
+            for (size_t i = 0; i < n; i++)
+                assert (fabsf(sysVals[i] - animVals[i]) < 1.0e-4f * (1.0f + fabsf(animVals[i])));
+        }
+        
+        // Steps longer than the segments exercise the search for segments
+        // more than one away, in both directions.
+        
+        float manyVal = 0.0f, manyAnimVal = 0.0f;
+        std::vector<Aut::Anim<float>::Segment> manySegments, manyAnimSegments;
+        for (int j = 0; j < 30; j++)
+        {
+            std::chrono::seconds d(1 + j % 2);
+            manySegments.push_back(Aut::Anim<float>::Segment(&manyVal, float(j), float(-j), d));
+            manyAnimSegments.push_back(Aut::Anim<float>::Segment(&manyAnimVal, float(j), float(-j), d));
+        }
+        Aut::AnimSystem<float> manySys;
+        manySys.add(manySegments);
+        Aut::Anim<float> manyAnim;
+        manyAnim.set(manyAnimSegments);
+        manySys.start(0, t0);
+        manyAnim.start(t0);
+        for (int ms = 0; ms < 300000; ms += 3337)
+        {
+            std::chrono::steady_clock::time_point t = t0 + std::chrono::milliseconds(ms);
+            manySys.eval(t, Aut::Anim<float>::PingPongAfterEnd);
+            manyAnim.eval(t, Aut::Anim<float>::PingPongAfterEnd);
+            assert (fabsf(manyVal - manyAnimVal) < 1.0e-4f * (1.0f + fabsf(manyAnimVal)));
+        }
+        
+        sys.start(0, tEnd);
+        sys.eval(tEnd);
+        assert (sys.running(0));
+        assert (sysVals[0] == 0.0f);
+        sys.stop(0);
+        assert (!sys.running(0));
+        
+        // A cycling track with no duration keeps running, holding its final
+        // value, as an Anim<T> does.
+        
+        float zeroVal = 0.0f, zeroAnimVal = 0.0f;
+        size_t zero = sys.add({ Aut::Anim<float>::Segment(&zeroVal, 1.0f, 2.0f, std::chrono::seconds(0)) });
+        Aut::Anim<float> zeroAnim;
+        zeroAnim.emplaceSegment(&zeroAnimVal, 1.0f, 2.0f, std::chrono::seconds(0));
+        sys.start(zero, tEnd);
+        zeroAnim.start(tEnd);
+        for (int ms = 0; ms < 500; ms += 125)
+        {
+            sys.eval(tEnd + std::chrono::milliseconds(ms));
+            zeroAnim.eval(tEnd + std::chrono::milliseconds(ms));
+            assert (sys.running(zero) && zeroAnim.running());
+            assert ((zeroVal == 2.0f) && (zeroAnimVal == 2.0f));
+        }
+        sys.eval(tEnd + std::chrono::seconds(1), Aut::Anim<float>::StopAfterEnd);
+        assert (!sys.running(zero) && (zeroVal == 2.0f));
+        
+        std::cerr << "ok\n";
+    }
+    
+    void testEase()
+    {
+        std::cerr << "Starting Aut::testEase()\n";
+        
+        // The policies should be usable in constant expressions.
+        
+        static_assert(Aut::FastCosineEase::eval(0.0f) == 0.0f, "FastCosineEase");
+        static_assert(Aut::FastCosineEase::eval(1.0f) == 1.0f, "FastCosineEase");
+        static_assert(Aut::SmoothstepEase::eval(0.5f) == 0.5f, "SmoothstepEase");
+        static_assert(Aut::LinearEase::eval(0.25f) == 0.25f, "LinearEase");
+        static_assert(Aut::StepEase::eval(0.99f) == 0.0f, "StepEase");
+        static_assert(Aut::BezierEaseInOut::eval(1.0f) == 1.0f, "CubicBezierEase");
+        
+        // FastCosineEase should stay within its documented error bound of
+        // CosineEase, and all the smooth policies should be monotonic.
+        
+        float prevFast = 0.0f, prevSmooth = 0.0f, prevBezier = 0.0f;
+        for (int i = 0; i <= 10000; i++)
+        {
+            float s = i / 10000.0f;
+            float fast = Aut::FastCosineEase::eval(s);
+            assert (fabsf(fast - Aut::CosineEase::eval(s)) < 5.0e-7f);
+            assert (fast >= prevFast);
+            prevFast = fast;
+            float smooth = Aut::SmoothstepEase::eval(s);
+            assert (fabsf(smooth - Aut::CosineEase::eval(s)) < 0.011f);
+            assert (smooth >= prevSmooth);
+            prevSmooth = smooth;
+            float bezier = Aut::BezierEase::eval(s);
+            assert (bezier >= prevBezier - 1.0e-6f);
+            prevBezier = bezier;
+        }
+        
+        // A symmetric Bezier curve should pass through the middle point.
+        
+        assert (fabsf(Aut::BezierEaseInOut::eval(0.5f) - 0.5f) < 1.0e-6f);
+        
+        // The policy chosen for an animation should determine its values.
+        
+        float L = 0.0f, S = 0.0f;
+        Aut::Anim<float, Aut::LinearEase> animL;
+        animL.emplaceSegment(&L, 0.0f, 8.0f, std::chrono::seconds(2));
+        Aut::Anim<float, Aut::StepEase> animS;
+        animS.emplaceSegment(&S, 0.0f, 8.0f, std::chrono::seconds(2));
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        animL.start(t0);
+        animS.start(t0);
+        animL.eval(t0 + std::chrono::milliseconds(500));
+        animS.eval(t0 + std::chrono::milliseconds(500));
+        assert (fabsf(L - 2.0f) < 1.0e-5f);
+        assert (S == 0.0f);
+        animL.eval(t0 + std::chrono::seconds(2), Aut::Anim<float, Aut::LinearEase>::StopAfterEnd);
+        animS.eval(t0 + std::chrono::seconds(2), Aut::Anim<float, Aut::StepEase>::StopAfterEnd);
+        assert ((L == 8.0f) && (S == 8.0f));
+        
+        std::cerr << "ok\n";
+    }
+    
+    void testAnimScheduler()
+    {
+        std::cerr << "Starting Aut::testAnimScheduler()\n";
+        
+        // Animations evaluated in parallel should get exactly the same values
+        // as identical animations evaluated one after another.
+        
+        const size_t n = 5000;
+        std::vector<float> parallelVals(n, 0.0f), serialVals(n, 0.0f);
+        std::vector<Aut::Anim<float>> parallelAnims(n), serialAnims(n);
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        
+        Aut::AnimScheduler scheduler(3, 64);
+        for (size_t i = 0; i < n; i++)
+        {
+            for (size_t j = 0; j < 1 + i % 3; j++)
+            {
+                std::chrono::seconds d(1 + (i + j) % 4);
+                parallelAnims[i].emplaceSegment(&parallelVals[i], float(i), float(j), d);
+                serialAnims[i].emplaceSegment(&serialVals[i], float(i), float(j), d);
+            }
+            parallelAnims[i].start(t0);
+            serialAnims[i].start(t0);
+        }
+        scheduler.add(parallelAnims.data(), n / 2);
+        for (size_t i = n / 2; i < n; i++)
+            scheduler.add(parallelAnims[i], Aut::Anim<float>::StopAfterEnd);
+        assert (scheduler.size() == n);
+        
+        for (int ms = 0; ms < 20000; ms += 250)
+        {
+            std::chrono::steady_clock::time_point t = t0 + std::chrono::milliseconds(ms);
+            scheduler.eval(t);
+            for (size_t i = 0; i < n; i++)
+                serialAnims[i].eval(t, (i < n / 2) ? Aut::Anim<float>::RestartAfterEnd :
+                                    Aut::Anim<float>::StopAfterEnd);
+            assert (parallelVals == serialVals);
+        }
+        for (size_t i = 0; i < n; i++)
+            assert (parallelAnims[i].running() == serialAnims[i].running());
+        
+        scheduler.clear();
+        assert (scheduler.size() == 0);
+        scheduler.eval();
+        
+        std::cerr << "ok\n";
+    }
+    
+    void testAnimBuffer()
+    {
+        std::cerr << "Starting Aut::testAnimBuffer()\n";
+        
+        // All the animations have the same segment, so when they are evaluated
+        // at the same time their values are equal.  The reading thread should
+        // never see a mixture of values from different evaluations, and the
+        // values it sees should never go backwards.
+        
+        const size_t n = 1000;
+        Aut::AnimBuffer<float> buffer(n);
+        assert (buffer.size() == n);
+        std::vector<Aut::Anim<float, Aut::LinearEase>> anims(n);
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < n; i++)
+        {
+            anims[i].emplaceSegment(buffer.value(i), 0.0f, 1000000.0f, std::chrono::seconds(1000));
+            anims[i].start(t0);
+        }
+        
+        std::atomic<bool> done(false);
+        std::thread reader([&]
+        {
+            float last = 0.0f;
+            while (!done)
+            {
+                const float* vals = buffer.read();
+                for (size_t i = 1; i < n; i++)
+                    assert (vals[i] == vals[0]);
+                assert (vals[0] >= last);
+                last = vals[0];
+            }
+        });
+        
+        for (int frame = 0; frame < 2000; frame++)
+        {
+            std::chrono::steady_clock::time_point t = t0 + std::chrono::milliseconds(frame * 10);
+            for (size_t i = 0; i < n; i++)
+                anims[i].eval(t);
+            buffer.publish();
+        }
+        done = true;
+        reader.join();
+        
+        const float* vals = buffer.read();
+        assert (vals[0] == buffer.values()[0]);
+        assert (vals[n - 1] == buffer.values()[n - 1]);
+        
+        std::cerr << "ok\n";
+    }
+    
+    void testTimerWheel()
+    {
+        std::cerr << "Starting Aut::testTimerWheel()\n";
+        
+        // Items scheduled at random times, some far enough in the future to
+        // need cascading down the levels of the wheel, should come due exactly
+        // when a simple map of times says they should.
+        
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        Aut::TimerWheel wheel(std::chrono::milliseconds(1), t0);
+        std::map<size_t, long long> expected;
+        std::vector<size_t> due;
+        long long now = 0;
+        srand(1);
+        for (int i = 0; i < 100000; i++)
+        {
+            size_t item = rand() % 200;
+            int op = rand() % 10;
+            if (op < 4)
+            {
+                long long delay = (op == 0) ? (long long)(rand()) * 1000 : rand() % 3000;
+                expected[item] = now + delay;
+                wheel.schedule(item, t0 + std::chrono::milliseconds(now + delay));
+            }
+            else if (op < 5)
+            {
+                expected.erase(item);
+                wheel.cancel(item);
+                assert (!wheel.scheduled(item));
+            }
+            else
+            {
+                now += (rand() % 20 == 0) ? (long long)(rand() % 100000) * 100 : rand() % 50;
+                due.clear();
+                wheel.advance(t0 + std::chrono::milliseconds(now), due);
+                std::sort(due.begin(), due.end());
+                
+                std::vector<size_t> expectedDue;
+                for (std::map<size_t, long long>::const_iterator it = expected.begin(); it != expected.end(); ++it)
+                {
+                    if (it->second <= now)
+                        expectedDue.push_back(it->first);
+                }
+                for (size_t item : expectedDue)
+                    expected.erase(item);
+                assert (due == expectedDue);
+            }
+            assert (wheel.size() == expected.size());
+        }
+        
+        std::cerr << "ok\n";
+    }
+    
+    void testAnimManager()
+    {
+        std::cerr << "Starting Aut::testAnimManager()\n";
+        
+        // Each animation holds, changes, then holds again, so it should be
+        // active only during its middle segment.
+        
+        typedef Aut::Anim<float, Aut::LinearEase> Anim;
+        const size_t n = 100;
+        std::vector<float> vals(n, -1.0f);
+        std::vector<Anim> anims(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            anims[i].emplaceSegment(&vals[i], 0.0f, 0.0f, std::chrono::seconds(1));
+            anims[i].emplaceSegment(&vals[i], 0.0f, 1.0f, std::chrono::seconds(1));
+            anims[i].emplaceSegment(&vals[i], 1.0f, 1.0f, std::chrono::seconds(1));
+        }
+        
+        Aut::AnimManager<float, Aut::LinearEase> manager;
+        std::vector<std::pair<size_t, size_t>> segmentEnds;
+        std::vector<size_t> ends;
+        for (size_t i = 0; i < n; i++)
+        {
+            Anim::EvalAfterEnd afterEnd = (i == 0) ? Anim::RestartAfterEnd : Anim::StopAfterEnd;
+            size_t index = manager.add(anims[i], afterEnd);
+            assert (index == i);
+            manager.setSegmentEndFunction(index, [&](size_t anim, size_t segment)
+                                          { segmentEnds.push_back(std::make_pair(anim, segment)); });
+            manager.setEndFunction(index, [&](size_t anim) { ends.push_back(anim); });
+        }
+        assert (manager.size() == n);
+        assert (manager.active() == 0);
+        
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < n; i++)
+            manager.start(i, t0);
+        manager.eval(t0);
+        assert (manager.active() == 0);
+        assert (vals[0] == 0.0f);
+        assert (segmentEnds.empty());
+        
+        manager.eval(t0 + std::chrono::milliseconds(500));
+        assert (manager.active() == 0);
+        
+        manager.eval(t0 + std::chrono::milliseconds(1500));
+        assert (manager.active() == n);
+        assert (segmentEnds.size() == n);
+        assert (segmentEnds[0] == std::make_pair(size_t(0), size_t(0)));
+        assert (fabsf(vals[n - 1] - 0.5f) < 1.0e-5f);
+        
+        manager.eval(t0 + std::chrono::milliseconds(2500));
+        assert (manager.active() == 0);
+        assert (segmentEnds.size() == 2 * n);
+        assert (vals[n - 1] == 1.0f);
+        
+        // The animations that stop after the end are no longer managed; the
+        // one that restarts passes the end and the first segment at once.
+        
+        segmentEnds.clear();
+        manager.eval(t0 + std::chrono::milliseconds(4500));
+        assert (ends.size() == n);
+        assert (!manager.running(n - 1));
+        assert (manager.running(0));
+        assert (manager.active() == 1);
+        assert (segmentEnds.size() == n + 1);
+        assert (std::count(segmentEnds.begin(), segmentEnds.end(),
+                           std::make_pair(size_t(0), size_t(0))) == 1);
+        assert (fabsf(vals[0] - 0.5f) < 1.0e-5f);
+        
+        manager.stop(0);
+        assert (manager.active() == 0);
+        ends.clear();
+        manager.eval(t0 + std::chrono::milliseconds(10000));
+        assert (ends.empty());
+        assert (fabsf(vals[0] - 0.5f) < 1.0e-5f);
+        
+        // Playing back and forth, the segments end in reverse order on the
+        // way back.
+        
+        Aut::AnimManager<float, Aut::LinearEase> pingPongManager;
+        size_t index = pingPongManager.add(anims[1], Anim::PingPongAfterEnd);
+        segmentEnds.clear();
+        ends.clear();
+        pingPongManager.setSegmentEndFunction(index, [&](size_t anim, size_t segment)
+                                              { segmentEnds.push_back(std::make_pair(anim, segment)); });
+        pingPongManager.setEndFunction(index, [&](size_t anim) { ends.push_back(anim); });
+        pingPongManager.start(index, t0);
+        for (int ms = 0; ms <= 6500; ms += 100)
+            pingPongManager.eval(t0 + std::chrono::milliseconds(ms));
+        assert (ends.size() == 2);
+        assert (segmentEnds.size() == 6);
+        for (size_t i = 0; i < 3; i++)
+        {
+            assert (segmentEnds[i].second == i);
+            assert (segmentEnds[3 + i].second == 2 - i);
+        }
+        assert (vals[1] == 0.0f);
+        
+        // Skipping whole cycles calls the functions for each of them, and
+        // the functions can add animations.
+        
+        Aut::AnimManager<float, Aut::LinearEase> growingManager;
+        index = growingManager.add(anims[2], Anim::PingPongAfterEnd);
+        segmentEnds.clear();
+        ends.clear();
+        growingManager.setSegmentEndFunction(index, [&](size_t anim, size_t segment)
+        {
+            segmentEnds.push_back(std::make_pair(anim, segment));
+            growingManager.add(anims[3]);
+        });
+        growingManager.setEndFunction(index, [&](size_t anim)
+        {
+            ends.push_back(anim);
+            growingManager.add(anims[3]);
+        });
+        growingManager.start(index, t0);
+        growingManager.eval(t0 + std::chrono::milliseconds(100));
+        growingManager.eval(t0 + std::chrono::milliseconds(10500));
+        assert (ends.size() == 3);
+        assert (segmentEnds.size() == 10);
+        const size_t order[] = { 0, 1, 2, 2, 1, 0, 0, 1, 2, 2 };
+        for (size_t i = 0; i < segmentEnds.size(); i++)
+            assert (segmentEnds[i] == std::make_pair(index, order[i]));
+        assert (growingManager.size() == 1 + ends.size() + segmentEnds.size());
+        
+        // The first evaluation after a start reports the boundaries passed
+        // since the start, whether the animation is still running or has
+        // stopped.
+        
+        Aut::AnimManager<float, Aut::LinearEase> lateManager;
+        size_t running = lateManager.add(anims[4]);
+        size_t stopping = lateManager.add(anims[5], Anim::StopAfterEnd);
+        segmentEnds.clear();
+        ends.clear();
+        for (size_t i : { running, stopping })
+        {
+            lateManager.setSegmentEndFunction(i, [&](size_t anim, size_t segment)
+                                              { segmentEnds.push_back(std::make_pair(anim, segment)); });
+            lateManager.setEndFunction(i, [&](size_t anim) { ends.push_back(anim); });
+        }
+        lateManager.start(running, t0);
+        lateManager.eval(t0 + std::chrono::milliseconds(1500));
+        assert ((segmentEnds.size() == 1) && (segmentEnds[0] == std::make_pair(running, size_t(0))));
+        assert (ends.empty());
+        segmentEnds.clear();
+        lateManager.stop(running);
+        lateManager.start(stopping, t0);
+        lateManager.eval(t0 + std::chrono::seconds(3));
+        assert (!lateManager.running(stopping));
+        assert (segmentEnds.size() == 3);
+        for (size_t i = 0; i < 3; i++)
+            assert (segmentEnds[i] == std::make_pair(stopping, i));
+        assert ((ends.size() == 1) && (ends[0] == stopping));
+        
+        // With simulated times, a starting time for the timer wheel at or
+        // before them keeps idle animations from being evaluated.
+        
+        float flatVal = -1.0f;
+        Anim flat;
+        flat.emplaceSegment(&flatVal, 0.0f, 0.0f, std::chrono::seconds(10));
+        std::chrono::steady_clock::time_point epoch;
+        Aut::AnimManager<float, Aut::LinearEase> simulated(std::chrono::milliseconds(1), epoch);
+        size_t flatIndex = simulated.add(flat);
+        simulated.start(flatIndex, epoch + std::chrono::seconds(1));
+        simulated.eval(epoch + std::chrono::seconds(1));
+        assert ((flatVal == 0.0f) && (simulated.active() == 0));
+        flatVal = 42.0f;
+        simulated.eval(epoch + std::chrono::seconds(2));
+        assert (flatVal == 42.0f);
+        simulated.eval(epoch + std::chrono::seconds(12));
+        assert (flatVal == 0.0f);
+        
+        std::cerr << "ok\n";
+    }
+    
+    void testClip()
+    {
+        std::cerr << "Starting Aut::testClip()\n";
+        
+        // Animations with a few kinds of easing are written as clips, and
+        // players reading the mapped file should produce the same values as
+        // the animations.
+        
+        float val = 0.0f;
+        Aut::Anim<float, Aut::CosineEase> anim0;
+        anim0.emplaceSegment(&val, 0.0f, 1.0f, std::chrono::seconds(1));
+        anim0.emplaceSegment(&val, 1.0f, 1.0f, std::chrono::seconds(2));
+        anim0.emplaceSegment(&val, 1.0f, -3.0f, std::chrono::seconds(1));
+        Aut::Anim<float, Aut::BezierEaseIn> anim1;
+        anim1.emplaceSegment(&val, 2.0f, 4.0f, std::chrono::seconds(3));
+        anim1.emplaceSegment(&val, 4.0f, 0.0f, std::chrono::seconds(0));
+        anim1.emplaceSegment(&val, 0.0f, 8.0f, std::chrono::seconds(2));
+        
+        Aut::ClipWriter<float> writer;
+        assert (writer.addClip(anim0) == 0);
+        assert (writer.addClip(anim1) == 1);
+        assert (writer.beginClip() == 2);
+        writer.addSegment(5.0f, 6.0f, std::chrono::milliseconds(250), Aut::ClipStep);
+        assert (writer.size() == 3);
+        assert (writer.clip(2).size() == 1);
+        assert (writer.clip(2).ease(0) == Aut::ClipStep);
+        
+        const char* dir = getenv("TMPDIR");
+        std::string path = std::string(dir ? dir : "/tmp") + "/AutTestClip.autc";
+        assert (writer.write(path));
+        
+        Aut::ClipFile<float> file(path);
+        assert (file.valid());
+        assert (file.size() == 3);
+        assert (file.clip(0).size() == 3);
+        assert (file.clip(0).duration() == std::chrono::seconds(4));
+        assert (file.clip(1).duration(1) == std::chrono::seconds(0));
+        assert (file.clip(1).ease(2) == Aut::ClipBezierIn);
+        assert (file.clip(2).value1(0) == 6.0f);
+        
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        float clipVal = 0.0f;
+        for (int i = 0; i < 2; i++)
+        {
+            Aut::ClipPlayer<float> player(&clipVal, file.clip(i));
+            player.start(t0);
+            if (i == 0)
+                anim0.start(t0);
+            else
+                anim1.start(t0);
+            
+            for (int ms = 0; ms < 12000; ms += 37)
+            {
+                std::chrono::steady_clock::time_point t = t0 + std::chrono::milliseconds(ms);
+                if (i == 0)
+                    anim0.eval(t);
+                else
+                    anim1.eval(t);
+                player.eval(t);
+                assert (fabsf(clipVal - val) < 1.0e-4f);
+            }
+            
+            player.eval(t0 + std::chrono::seconds(100), Aut::ClipPlayer<float>::StopAfterEnd);
+            assert (!player.running());
+            assert (clipVal == file.clip(i).value1(2));
+        }
+        
+        Aut::ClipPlayer<float> stepPlayer(&clipVal, file.clip(2));
+        stepPlayer.start(t0);
+        stepPlayer.eval(t0 + std::chrono::milliseconds(249));
+        assert (clipVal == 5.0f);
+        stepPlayer.eval(t0 + std::chrono::milliseconds(250), Aut::ClipPlayer<float>::StopAfterEnd);
+        assert (clipVal == 6.0f);
+        
+        // Files with the wrong type or no clips are reported as errors.
+        
+        int errors = 0;
+        std::function<void(const std::string&)> errorFunc = Aut::errorFunction();
+        Aut::setErrorFunction([&](const std::string&) { errors++; });
+        Aut::ClipFile<double> wrongType(path);
+        assert (!wrongType.valid());
+        assert (wrongType.size() == 0);
+        assert (errors == 1);
+        Aut::ClipFile<float> missing(path + ".missing");
+        assert (!missing.valid());
+        assert (errors == 2);
+        
+        // So are files whose segment times would send a player's binary
+        // search past the end of a clip.
+        
+        std::string bytes;
+        {
+            std::ifstream in(path.c_str(), std::ios::binary);
+            bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        size_t recordsOffset = sizeof(Aut::ClipFileHeader) + 3 * sizeof(Aut::ClipFileRange);
+        std::string corruptPath = path + ".corrupt";
+        int64_t badTimes[2][2] = { { -1, 0 }, { 0, 3000000000LL } };
+        for (int i = 0; i < 2; i++)
+        {
+            std::string corrupt = bytes;
+            Aut::ClipRecord<float> record;
+            size_t offset = recordsOffset + sizeof(record);
+            memcpy(&record, &corrupt[offset], sizeof(record));
+            record.duration += badTimes[i][0];
+            record.end += badTimes[i][1];
+            memcpy(&corrupt[offset], &record, sizeof(record));
+            std::ofstream out(corruptPath.c_str(), std::ios::binary);
+            out.write(corrupt.data(), corrupt.size());
+            out.close();
+        
+            Aut::ClipFile<float> corruptFile(corruptPath);
+            assert (!corruptFile.valid());
+            assert (corruptFile.size() == 0);
+            assert (errors == 3 + i);
+        }
+        Aut::setErrorFunction(errorFunc);
+        
+        remove(corruptPath.c_str());
+        remove(path.c_str());
+        
+        std::cerr << "ok\n";
+    }
+    
+    void testVec()
+    {
+        std::cerr << "Starting Aut::testVec()\n";
+        
+        Aut::Vec<3> a = { 1.0f, 2.0f, 3.0f };
+        Aut::Vec<3> b = { 3.0f, 2.0f, -1.0f };
+        assert ((a + b) == Aut::Vec<3>({ 4.0f, 4.0f, 2.0f }));
+        assert ((b - a) == Aut::Vec<3>({ 2.0f, 0.0f, -4.0f }));
+        assert ((2.0f * a) == (a * 2.0f));
+        assert ((2.0f * a)[2] == 6.0f);
+        assert (a != b);
+        assert (Aut::dot(a, b) == 4.0f);
+        
+        // Vectors and quaternions animate like floats, with the quaternions
+        // staying unit length and taking the shorter arc.
+        
+        Aut::Vec<3> pos;
+        Aut::Quat rot;
+        Aut::Anim<Aut::Vec<3>, Aut::LinearEase> posAnim;
+        posAnim.emplaceSegment(&pos, a, b, std::chrono::seconds(2));
+        Aut::Quat q0 = Aut::Quat::axisAngle(0.0f, 0.0f, 1.0f, 0.0f);
+        Aut::Quat q1 = Aut::Quat::axisAngle(0.0f, 0.0f, 1.0f, float(M_PI) / 2.0f);
+        Aut::Anim<Aut::Quat, Aut::LinearEase> rotAnim;
+        rotAnim.emplaceSegment(&rot, q0, q1, std::chrono::seconds(2));
+        
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        posAnim.start(t0);
+        rotAnim.start(t0);
+        posAnim.eval(t0 + std::chrono::seconds(1));
+        rotAnim.eval(t0 + std::chrono::seconds(1));
+        assert (pos == Aut::Vec<3>({ 2.0f, 2.0f, 1.0f }));
+        Aut::Quat half = Aut::Quat::axisAngle(0.0f, 0.0f, 1.0f, float(M_PI) / 4.0f);
+        assert (fabsf(Aut::dot(rot, half) - 1.0f) < 1.0e-6f);
+        
+        Aut::Quat q1Negated(-q1.x, -q1.y, -q1.z, -q1.w);
+        Aut::Quat n = Aut::nlerp(q0, q1Negated, 0.5f);
+        assert (fabsf(fabsf(Aut::dot(n, half)) - 1.0f) < 1.0e-6f);
+        
+        for (int i = 0; i <= 10; i++)
+        {
+            float t = i / 10.0f;
+            Aut::Quat s = Aut::slerp(q0, q1, t);
+            Aut::Quat expected = Aut::Quat::axisAngle(0.0f, 0.0f, 1.0f, t * float(M_PI) / 2.0f);
+            assert (fabsf(Aut::dot(s, expected) - 1.0f) < 1.0e-6f);
+            Aut::Quat l = Aut::nlerp(q0, q1, t);
+            assert (fabsf(Aut::dot(l, l) - 1.0f) < 1.0e-6f);
+        }
+        
+        // The other animation classes handle the types too.
+        
+        Aut::Vec<4> color;
+        Aut::AnimSystem<Aut::Vec<4>, Aut::LinearEase> system;
+        std::vector<Aut::Anim<Aut::Vec<4>, Aut::LinearEase>::Segment> segments;
+        segments.push_back(Aut::Anim<Aut::Vec<4>, Aut::LinearEase>::
+                           Segment(&color, Aut::Vec<4>(), Aut::Vec<4>({ 1.0f, 0.5f, 0.25f, 1.0f }),
+                                   std::chrono::seconds(4)));
+        system.start(system.add(segments), t0);
+        system.eval(t0 + std::chrono::seconds(1));
+        assert (color == Aut::Vec<4>({ 0.25f, 0.125f, 0.0625f, 0.25f }));
+        
+        Aut::ClipWriter<Aut::Quat> writer;
+        writer.addClip(rotAnim);
+        Aut::Quat clipRot;
+        Aut::ClipPlayer<Aut::Quat> player(&clipRot, writer.clip(0));
+        player.start(t0);
+        player.eval(t0 + std::chrono::seconds(1));
+        assert (fabsf(Aut::dot(clipRot, half) - 1.0f) < 1.0e-6f);
+        
+        std::cerr << "ok\n";
+    }
+    
+    void testBakedAnim()
+    {
+        std::cerr << "Starting Aut::testBakedAnim()\n";
+        
+        // A baked animation should stay close to the original, and dropping
+        // samples should keep it within the tolerance while keeping only a
+        // few samples for the stretch that does not change.
+        
+        float val = 0.0f, bakedVal = 0.0f;
+        Aut::Anim<float, Aut::CosineEase> anim;
+        anim.emplaceSegment(&val, 0.0f, 10.0f, std::chrono::seconds(2));
+        anim.emplaceSegment(&val, 10.0f, 10.0f, std::chrono::seconds(5));
+        anim.emplaceSegment(&val, 10.0f, -4.0f, std::chrono::seconds(1));
+        
+        Aut::BakedAnim<float> full = anim.bake(100.0f);
+        assert (full.size() == 801);
+        assert (full.duration() == std::chrono::seconds(8));
+        assert (full.variable() == &val);
+        Aut::BakedAnim<float> reduced = anim.bake(100.0f, 0.01f);
+        assert (reduced.size() < 200);
+        
+        full.setVariable(&bakedVal);
+        reduced.setVariable(&bakedVal);
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        anim.start(t0);
+        full.start(t0);
+        reduced.start(t0);
+        for (int ms = 0; ms < 20000; ms += 7)
+        {
+            std::chrono::steady_clock::time_point t = t0 + std::chrono::milliseconds(ms);
+            anim.eval(t, Aut::Anim<float, Aut::CosineEase>::PingPongAfterEnd);
+            full.eval(t, Aut::BakedAnim<float>::PingPongAfterEnd);
+            assert (fabsf(bakedVal - val) < 0.01f);
+            reduced.eval(t, Aut::BakedAnim<float>::PingPongAfterEnd);
+            assert (fabsf(bakedVal - val) < 0.02f);
+        }
+        
+        anim.eval(t0 + std::chrono::seconds(100), Aut::Anim<float, Aut::CosineEase>::StopAfterEnd);
+        full.eval(t0 + std::chrono::seconds(100), Aut::BakedAnim<float>::StopAfterEnd);
+        assert (!full.running());
+        assert (bakedVal == -4.0f);
+        assert (bakedVal == val);
+        
+        // Vectors are baked in the same way.
+        
+        Aut::Vec<3> pos;
+        Aut::Anim<Aut::Vec<3>, Aut::LinearEase> posAnim;
+        posAnim.emplaceSegment(&pos, Aut::Vec<3>(), Aut::Vec<3>({ 3.0f, 0.0f, -3.0f }), std::chrono::seconds(3));
+        Aut::BakedAnim<Aut::Vec<3>> posBaked = posAnim.bake(60.0f, 0.001f);
+        assert (posBaked.size() == 2);
+        posBaked.start(t0);
+        posBaked.eval(t0 + std::chrono::seconds(1));
+        assert (Aut::AnimTraits<Aut::Vec<3>>::distance(pos, Aut::Vec<3>({ 1.0f, 0.0f, -1.0f })) < 1.0e-5f);
+        
+        // A long linear stretch is reduced to its ends, and a moved-from
+        // baked animation is empty.
+        
+        float x = 0.0f;
+        Aut::Anim<float, Aut::LinearEase> line;
+        line.emplaceSegment(&x, 0.0f, 1000.0f, std::chrono::seconds(1000));
+        Aut::BakedAnim<float> lineBaked = line.bake(1000.0f, 0.001f);
+        assert (lineBaked.size() == 2);
+        Aut::BakedAnim<float> moved(std::move(lineBaked));
+        assert (moved.size() == 2);
+        assert ((lineBaked.size() == 0) && (lineBaked.variable() == nullptr));
+        assert (lineBaked.duration() == std::chrono::steady_clock::duration::zero());
+        lineBaked.start(t0);
+        lineBaked.eval(t0 + std::chrono::seconds(1));
+        assert (!lineBaked.running());
+        lineBaked = std::move(moved);
+        assert ((lineBaked.size() == 2) && (moved.size() == 0));
+        
+        std::cerr << "ok\n";
+    }
+    
+    void testTimeline()
+    {
+        std::cerr << "Starting Aut::testTimeline()\n";
+        
+        typedef Aut::Timeline TL;
+        float x = -1.0f, y = -1.0f, z = -1.0f;
+        std::vector<char> calls;
+        TL::Step script = TL::sequence({
+            TL::animate(&x, 0.0f, 10.0f, std::chrono::seconds(1)),
+            TL::call([&] { assert (x == 10.0f); calls.push_back('a'); }),
+            TL::parallel({
+                TL::animate(&y, 0.0f, 1.0f, std::chrono::seconds(2)),
+                TL::sequence({
+                    TL::delay(std::chrono::milliseconds(500)),
+                    TL::animate<Aut::LinearEase>(&z, 0.0f, 4.0f, std::chrono::seconds(1))
+                })
+            }),
+            TL::call([&] { calls.push_back('b'); })
+        });
+        assert (script.duration() == std::chrono::seconds(3));
+        
+        TL timeline;
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        size_t index = timeline.play(script, t0);
+        assert (timeline.playing(index));
+        assert (timeline.size() == 1);
+        
+        timeline.eval(t0);
+        assert (x == 0.0f);
+        assert (timeline.active() == 1);
+        timeline.eval(t0 + std::chrono::milliseconds(500));
+        assert (fabsf(x - 5.0f) < 1.0e-5f);
+        
+        timeline.eval(t0 + std::chrono::milliseconds(1250));
+        assert (calls.size() == 1);
+        assert (timeline.active() == 1);
+        assert (y > 0.0f);
+        assert (z == -1.0f);
+        
+        timeline.eval(t0 + std::chrono::seconds(2));
+        assert (timeline.active() == 2);
+        assert (z == 2.0f);
+        
+        timeline.eval(t0 + std::chrono::seconds(5));
+        assert ((y == 1.0f) && (z == 4.0f));
+        assert ((calls.size() == 2) && (calls[1] == 'b'));
+        assert (!timeline.playing(index));
+        assert (timeline.size() == 0);
+        assert (timeline.active() == 0);
+        
+        // Scripts waiting to begin animating are not evaluated, and a script
+        // can stop itself.
+        
+        std::vector<float> vals(1000, -1.0f);
+        for (size_t i = 0; i < vals.size(); i++)
+        {
+            timeline.play(TL::sequence({ TL::delay(std::chrono::seconds(10 + i % 7)),
+                                         TL::animate(&vals[i], 0.0f, 1.0f, std::chrono::seconds(1)) }),
+                          t0);
+        }
+        timeline.eval(t0 + std::chrono::seconds(5));
+        assert (timeline.size() == vals.size());
+        assert (timeline.active() == 0);
+        timeline.eval(t0 + std::chrono::milliseconds(10500));
+        assert (timeline.active() == 143);
+        timeline.eval(t0 + std::chrono::seconds(20));
+        assert (timeline.size() == 0);
+        for (float val : vals)
+            assert (val == 1.0f);
+        
+        x = -1.0f;
+        size_t self = 0;
+        self = timeline.play(TL::sequence({ TL::call([&] { timeline.stop(self); }),
+                                            TL::animate(&x, 0.0f, 1.0f, std::chrono::seconds(1)) }), t0);
+        timeline.eval(t0 + std::chrono::milliseconds(500));
+        assert (!timeline.playing(self));
+        assert (x == -1.0f);
+        
+        // Finished scripts' storage is reused, but a finished script's index
+        // stays stale.
+        
+        TL reusing;
+        std::vector<size_t> finished;
+        for (int i = 0; i < 10000; i++)
+        {
+            size_t a = reusing.play(TL::animate(&x, 0.0f, 1.0f, std::chrono::seconds(1)), t0);
+            size_t b = reusing.play(TL::delay(std::chrono::seconds(2)), t0);
+            reusing.stop(a);
+            reusing.eval(t0 + std::chrono::seconds(3));
+            assert (!reusing.playing(a) && !reusing.playing(b));
+            if (i < 10)
+            {
+                finished.push_back(a);
+                finished.push_back(b);
+            }
+        }
+        assert (reusing.capacity() == 2);
+        size_t next = reusing.play(TL::delay(std::chrono::seconds(1)), t0);
+        for (size_t index : finished)
+        {
+            assert ((index != next) && !reusing.playing(index));
+            reusing.stop(index);
+        }
+        assert (reusing.playing(next));
+        reusing.eval(t0 + std::chrono::seconds(2));
+        assert (!reusing.playing(next) && (reusing.size() == 0));
+        
+        // A script that stops itself and plays another in its storage does
+        // not run on.
+        
+        x = -1.0f;
+        size_t first = 0, second = 0;
+        first = reusing.play(TL::sequence({ TL::call([&] {
+            reusing.stop(first);
+            second = reusing.play(TL::animate(&y, 0.0f, 1.0f, std::chrono::seconds(1)), t0);
+        }), TL::animate(&x, 0.0f, 1.0f, std::chrono::seconds(1)) }), t0);
+        reusing.eval(t0 + std::chrono::milliseconds(500));
+        assert (!reusing.playing(first) && reusing.playing(second));
+        assert ((x == -1.0f) && (fabsf(y - 0.5f) < 1.0e-5f));
+        assert ((reusing.size() == 1) && (reusing.active() == 1) && (reusing.capacity() == 2));
+        
+        std::cerr << "ok\n";
+    }
+    
+    void testAnimBlend()
+    {
+        std::cerr << "Starting Aut::testAnimBlend()\n";
+        
+        typedef Aut::Anim<float, Aut::LinearEase> A;
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        
+        // The layers' segments need no variables.
+        
+        A base, wobble, pose;
+        base.emplaceSegment(nullptr, 0.0f, 10.0f, std::chrono::seconds(1));
+        wobble.emplaceSegment(nullptr, 0.0f, 2.0f, std::chrono::seconds(1));
+        pose.emplaceSegment(nullptr, 100.0f, 100.0f, std::chrono::seconds(1));
+        
+        float x = -1.0f, y = -1.0f;
+        typedef Aut::AnimBlend<float, Aut::LinearEase> B;
+        B blend;
+        size_t tx = blend.addTarget(&x, 1.0f);
+        size_t ty = blend.addTarget(&y);
+        assert (blend.targets() == 2);
+        
+        // Adding the layers out of target order is allowed.
+        
+        blend.addLayer(ty, wobble, B::Additive);
+        size_t lBase = blend.addLayer(tx, base);
+        size_t lWobble = blend.addLayer(tx, wobble, B::Additive, 0.5f);
+        size_t lPose = blend.addLayer(tx, pose, B::Override, 0.0f);
+        assert (blend.layers() == 4);
+        assert (blend.weight(lWobble) == 0.5f);
+        
+        // Layers whose animations have not been evaluated do not contribute.
+        
+        blend.eval(t0);
+        assert ((x == 1.0f) && (y == 0.0f));
+        
+        base.start(t0);
+        wobble.start(t0);
+        blend.eval(t0 + std::chrono::milliseconds(500));
+        assert (fabsf(x - 5.5f) < 1.0e-5f);
+        assert (fabsf(y - 1.0f) < 1.0e-5f);
+        
+        pose.start(t0);
+        blend.setWeight(lPose, 0.25f);
+        blend.eval(t0 + std::chrono::milliseconds(500));
+        assert (fabsf(x - (5.5f + 0.25f * (100.0f - 5.5f))) < 1.0e-4f);
+        
+        // A stopped layer keeps contributing its last value.
+        
+        blend.setWeight(lPose, 0.0f);
+        base.stop();
+        blend.eval(t0 + std::chrono::milliseconds(750));
+        assert (fabsf(x - 5.75f) < 1.0e-5f);
+        
+        blend.setBase(tx, 0.0f);
+        blend.setWeight(lBase, 0.5f);
+        blend.eval(t0 + std::chrono::milliseconds(750));
+        assert (blend.base(tx) == 0.0f);
+        assert (fabsf(x - 3.25f) < 1.0e-5f);
+        
+        // Additive rotations compose.
+        
+        Aut::Anim<Aut::Quat> turn;
+        Aut::Quat q0 = Aut::Quat::axisAngle(0.0f, 0.0f, 1.0f, 1.0f);
+        turn.emplaceSegment(nullptr, Aut::Quat(), Aut::Quat::axisAngle(0.0f, 0.0f, 1.0f, 0.5f),
+                            std::chrono::seconds(1));
+        Aut::Quat q;
+        Aut::AnimBlend<Aut::Quat> qBlend;
+        qBlend.addLayer(qBlend.addTarget(&q, q0), turn, Aut::AnimBlend<Aut::Quat>::Additive);
+        turn.start(t0);
+        qBlend.eval(t0 + std::chrono::seconds(2), Aut::Anim<Aut::Quat>::StopAfterEnd);
+        Aut::Quat expected = Aut::Quat::axisAngle(0.0f, 0.0f, 1.0f, 1.5f);
+        assert (fabsf(fabsf(Aut::dot(q, expected)) - 1.0f) < 1.0e-5f);
+        
+        std::cerr << "ok\n";
+    }
+    
+    void testAnimOutputs()
+    {
+        std::cerr << "Starting Aut::testAnimOutputs()\n";
+        
+        Aut::AnimOutputs<float> outputs;
+        typedef Aut::AnimOutputs<float>::Handle H;
+        H a = outputs.add(1.0f);
+        H b = outputs.add(2.0f);
+        H c = outputs.add(3.0f);
+        assert (outputs.size() == 3);
+        assert (!outputs.valid(H()));
+        assert (outputs.find(H()) == 0);
+        
+        // Removing a value keeps the array dense and the other handles valid,
+        // and a removed value's handle stays invalid when its id is reused.
+        
+        outputs.remove(a);
+        assert (!outputs.valid(a));
+        assert (outputs.size() == 2);
+        assert ((outputs[b] == 2.0f) && (outputs[c] == 3.0f));
+        assert ((outputs.index(c) == 0) && (outputs.data()[0] == 3.0f));
+        H d = outputs.add(4.0f);
+        assert (!outputs.valid(a) && outputs.valid(d));
+        assert (outputs[d] == 4.0f);
+        outputs.remove(a);
+        assert (outputs.size() == 3);
+        
+        // Animations bound to handles write into the array, not through their
+        // segments' variables.
+        
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        Aut::Anim<float, Aut::LinearEase> anim0, anim1;
+        anim0.emplaceSegment(nullptr, 0.0f, 10.0f, std::chrono::seconds(1));
+        anim1.emplaceSegment(nullptr, 0.0f, 20.0f, std::chrono::seconds(1));
+        anim0.bind(outputs, b);
+        anim1.bind(outputs, d);
+        anim0.start(t0);
+        anim1.start(t0);
+        anim0.eval(t0 + std::chrono::milliseconds(500));
+        anim1.eval(t0 + std::chrono::milliseconds(500));
+        assert (outputs[b] == 5.0f);
+        assert (outputs[d] == 10.0f);
+        
+        outputs.remove(c);
+        anim0.eval(t0 + std::chrono::milliseconds(750));
+        anim1.eval(t0 + std::chrono::seconds(2), Aut::Anim<float, Aut::LinearEase>::StopAfterEnd);
+        assert (outputs[b] == 7.5f);
+        assert (outputs[d] == 20.0f);
+        float sum = 0.0f;
+        for (size_t i = 0; i < outputs.size(); i++)
+            sum += outputs.data()[i];
+        assert (sum == 27.5f);
+        
+        // Nothing is written for a removed value, or through 0 variables.
+        
+        outputs.remove(b);
+        anim0.eval(t0 + std::chrono::milliseconds(900));
+        assert (outputs.size() == 1);
+        float x = -1.0f;
+        anim0.set({ Aut::Anim<float, Aut::LinearEase>::Segment(&x, 0.0f, 10.0f, std::chrono::seconds(1)) });
+        anim0.unbind();
+        anim0.start(t0);
+        anim0.eval(t0 + std::chrono::milliseconds(100));
+        assert (x == 1.0f);
+        
+        std::cerr << "ok\n";
+    }
+    
+    void testConcurrentRunningAverage()
+    {
+        std::cerr << "Starting Aut::testConcurrentRunningAverage()\n";
+        
+        typedef std::chrono::milliseconds ms;
+        ConcurrentRunningAverage<float, TestClock> avg(3, ms(750));
+        assert (avg.capacity() == 3);
+        assert (avg.window() == ms(750));
+        assert (avg() == 0.0f);
+        
+        // With one thread, it behaves like Aut::RunningAverage.
+        
+        TestClock::ms = 0;
+        for (int i = 1; i <= 5; i++)
+            avg.add(float(i));
+        assert (avg() == 4.0f);
+        avg.setCapacity(2);
+        assert (avg() == 4.5f);
+        avg.setCapacity(4);
+        avg.add(6.0f);
+        assert (avg() == 5.0f);
+        
+        TestClock::ms = 1000;
+        avg.add(12.0f);
+        assert (avg() == 12.0f);
+        
+        // Each value expires on its own once it is older than the window.
+        
+        ConcurrentRunningAverage<float, TestClock> timed(4, ms(100));
+        timed.add(1.0f, TestClock::time_point(ms(1000)));
+        timed.add(2.0f, TestClock::time_point(ms(1050)));
+        timed.add(3.0f, TestClock::time_point(ms(1080)));
+        assert (timed() == 2.0f);
+        timed.add(6.0f, TestClock::time_point(ms(1120)));
+        assert (timed() == 11.0f / 3.0f);
+        timed.add(7.0f, TestClock::time_point(ms(1185)));
+        assert (timed() == 6.5f);
+        timed.setCapacity(3);
+        assert (timed() == 6.5f);
+        timed.add(8.0f, TestClock::time_point(ms(1250)));
+        assert (timed() == 7.5f);
+        timed.add(9.0f, TestClock::time_point(ms(1500)));
+        assert (timed() == 9.0f);
+        
+        // Dropping a value that dwarfs the others leaves no rounding error
+        // behind, however many values are added after it.
+        
+        ConcurrentRunningAverage<float> big(2, std::chrono::hours(1));
+        big.add(1.0e8f);
+        for (int i = 0; i < 1000; i++)
+        {
+            big.add(1.0f);
+            if (i > 0)
+                assert (big() == 1.0f);
+        }
+        
+        // With several threads adding values between 1 and 4, a thread
+        // reading at the same time always gets an average in that range,
+        // including when values expire as soon as they are added.
+        
+        for (ms window : { ms(3600000), ms(0) })
+        {
+            ConcurrentRunningAverage<float> shared(64, window);
+            std::atomic<bool> done(false);
+            std::atomic<size_t> reads(0);
+            std::thread reader([&]
+            {
+                while (!done)
+                {
+                    float a = shared();
+                    assert ((a == 0.0f) || ((a >= 1.0f) && (a <= 4.0f)));
+                    reads++;
+                }
+            });
+            std::vector<std::thread> producers;
+            for (int p = 1; p <= 4; p++)
+            {
+                producers.push_back(std::thread([&shared, p]
+                {
+                    for (int i = 0; i < 100000; i++)
+                        shared.add(float(p));
+                }));
+            }
+            for (std::thread& producer : producers)
+                producer.join();
+            done = true;
+            reader.join();
+            assert (reads > 0);
+            
+            // Once the adding stops, the average is that of the last values.
+            
+            for (int i = 0; i < 64; i++)
+                shared.add(2.0f);
+            assert ((shared() == 2.0f) || (window == ms(0)));
+        }
+        
+        std::cerr << "ok\n";
+    }
+    
+    void testRunningAverageTable()
+    {
+        std::cerr << "Starting Aut::testRunningAverageTable()\n";
+        
+        typedef std::chrono::milliseconds ms;
+        RunningAverageTable<int, float> table(3, ms(750));
+        assert (table.capacity() == 3);
+        assert (table.window() == ms(750));
+        assert (table.size() == 0);
+        assert (table(7) == 0.0f);
+        
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        for (int i = 1; i <= 5; i++)
+        {
+            table.add(7, float(i), t0);
+            table.add(8, float(10 * i), t0);
+        }
+        assert (table.size() == 2);
+        assert (table(7) == 4.0f);
+        assert (table(8) == 40.0f);
+        assert (table.contains(7) && !table.contains(9));
+        
+        // A value added after the time window resets the stream's average.
+        
+        table.add(7, 12.0f, t0 + ms(1000));
+        assert (table(7) == 12.0f);
+        assert (table(8) == 40.0f);
+        
+        // Many streams, added in batches, some of which then expire.
+        
+        std::vector<int> keys;
+        std::vector<float> values;
+        for (int k = 0; k < 100000; k++)
+        {
+            keys.push_back(k * 16);
+            values.push_back(float(k % 100));
+        }
+        table.add(keys, values, t0 + ms(1000));
+        for (size_t i = 0; i < keys.size(); i++)
+            values[i] += 2.0f;
+        table.add(keys, values, t0 + ms(1100));
+        assert (table.size() == keys.size() + 2);
+        for (int k = 0; k < 100000; k += 997)
+            assert (table(k * 16) == float(k % 100) + 1.0f);
+        
+        for (int k = 0; k < 50000; k++)
+            table.add(k * 16, 0.0f, t0 + ms(1500));
+        assert (table.expire(t0 + ms(2000)) == 50002);
+        assert (table.size() == 50000);
+        for (int k = 0; k < 100000; k++)
+            assert (table.contains(k * 16) == (k < 50000));
+        assert (table(16) == 4.0f / 3.0f);
+        
+        table.remove(0);
+        table.remove(0);
+        assert (!table.contains(0) && table.contains(16));
+        assert (table.size() == 49999);
+        
+        // Strings work as keys too.
+        
+        RunningAverageTable<std::string, double> names;
+        names.add("left", 1.0);
+        names.add("right", 2.0);
+        names.add("left", 3.0);
+        assert ((names("left") == 2.0) && (names("right") == 2.0));
+        
+        std::cerr << "ok\n";
+    }
+    
+    void testRunningStats()
+    {
+        std::cerr << "Starting Aut::testRunningStats()\n";
+        
+        typedef std::chrono::milliseconds ms;
+        RunningStats<double, TestClock> stats(4, ms(100), 0.5);
+        assert (stats.capacity() == 4);
+        assert (stats.window() == ms(100));
+        assert (stats.ewmaWeight() == 0.5);
+        assert ((stats.size() == 0) && (stats.mean() == 0.0) && (stats.variance() == 0.0));
+        assert ((stats.min() == 0.0) && (stats.max() == 0.0) && (stats.ewma() == 0.0));
+        
+        TestClock::ms = 0;
+        stats.add(2.0);
+        assert ((stats.mean() == 2.0) && (stats.variance() == 0.0));
+        assert ((stats.min() == 2.0) && (stats.max() == 2.0) && (stats.ewma() == 2.0));
+        stats.add(4.0);
+        stats.add(9.0);
+        assert (stats.mean() == 5.0);
+        assert (fabs(stats.variance() - 13.0) < 1.0e-12);
+        assert ((stats.min() == 2.0) && (stats.max() == 9.0));
+        assert (stats.ewma() == 6.0);
+        
+        // Dropping values by capacity and by time updates every statistic.
+        
+        stats.add(1.0);
+        stats.add(5.0);
+        assert (stats.size() == 4);
+        assert (stats.mean() == 19.0 / 4.0);
+        assert ((stats.min() == 1.0) && (stats.max() == 9.0));
+        stats.add(3.0, TestClock::time_point(ms(50)));
+        assert ((stats.min() == 1.0) && (stats.max() == 9.0));
+        stats.add(0.0, TestClock::time_point(ms(50)));
+        assert ((stats.min() == 0.0) && (stats.max() == 5.0));
+        stats.add(6.0, TestClock::time_point(ms(120)));
+        assert (stats.size() == 3);
+        assert ((stats.mean() == 3.0) && (fabs(stats.variance() - 9.0) < 1.0e-12));
+        assert ((stats.min() == 0.0) && (stats.max() == 6.0));
+        stats.add(7.0, TestClock::time_point(ms(500)));
+        assert ((stats.size() == 1) && (stats.ewma() == 7.0));
+        
+        // Dropping an outlier leaves no cancellation error in the mean and
+        // the variance.
+        
+        RunningStats<float, TestClock> outlier(2, ms(1000000));
+        outlier.add(1.0e8f);
+        for (int i = 0; i < 4; i++)
+            outlier.add(1.0f);
+        assert ((outlier.mean() == 1.0f) && (outlier.variance() == 0.0f));
+        RunningStats<double, TestClock> outliers(3, ms(1000000));
+        outliers.add(1.0e8);
+        outliers.add(1.0e16);
+        outliers.add(1.0);
+        outliers.add(2.0);
+        outliers.add(3.0);
+        assert ((outliers.mean() == 2.0) && (outliers.variance() == 1.0));
+        RunningStats<float, TestClock> centered(3, ms(1000000));
+        centered.add(-1.0e8f);
+        centered.add(-1.0f);
+        centered.add(1.0f);
+        centered.add(0.0f);
+        assert ((centered.mean() == 0.0f) && (centered.variance() == 1.0f));
+        
+        // The moving average keeps the values dropped for the capacity.
+        
+        RunningStats<double, TestClock> single(1, ms(100), 0.5);
+        TestClock::ms = 0;
+        single.add(2.0);
+        single.add(4.0);
+        single.add(8.0);
+        assert ((single.mean() == 8.0) && (single.ewma() == 5.5));
+        TestClock::ms = 200;
+        single.add(1.0);
+        assert (single.ewma() == 1.0);
+        single.setCapacity(2);
+        assert (single.ewma() == 1.0);
+        
+        // The statistics match those computed directly from the values.
+        
+        RunningStats<double, TestClock> random(50, ms(1000000));
+        std::vector<double> values;
+        TestRandom draw;
+        for (int i = 0; i < 10000; i++)
+        {
+            double x = draw.uniform() * 100.0;
+            random.add(x);
+            values.push_back(x);
+            if (values.size() > 50)
+                values.erase(values.begin());
+        }
+        double sum = 0.0, lo = values[0], hi = values[0];
+        for (double x : values)
+        {
+            sum += x;
+            lo = std::min(lo, x);
+            hi = std::max(hi, x);
+        }
+        double mean = sum / values.size(), m2 = 0.0;
+        for (double x : values)
+            m2 += (x - mean) * (x - mean);
+        assert (fabs(random.mean() - mean) < 1.0e-9);
+        assert (fabs(random.variance() - m2 / (values.size() - 1)) < 1.0e-7);
+        assert ((random.min() == lo) && (random.max() == hi));
+        
+        random.setCapacity(10);
+        assert (random.size() == 10);
+        assert (random.max() == *std::max_element(values.end() - 10, values.end()));
+        
+        std::cerr << "ok\n";
+    }
+    
+    void testRunningQuantile()
+    {
+        std::cerr << "Starting Aut::testRunningQuantile()\n";
+        
+        typedef std::chrono::milliseconds ms;
+        RunningQuantile<double, TestClock> quantile(1000, ms(100), 0.01);
+        assert (quantile.capacity() == 1000);
+        assert (quantile.window() == ms(100));
+        assert (quantile.relativeError() == 0.01);
+        assert ((quantile.size() == 0) && (quantile.median() == 0.0));
+        
+        // The estimates are within the relative error of the exact
+        // quantiles, for values of both signs and widely varying magnitudes,
+        // including outliers.
+        
+        TestClock::ms = 0;
+        std::vector<double> values;
+        TestRandom draw;
+        for (int i = 0; i < 20000; i++)
+        {
+            double x = exp(draw.uniform() * 20.0 - 10.0);
+            if (i % 5 == 0)
+                x = -x;
+            if (i % 97 == 0)
+                x *= 1.0e6;
+            if (i % 89 == 0)
+                x = 0.0;
+            quantile.add(x);
+            values.push_back(x);
+        }
+        values.erase(values.begin(), values.end() - 1000);
+        std::sort(values.begin(), values.end());
+        assert (quantile.size() == 1000);
+        for (double q : { 0.0, 0.01, 0.25, 0.5, 0.9, 0.99, 1.0 })
+        {
+            double exact = values[size_t(floor(q * (values.size() - 1)))];
+            assert (fabs(quantile.quantile(q) - exact) <= 0.01 * fabs(exact) * (1.0 + 1.0e-9));
+        }
+        
+        // Values expire by capacity and by time.
+        
+        RunningQuantile<float, TestClock> small(3, ms(100));
+        small.add(1.0f, TestClock::time_point(ms(0)));
+        small.add(100.0f, TestClock::time_point(ms(10)));
+        small.add(10.0f, TestClock::time_point(ms(20)));
+        assert (fabsf(small.median() - 10.0f) <= 0.1f);
+        small.add(1000.0f, TestClock::time_point(ms(30)));
+        assert (fabsf(small.median() - 100.0f) <= 1.0f);
+        assert (fabsf(small.quantile(0.0) - 10.0f) <= 0.1f);
+        small.add(5.0f, TestClock::time_point(ms(125)));
+        assert (small.size() == 2);
+        assert (fabsf(small.quantile(0.0) - 5.0f) <= 0.05f);
+        assert (fabsf(small.quantile(1.0) - 1000.0f) <= 10.0f);
+        small.setCapacity(1);
+        assert (fabsf(small.median() - 5.0f) <= 0.05f);
+        
+        // A relative error outside the supported range is reported and
+        // clamped.
+        
+        int errors = 0;
+        std::function<void(const std::string&)> errorFunc = Aut::errorFunction();
+        Aut::setErrorFunction([&](const std::string&) { errors++; });
+        RunningQuantile<float, TestClock> exact(10, ms(100), 0.0);
+        assert ((errors == 1) && (exact.relativeError() == 1.0e-4));
+        RunningQuantile<float, TestClock> coarse(10, ms(100), 1.0);
+        assert ((errors == 2) && (coarse.relativeError() == 0.5));
+        RunningQuantile<float, TestClock> undefined(10, ms(100), nan(""));
+        assert ((errors == 3) && (undefined.relativeError() == 1.0e-4));
+        Aut::setErrorFunction(errorFunc);
+        exact.add(-1.0e30f, TestClock::time_point(ms(0)));
+        exact.add(3.0f, TestClock::time_point(ms(0)));
+        exact.add(1.0e30f, TestClock::time_point(ms(0)));
+        assert (fabsf(exact.median() - 3.0f) <= 3.0e-4f);
+        coarse.add(3.0f, TestClock::time_point(ms(0)));
+        assert (fabsf(coarse.median() - 3.0f) <= 1.5f);
+        
+        std::cerr << "ok\n";
+    }
+    
+    void testRollupAverage()
+    {
+        std::cerr << "Starting Aut::testRollupAverage()\n";
+        
+        typedef std::chrono::milliseconds ms;
+        typedef TestClock::time_point tp;
+        RollupAverage<double, TestClock> rollup(ms(10), std::chrono::hours(1), 8);
+        assert (rollup.resolution() == ms(10));
+        assert (rollup.longestWindow() == std::chrono::hours(1));
+        assert (rollup.bucketsPerLevel() == 8);
+        assert (rollup.levels() == 17);
+        assert ((rollup.average(ms(100)) == 0.0) && (rollup.count(ms(100)) == 0.0));
+        
+        // Two hours of values added a thousand times a second, the same as
+        // the exact statistics within the newest bucket and close to them
+        // for longer windows.
+        
+        const int n = 2 * 3600 * 1000;
+        std::vector<double> values;
+        values.reserve(n);
+        for (int i = 0; i < n; i++)
+        {
+            double x = (i / 1000) % 60 + i % 7;
+            if (i == n - 30000)
+                x = 1000.0;
+            rollup.add(x, tp(ms(i)));
+            values.push_back(x);
+        }
+        for (int window : { 5, 9, 10, 25, 1000, 1234, 20000, 60000, 77777, 600000, 3600000 })
+        {
+            double sum = 0.0, lo = values.back(), hi = values.back();
+            for (int i = n - 1 - window; i < n; i++)
+            {
+                sum += values[i];
+                lo = std::min(lo, values[i]);
+                hi = std::max(hi, values[i]);
+            }
+            double exact = sum / (window + 1);
+            double average = rollup.average(ms(window));
+            if (window < 10)
+                assert (fabs(average - exact) < 1.0e-9);
+            assert (fabs(average - exact) < 0.03 * exact + 1.0);
+            assert (fabs(rollup.count(ms(window)) - (window + 1)) < 1.0e-6 * window + 1.0e-9);
+            
+            // A bucket at the start of the window contributes its minimum and
+            // maximum whole.
+            
+            assert ((rollup.min(ms(window)) <= lo) && (rollup.max(ms(window)) >= hi));
+            assert ((rollup.min(ms(window)) >= 0.0) && (rollup.max(ms(window)) <= 1000.0));
+        }
+        assert (rollup.max(ms(20000)) < 1000.0);
+        assert (rollup.max(ms(40000)) == 1000.0);
+        
+        // After a long gap, the older values are outside the window.
+        
+        rollup.add(1.0, tp(ms(n + 3 * 3600 * 1000)));
+        assert (rollup.count(std::chrono::hours(1)) == 1.0);
+        assert (rollup.average(std::chrono::hours(1)) == 1.0);
+        
+        // A gap with no values is skipped, and values on both sides of it
+        // are included.
+        
+        RollupAverage<float, TestClock> sparse(ms(10), std::chrono::minutes(1), 4);
+        sparse.add(2.0f, tp(ms(5)));
+        sparse.add(4.0f, tp(ms(45000)));
+        sparse.add(6.0f, tp(ms(45001)));
+        assert (sparse.average(ms(1)) == 5.0f);
+        assert (sparse.count(ms(50000)) == 3.0);
+        assert (sparse.average(ms(50000)) == 4.0f);
+        assert ((sparse.min(ms(50000)) == 2.0f) && (sparse.max(ms(50000)) == 6.0f));
+        
+        std::cerr << "ok\n";
+    }
+    
+    void testFixedRunningAverage()
+    {
+        std::cerr << "Starting Aut::testFixedRunningAverage()\n";
+        
+        // An empty averager is usable at compile time.
+        
+        typedef std::chrono::milliseconds ms;
+        constexpr FixedRunningAverage<float, 4> empty(ms(100));
+        static_assert(empty() == 0.0f, "an empty FixedRunningAverage should average to 0");
+        static_assert(empty.capacity() == 4, "FixedRunningAverage's capacity should be N");
+        static_assert(empty.window() == ms(100), "FixedRunningAverage's window should be set");
+        static constexpr int five[] = { 1, 2, 3, 4, 5 };
+        static_assert(PairwiseSum<int, 0, 5>::of(five) == 15, "PairwiseSum should add all the values");
+        
+        // Its values are stored inline.
+        
+        static_assert(sizeof(FixedRunningAverage<float, 8>) >=
+                      8 * (sizeof(float) + sizeof(std::chrono::steady_clock::time_point)),
+                      "FixedRunningAverage should store its values inline");
+        
+        // The averages match RunningAverage<T> with the same capacity, for
+        // values expiring both by capacity and by time.
+        
+        FixedRunningAverage<double, 7, TestClock> fixed(ms(50));
+        RunningAverage<double, TestClock> running(7, ms(50));
+        TestRandom draw;
+        int t = 0;
+        for (int i = 0; i < 10000; i++)
+        {
+            unsigned r = draw.next();
+            double x = TestRandom::unit(r) * 100.0;
+            t += (r >> 4) % 20;
+            fixed.add(x, TestClock::time_point(ms(t)));
+            running.add(x, TestClock::time_point(ms(t)));
+            assert (fabs(fixed() - running()) < 1.0e-9);
+            assert (fixed.size() <= 7);
+        }
+        
+        TestClock::ms = 1000;
+        FixedRunningAverage<float, 3, TestClock> timed(ms(100));
+        timed.add(1.0f);
+        timed.add(2.0f);
+        timed.add(3.0f);
+        timed.add(4.0f);
+        assert ((timed() == 3.0f) && (timed.size() == 3));
+        TestClock::ms = 1150;
+        timed.add(8.0f);
+        assert ((timed() == 8.0f) && (timed.size() == 1));
+        timed.setWindow(ms(1000));
+        assert (timed.window() == ms(1000));
+        
+        FixedRunningAverage<int, 1> one;
+        assert (one() == 0);
+        one.add(5);
+        one.add(9);
+        assert (one() == 9);
+        
+        std::cerr << "ok\n";
+    }
+    
+    void testMultiRunningAverage()
+    {
+        std::cerr << "Starting Aut::testMultiRunningAverage()\n";
+        
+        typedef std::chrono::milliseconds ms;
+        MultiRunningAverage<TestClock> multi(7, 5, ms(50));
+        assert ((multi.channels() == 7) && (multi.capacity() == 5) && (multi.window() == ms(50)));
+        assert ((multi().size() == 7) && (multi()[6] == 0.0f));
+        
+        // The averages match a RunningAverage<T> per channel, for a number of
+        // channels that is not a multiple of four, with frames expiring both
+        // by capacity and by time, over enough frames that the sums are
+        // recomputed several times.
+        
+        std::vector<std::unique_ptr<RunningAverage<float, TestClock>>> singles;
+        for (size_t c = 0; c < multi.channels(); c++)
+            singles.push_back(std::unique_ptr<RunningAverage<float, TestClock>>(
+                new RunningAverage<float, TestClock>(5, ms(50))));
+        TestRandom draw;
+        std::vector<float> frame(7);
+        TestClock::ms = 0;
+        for (int i = 0; i < 3000; i++)
+        {
+            TestClock::ms += (draw.next() >> 4) % 20;
+            for (size_t c = 0; c < frame.size(); c++)
+            {
+                frame[c] = float(draw.uniform()) * 100.0f * (c + 1);
+                singles[c]->add(frame[c]);
+            }
+            multi.add(frame.data());
+            const std::vector<float>& averages = multi();
+            for (size_t c = 0; c < frame.size(); c++)
+                assert (fabsf(averages[c] - (*singles[c])()) <= 1.0e-5f * 100.0f * (c + 1));
+        }
+        
+        // Changing the capacity keeps the most recent frames.
+        
+        MultiRunningAverage<TestClock> ring(2, 3, std::chrono::hours(1));
+        for (int i = 1; i <= 5; i++)
+        {
+            float values[2] = { float(i), float(-10 * i) };
+            ring.add(values);
+        }
+        assert ((ring()[0] == 4.0f) && (ring()[1] == -40.0f) && (ring.size() == 3));
+        ring.setCapacity(2);
+        assert ((ring()[0] == 4.5f) && (ring()[1] == -45.0f) && (ring.size() == 2));
+        ring.setCapacity(4);
+        float values[2] = { 6.0f, -60.0f };
+        ring.add(values);
+        assert ((ring()[0] == 5.0f) && (ring()[1] == -50.0f));
+        ring.setWindow(ms(10));
+        TestClock::ms += 100;
+        ring.add(values);
+        assert ((ring()[0] == 6.0f) && (ring.size() == 1));
+        
+        std::cerr << "ok\n";
+    }
+    
+    void testSnapshot()
+    {
+        std::cerr << "Starting Aut::testSnapshot()\n";
+        
+        typedef std::chrono::milliseconds ms;
+        typedef TestClock::time_point tp;
+        const char* dir = getenv("TMPDIR");
+        std::string path = std::string(dir ? dir : "/tmp") + "/AutTestSnapshot.auts";
+        
+        // A restored averager has the saved values, capacity and window,
+        // with the times of the values rebased to the time of the restore.
+        
+        RunningAverage<float, TestClock> saved(4, ms(100));
+        for (int i = 1; i <= 6; i++)
+            saved.add(float(i), tp(ms(1000 + 10 * i)));
+        assert (saved() == 4.5f);
+        assert (saved.save(path, tp(ms(1060))));
+        
+        RunningAverage<float, TestClock> restored(2, ms(10));
+        restored.add(100.0f, tp(ms(0)));
+        assert (restored.restore(path, tp(ms(50060))));
+        assert ((restored.capacity() == 4) && (restored.window() == ms(100)));
+        assert (restored() == 4.5f);
+        restored.add(7.0f, tp(ms(50145)));
+        assert (restored() == 6.0f);
+        
+        // The streams of a table are restored the same way.
+        
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        RunningAverageTable<int, double> table(3, ms(100));
+        for (int i = 0; i < 1000; i++)
+            table.add(i % 300, double(i), t0 + ms(i % 50));
+        assert (table.save(path, t0 + ms(60)));
+        
+        RunningAverageTable<int, double> restoredTable(8, ms(10));
+        restoredTable.add(-1, 1.0, t0);
+        assert (restoredTable.restore(path, t0 + ms(5060)));
+        assert ((restoredTable.capacity() == 3) && (restoredTable.window() == ms(100)));
+        assert ((restoredTable.size() == 300) && !restoredTable.contains(-1));
+        for (int key = 0; key < 300; key++)
+            assert (restoredTable(key) == table(key));
+        restoredTable.add(7, 1.0, t0 + ms(5100));
+        assert (restoredTable(7) == (607.0 + 907.0 + 1.0) / 3.0);
+        assert (restoredTable.expire(t0 + ms(5155)) == 299);
+        
+        // Files of the wrong kind, version or size are reported as errors,
+        // and leave the averagers unchanged.
+        
+        int errors = 0;
+        std::function<void(const std::string&)> errorFunc = Aut::errorFunction();
+        Aut::setErrorFunction([&](const std::string&) { errors++; });
+        assert (!restored.restore(path));
+        assert ((errors == 1) && (restored() == 6.0f));
+        RunningAverageTable<int, float> wrongType;
+        assert (!wrongType.restore(path));
+        assert (errors == 2);
+        assert (!restored.restore(path + ".missing"));
+        assert (errors == 3);
+        
+        std::vector<char> bytes;
+        {
+            std::ifstream in(path.c_str(), std::ios::binary);
+            bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        {
+            std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+            out.write(bytes.data(), bytes.size() - 1);
+        }
+        assert (!restoredTable.restore(path));
+        assert ((errors == 4) && (restoredTable.size() == 1));
+        bytes[4]++;
+        {
+            std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+            out.write(bytes.data(), bytes.size());
+        }
+        assert (!restoredTable.restore(path));
+        assert (errors == 5);
+        
+        // So are headers with a negative window or a capacity too large to
+        // allocate.
+        
+        for (int corrupt = 0; corrupt < 4; corrupt++)
+        {
+            if (corrupt < 2)
+                assert (saved.save(path, tp(ms(1060))));
+            else
+                assert (table.save(path, t0 + ms(60)));
+            {
+                std::ifstream in(path.c_str(), std::ios::binary);
+                bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            }
+            SnapshotHeader header;
+            memcpy(&header, bytes.data(), sizeof(header));
+            if (corrupt % 2 == 0)
+                header.window = -1;
+            else
+                header.capacity = uint64_t(1) << 62;
+            memcpy(bytes.data(), &header, sizeof(header));
+            {
+                std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+                out.write(bytes.data(), bytes.size());
+            }
+            if (corrupt < 2)
+                assert (!restored.restore(path));
+            else
+                assert (!restoredTable.restore(path));
+            assert (errors == 6 + corrupt);
+        }
+        assert ((restored() == 6.0f) && (restoredTable.size() == 1));
+        Aut::setErrorFunction(errorFunc);
+        
+        remove(path.c_str());
+        
         std::cerr << "ok\n";
     }
     
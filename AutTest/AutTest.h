@@ -34,6 +34,26 @@ namespace Aut
     
     void testRunningAverage();
     void testAnim();
+    void testAnimSystem();
+    void testEase();
+    void testAnimScheduler();
+    void testAnimBuffer();
+    void testTimerWheel();
+    void testAnimManager();
+    void testClip();
+    void testVec();
+    void testBakedAnim();
+    void testTimeline();
+    void testAnimBlend();
+    void testAnimOutputs();
+    void testConcurrentRunningAverage();
+    void testRunningAverageTable();
+    void testRunningStats();
+    void testRunningQuantile();
+    void testRollupAverage();
+    void testFixedRunningAverage();
+    void testMultiRunningAverage();
+    void testSnapshot();
     
 }
 
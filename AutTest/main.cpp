@@ -24,10 +24,13 @@
 // AutTest/main.cpp
 //
 // An simple application to run confidence test for (parts of) the Aut library.
+// With the -bench argument, it also runs benchmarks.
 //
 
 #include "AutTest.h"
+#include "AutBench.h"
 #include <iostream>
+#include <string.h>
 
 int main(int argc, const char * argv[])
 {
@@ -35,6 +38,43 @@ int main(int argc, const char * argv[])
     
     Aut::testRunningAverage();
     Aut::testAnim();
+    Aut::testAnimSystem();
+    Aut::testEase();
+    Aut::testAnimScheduler();
+    Aut::testAnimBuffer();
+    Aut::testTimerWheel();
+    Aut::testAnimManager();
+    Aut::testClip();
+    Aut::testVec();
+    Aut::testBakedAnim();
+    Aut::testTimeline();
+    Aut::testAnimBlend();
+    Aut::testAnimOutputs();
+    Aut::testConcurrentRunningAverage();
+    Aut::testRunningAverageTable();
+    Aut::testRunningStats();
+    Aut::testRunningQuantile();
+    Aut::testRollupAverage();
+    Aut::testFixedRunningAverage();
+    Aut::testMultiRunningAverage();
+    Aut::testSnapshot();
+    
+    if ((argc > 1) && (strcmp(argv[1], "-bench") == 0))
+    {
+        Aut::benchAnimSegmentLookup();
+        Aut::benchAnimEasing();
+        Aut::benchClipLoad();
+        Aut::benchAnimTypes();
+        Aut::benchBakedAnim();
+        Aut::benchAnimOutputs();
+        Aut::benchRunningAverage();
+        Aut::benchConcurrentRunningAverage();
+        Aut::benchRunningAverageTable();
+        Aut::benchRunningQuantile();
+        Aut::benchFixedRunningAverage();
+        Aut::benchMultiRunningAverage();
+        Aut::benchSnapshot();
+    }
     
     std::cerr << "Finished AutTest\n";
     
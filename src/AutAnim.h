@@ -24,11 +24,16 @@
 // AutAnim.h
 //
 // A template class for animating changes to a variable whose type is the template
-// parameter.  The animation uses ease-in-ease-out interpolation.
+// parameter.  The animation uses ease-in-ease-out interpolation, unless the
+// second template parameter specifies another easing policy from AutEase.h.
 
 #ifndef __AutAnim__
 #define __AutAnim__
 
+#include "AutAnimOutputs.h"
+#include "AutAnimTraits.h"
+#include "AutBakedAnim.h"
+#include "AutEase.h"
 #include <chrono>
 #include <vector>
 #include <memory>
@@ -36,7 +41,7 @@
 namespace Aut
 {
     
-    template <typename T>
+    template <typename T, typename Ease = FastCosineEase>
     class Anim
     {
     public:
@@ -52,15 +57,12 @@ namespace Aut
         {
         public:
             
-            Segment(T* val = 0, const T& val0 = 0, const T& val1 = 0,
+            Segment(T* val = 0, const T& val0 = T(), const T& val1 = T(),
                     std::chrono::seconds duration = std::chrono::seconds(0));
-            ~Segment();
             
-            // A copy constructor and copy assigment operator are necessary
-            // so segments can be put in STL containers.
-            
-            Segment(const Segment&);
-            Segment& operator=(const Segment&);
+            // Segments are plain values, with no allocated data, so the
+            // implicit copy and move constructors and assignment operators
+            // let them be stored contiguously in STL containers.
             
             // Access the beginning and ending values for this segment.
             
@@ -71,19 +73,48 @@ namespace Aut
             
             std::chrono::seconds duration() const;
             
+            // Access the variable being animated by this segment.
+            
+            T*                   variable() const;
+            
         private:
             
-            // Details of the class' data are "hidden" in the Imp.h file.
-
-            class Imp;
-            std::unique_ptr<Imp> _m;
+            T*                                  _val;
+            T                                   _val0;
+            T                                   _val1;
+            std::chrono::seconds                _duration;
+            
+            // The time at which this segment ends, as an offset from the start
+            // of the animation, is set by the animation that contains it.
+            
+            std::chrono::steady_clock::duration _end;
             
             friend class Anim;
         };
 
-        // Set the sequence of segments that specify this animation.
+        // Set the sequence of segments that specify this animation.  The
+        // version taking an rvalue reference takes over the vector's storage
+        // instead of copying it.  Copying reuses the storage of the previous
+        // segments when there is room.
         
         void    set(const std::vector<Segment>& segments);
+        void    set(std::vector<Segment>&& segments);
+        
+        // Build the sequence of segments in place: reserve room for a number
+        // of segments, then append segments constructed from the arguments
+        // (as for the Segment constructor).  When enough room was reserved,
+        // appending does not allocate memory.  Appending is best done while
+        // the animation is not running.
+        
+        void    reserve(size_t count);
+        
+        template <typename... Args>
+        void    emplaceSegment(Args&&... args);
+        
+        // Remove all the segments, keeping their storage for reuse, and stop
+        // the animation.
+        
+        void    clear();
         
         // Start the animation as of the specified time.
         
@@ -101,14 +132,66 @@ namespace Aut
         // Evaluate the animation as of the specified time.  If theEvalAfterEnd
         // argument is RestartAfterEnd, the animation will cycle; otherwise,
         // evaluating after the summed durations of the segments will return the
-        // ending value of the last segment.
+        // ending value of the last segment.  PingPongAfterEnd also cycles, but
+        // plays every other cycle backwards.  The phase of a cycling animation
+        // is the time since the start modulo the summed durations, so it stays
+        // correct however far apart the evaluations are.  Evaluating before
+        // the start holds the value at the start.
         
-        enum EvalAfterEnd { RestartAfterEnd, StopAfterEnd };
+        enum EvalAfterEnd { RestartAfterEnd, StopAfterEnd, PingPongAfterEnd };
         
         void    eval(std::chrono::steady_clock::time_point t =
                      std::chrono::steady_clock::now(),
                      EvalAfterEnd afterEnd = RestartAfterEnd);
         
+        // Evaluate the animation in the same way, but store the value in the
+        // specified variable instead of the segments' variables (which may
+        // then be 0).  Nothing is stored if the animation is not running.
+        
+        void    eval(T& out, std::chrono::steady_clock::time_point t =
+                     std::chrono::steady_clock::now(),
+                     EvalAfterEnd afterEnd = RestartAfterEnd);
+        
+        // Bind the animation to a value in an array of outputs, so that eval()
+        // stores the value there instead of in the segments' variables (which
+        // may then be 0).  Nothing is stored after the value is removed from
+        // the outputs.  The outputs must outlive the binding.
+        
+        void    bind(AnimOutputs<T>& outputs, typename AnimOutputs<T>::Handle handle);
+        void    unbind();
+        
+        // Set the number of cycles a cycling animation plays before stopping
+        // (with the value at the end of its last cycle), or 0, the default,
+        // for no limit.
+        
+        void    setLoopCount(size_t count);
+        size_t  loopCount() const;
+        
+        // Sample the animation at (at least) the specified rate, in samples
+        // per second, into a baked animation of the first segment's variable.
+        // With a tolerance greater than 0, samples that linear interpolation
+        // between the samples kept reproduces within that distance (as
+        // measured by AnimTraits<T>) are dropped.
+        
+        BakedAnim<T> bake(float sampleRate, float tolerance = 0.0f) const;
+        
+        // Access the segments.
+        
+        const std::vector<Segment>&             segments() const;
+        
+        // Return the index of the segment that was current as of the most
+        // recent evaluation (or the start), and the time at which the
+        // animation leaves it (at its beginning, if playing backwards).
+        
+        size_t                                  segment() const;
+        std::chrono::steady_clock::time_point   segmentEnd() const;
+        
+        // Return the number of cycles completed since the start, and whether
+        // the current cycle plays backwards.
+        
+        size_t                                  cycle() const;
+        bool                                    reversed() const;
+        
     private:
 
         // Details of the class' data are "hidden" in the Imp.h file.
@@ -0,0 +1,110 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutAnimBlend.h
+//
+// A template class for combining several animations that drive the same
+// variables.  Each variable is a target with a base value, and each layer is
+// an Anim<T> with a weight and a mode: an override layer moves the target's
+// value toward the layer's value by the weight, and an additive layer adds
+// the weighted layer's value to it.  The layers are evaluated into a
+// contiguous scratch buffer, then combined in the order they were added, and
+// each target is written once per call to eval().
+//
+
+#ifndef __AutAnimBlend__
+#define __AutAnimBlend__
+
+#include "AutAnim.h"
+#include <chrono>
+#include <memory>
+
+namespace Aut
+{
+    
+    template <typename T, typename Ease = FastCosineEase>
+    class AnimBlend
+    {
+    public:
+        
+        AnimBlend();
+        ~AnimBlend();
+        
+        enum Mode { Override, Additive };
+        
+        // Add a variable to be driven by layers, returning the index that
+        // identifies it in the other routines.  With no layers contributing,
+        // the variable gets the base value.  The variable must outlive the
+        // blend.
+        
+        size_t  addTarget(T* var, const T& base = T());
+        
+        // Set and get the base value of a target.
+        
+        void    setBase(size_t target, const T& base);
+        const T& base(size_t target) const;
+        
+        // Add a layer driving a target, returning the index that identifies
+        // it in the other routines.  The animation's segments need no
+        // variables (they may be 0), since the blend takes the animation's
+        // values.  The animation must outlive the blend, and is started and
+        // stopped as usual.  A layer contributes once the animation has been
+        // evaluated, and after it stops the layer contributes its last value.
+        
+        size_t  addLayer(size_t target, Anim<T, Ease>& anim, Mode mode = Override,
+                         float weight = 1.0f);
+        
+        // Set and get the weight of a layer, usually between 0 and 1.
+        
+        void    setWeight(size_t layer, float weight);
+        float   weight(size_t layer) const;
+        
+        // Evaluate the layers' animations as of the specified time, and
+        // write the blended value of each target.
+        
+        void    eval(std::chrono::steady_clock::time_point t =
+                     std::chrono::steady_clock::now(),
+                     typename Anim<T, Ease>::EvalAfterEnd afterEnd =
+                     Anim<T, Ease>::RestartAfterEnd);
+        
+        // Return the number of targets and of layers.
+        
+        size_t  targets() const;
+        size_t  layers() const;
+        
+    private:
+        
+        // Details of the class' data are "hidden" in the Imp.h file.
+        
+        class Imp;
+        std::unique_ptr<Imp> _m;
+    };
+    
+}
+
+// The template definitions in the following header file should be considered
+// private implementation details.
+
+#include "AutAnimBlendImp.h"
+
+#endif
@@ -0,0 +1,204 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutAnimBlendImp.h
+//
+// The template definitions in the this header file should be considered
+// private implementation details.
+//
+
+#ifndef __AutAnimBlendImp_h
+#define __AutAnimBlendImp_h
+
+#include "AutAnimBlend.h"
+#include "AutAnimTraits.h"
+#include <algorithm>
+#include <vector>
+
+namespace Aut
+{
+    template <typename T, typename Ease>
+    class AnimBlend<T, Ease>::Imp
+    {
+    public:
+        Imp() : sorted(true) {}
+        
+        struct Target
+        {
+            T*                      var;
+            T                       base;
+        };
+        
+        struct Layer
+        {
+            Anim<T, Ease>*          anim;
+            size_t                  target;
+            Mode                    mode;
+            float                   weight;
+        };
+        
+        void sort();
+        
+        std::vector<Target>         targets;
+        std::vector<Layer>          layers;
+        
+        // The layers' values, with a flag for whether each has one yet, and
+        // the layers' indices grouped by target, in the order they were added.
+        
+        std::vector<T>              values;
+        std::vector<char>           valid;
+        std::vector<size_t>         order;
+        bool                        sorted;
+    };
+    
+    template <typename T, typename Ease>
+    void AnimBlend<T, Ease>::Imp::sort()
+    {
+        order.resize(layers.size());
+        for (size_t i = 0; i < order.size(); i++)
+            order[i] = i;
+        const std::vector<Layer>& l = layers;
+        std::stable_sort(order.begin(), order.end(), [&l](size_t a, size_t b)
+                         { return l[a].target < l[b].target; });
+        sorted = true;
+    }
+    
+    template <typename T, typename Ease>
+    AnimBlend<T, Ease>::AnimBlend() :
+        _m(new Imp)
+    {
+    }
+    
+    template <typename T, typename Ease>
+    AnimBlend<T, Ease>::~AnimBlend()
+    {
+    }
+    
+    template <typename T, typename Ease>
+    size_t AnimBlend<T, Ease>::addTarget(T* var, const T& base)
+    {
+        typename Imp::Target target = { var, base };
+        _m->targets.push_back(target);
+        return _m->targets.size() - 1;
+    }
+    
+    template <typename T, typename Ease>
+    void AnimBlend<T, Ease>::setBase(size_t target, const T& base)
+    {
+        _m->targets[target].base = base;
+    }
+    
+    template <typename T, typename Ease>
+    const T& AnimBlend<T, Ease>::base(size_t target) const
+    {
+        return _m->targets[target].base;
+    }
+    
+    template <typename T, typename Ease>
+    size_t AnimBlend<T, Ease>::addLayer(size_t target, Anim<T, Ease>& anim, Mode mode,
+                                        float weight)
+    {
+        typename Imp::Layer layer = { &anim, target, mode, weight };
+        _m->layers.push_back(layer);
+        _m->values.push_back(T());
+        _m->valid.push_back(false);
+        
+        // Layers are usually added target by target, which keeps the order
+        // sorted without sorting it.
+        
+        if (_m->sorted && !_m->order.empty() && (_m->layers[_m->order.back()].target > target))
+            _m->sorted = false;
+        _m->order.push_back(_m->layers.size() - 1);
+        return _m->layers.size() - 1;
+    }
+    
+    template <typename T, typename Ease>
+    void AnimBlend<T, Ease>::setWeight(size_t layer, float weight)
+    {
+        _m->layers[layer].weight = weight;
+    }
+    
+    template <typename T, typename Ease>
+    float AnimBlend<T, Ease>::weight(size_t layer) const
+    {
+        return _m->layers[layer].weight;
+    }
+    
+    template <typename T, typename Ease>
+    void AnimBlend<T, Ease>::eval(std::chrono::steady_clock::time_point t,
+                                  typename Anim<T, Ease>::EvalAfterEnd afterEnd)
+    {
+        if (!_m->sorted)
+            _m->sort();
+        
+        // Evaluate all the layers first, so their values are together.
+        
+        for (size_t i = 0; i < _m->layers.size(); i++)
+        {
+            Anim<T, Ease>* anim = _m->layers[i].anim;
+            if (anim->running())
+            {
+                anim->eval(_m->values[i], t, afterEnd);
+                _m->valid[i] = true;
+            }
+        }
+        
+        // Then combine the layers of each target in one pass.
+        
+        size_t k = 0;
+        for (size_t target = 0; target < _m->targets.size(); target++)
+        {
+            T value = _m->targets[target].base;
+            for (; (k < _m->order.size()) && (_m->layers[_m->order[k]].target == target); k++)
+            {
+                size_t i = _m->order[k];
+                if (!_m->valid[i])
+                    continue;
+                
+                const typename Imp::Layer& layer = _m->layers[i];
+                if (layer.mode == Additive)
+                    value = AnimTraits<T>::add(value, _m->values[i], layer.weight);
+                else if (layer.weight >= 1.0f)
+                    value = _m->values[i];
+                else
+                    value = AnimTraits<T>::interp(value, _m->values[i], layer.weight);
+            }
+            *_m->targets[target].var = value;
+        }
+    }
+    
+    template <typename T, typename Ease>
+    size_t AnimBlend<T, Ease>::targets() const
+    {
+        return _m->targets.size();
+    }
+    
+    template <typename T, typename Ease>
+    size_t AnimBlend<T, Ease>::layers() const
+    {
+        return _m->layers.size();
+    }
+    
+}
+
+#endif
@@ -0,0 +1,87 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutAnimBuffer.h
+//
+// A template class for passing animated values from the thread that
+// evaluates animations to another thread (e.g., a rendering thread) without
+// locking.  Animations write to the buffer's values, which belong to the
+// updating thread.  Publishing copies the values to a back buffer and swaps
+// it atomically with a spare buffer, so the reading thread always gets a
+// consistent snapshot of the values from one publication, and neither thread
+// ever waits for the other.
+//
+
+#ifndef __AutAnimBuffer__
+#define __AutAnimBuffer__
+
+#include <memory>
+
+namespace Aut
+{
+    
+    template <typename T>
+    class AnimBuffer
+    {
+    public:
+        
+        AnimBuffer(size_t size, const T& value = T());
+        ~AnimBuffer();
+        
+        // Return the number of values.
+        
+        size_t      size() const;
+        
+        // For the updating thread, access the values to be animated.  The
+        // addresses of the values do not change, so they can be used as the
+        // variables of animation segments.
+        
+        T*          values();
+        T*          value(size_t i);
+        
+        // For the updating thread, publish the current values.
+        
+        void        publish();
+        
+        // For the reading thread, return the most recently published values.
+        // The values do not change until the next call to read().  Only one
+        // thread may read from a buffer.
+        
+        const T*    read();
+        
+    private:
+        
+        // Details of the class' data are "hidden" in the Imp.h file.
+        
+        class Imp;
+        std::unique_ptr<Imp> _m;
+    };
+    
+}
+
+// The template definitions in the following header file should be considered
+// private implementation details.
+
+#include "AutAnimBufferImp.h"
+
+#endif
@@ -0,0 +1,116 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutAnimBufferImp.h
+//
+// The template definitions in the this header file should be considered
+// private implementation details.
+//
+
+#ifndef __AutAnimBufferImp_h
+#define __AutAnimBufferImp_h
+
+#include "AutAnimBuffer.h"
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace Aut
+{
+    template <typename T>
+    class AnimBuffer<T>::Imp
+    {
+    public:
+        
+        // Of the three buffers, one (the back) belongs to the updating thread,
+        // one (the front) belongs to the reading thread, and the third is
+        // exchanged with either of the others.  The spare index has a flag
+        // that is set when it holds values that the reader has not seen.
+        
+        enum { Fresh = 4 };
+        
+        Imp(size_t size, const T& value) : values(size, value), back(0),
+            spare(1), front(2)
+        {
+            for (std::vector<T>& buffer : buffers)
+                buffer.assign(size, value);
+        }
+        
+        std::vector<T>              values;
+        std::vector<T>              buffers[3];
+        unsigned                    back;
+        std::atomic<unsigned>       spare;
+        unsigned                    front;
+    };
+    
+    template <typename T>
+    AnimBuffer<T>::AnimBuffer(size_t size, const T& value) :
+        _m(new Imp(size, value))
+    {
+    }
+    
+    template <typename T>
+    AnimBuffer<T>::~AnimBuffer()
+    {
+    }
+    
+    template <typename T>
+    size_t AnimBuffer<T>::size() const
+    {
+        return _m->values.size();
+    }
+    
+    template <typename T>
+    T* AnimBuffer<T>::values()
+    {
+        return _m->values.data();
+    }
+    
+    template <typename T>
+    T* AnimBuffer<T>::value(size_t i)
+    {
+        return &_m->values[i];
+    }
+    
+    template <typename T>
+    void AnimBuffer<T>::publish()
+    {
+        std::copy(_m->values.begin(), _m->values.end(), _m->buffers[_m->back].begin());
+        unsigned previous = _m->spare.exchange(_m->back | Imp::Fresh, std::memory_order_acq_rel);
+        _m->back = previous & ~unsigned(Imp::Fresh);
+    }
+    
+    template <typename T>
+    const T* AnimBuffer<T>::read()
+    {
+        if (_m->spare.load(std::memory_order_relaxed) & Imp::Fresh)
+        {
+            unsigned previous = _m->spare.exchange(_m->front, std::memory_order_acq_rel);
+            _m->front = previous & ~unsigned(Imp::Fresh);
+        }
+        return _m->buffers[_m->front].data();
+    }
+    
+}
+
+#endif
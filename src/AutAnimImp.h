@@ -31,174 +31,292 @@
 #define __AutAnimImp_h
 
 #include "AutAnim.h"
+#include <algorithm>
+#include <utility>
 #include <math.h>
 
 namespace Aut
 {
-    template <typename T>
-    class Anim<T>::Segment::Imp
+    template <typename T, typename Ease>
+    Anim<T, Ease>::Segment::Segment(T* val, const T& val0, const T& val1,
+                                    std::chrono::seconds duration) :
+        _val(val), _val0(val0), _val1(val1), _duration(duration),
+        _end(std::chrono::steady_clock::duration::zero())
     {
-    public:
-        Imp(T* v = 0, const T& v0 = 0, const T& v1 = 0,
-            std::chrono::seconds d = std::chrono::seconds(0)) :
-            val(v), val0(v0), val1(v1), duration(d) {}
-        
-        void setStart(std::chrono::steady_clock::time_point t0);
-        bool contains(std::chrono::steady_clock::time_point t) const;
-        void eval(std::chrono::steady_clock::time_point t) const;
-
-        T*                                    val;
-        T                                     val0;
-        T                                     val1;
-        std::chrono::seconds                  duration;
-        std::chrono::steady_clock::time_point t0;
-    };
-    
-    template <typename T>
-    void Anim<T>::Segment::Imp::setStart(std::chrono::steady_clock::time_point t)
-    {
-        t0 = t;
     }
     
-    template <typename T>
-    bool Anim<T>::Segment::Imp::contains(std::chrono::steady_clock::time_point t) const
+    template <typename T, typename Ease>
+    T Anim<T, Ease>::Segment::value0() const
     {
-        return ((t0 <= t) && (t < t0 + duration));
+        return _val0;
     }
     
-    template <typename T>
-    void Anim<T>::Segment::Imp::eval(std::chrono::steady_clock::time_point t) const
+    template <typename T, typename Ease>
+    T Anim<T, Ease>::Segment::value1() const
     {
-        std::chrono::steady_clock::time_point t1 = t0 + duration;
-        if (t < t0)
-        {
-            *val = val0;
-        }
-        else if (t >= t1)
-        {
-            *val = val1;
-        }
-        else
-        {
-            float tt0 = std::chrono::duration_cast<std::chrono::milliseconds>(t - t0).count();
-            float t1t0 = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
-            *val = val0 + ((1 - cosf(tt0 / t1t0 * M_PI)) / 2.0f) * (val1 - val0);
-        }
+        return _val1;
     }
-
-    template <typename T>
-    Anim<T>::Segment::Segment(T* val, const T& val0, const T& val1,
-                              std::chrono::seconds duration) :
-        _m(new Imp(val, val0, val1, duration))
+    
+    template <typename T, typename Ease>
+    std::chrono::seconds Anim<T, Ease>::Segment::duration() const
     {
+        return _duration;
     }
     
-    template <typename T>
-    Anim<T>::Segment::~Segment()
+    template <typename T, typename Ease>
+    T* Anim<T, Ease>::Segment::variable() const
     {
+        return _val;
     }
     
-    template <typename T>
-    Anim<T>::Segment::Segment(const Segment& o) :
-        _m(new Imp(o._m->val, o._m->val0, o._m->val1, o._m->duration))
+    //
+    
+    template <typename T, typename Ease>
+    class Anim<T, Ease>::Imp
     {
-    }
+    public:
+        Imp() : cursor(0), running(false), cycle(0), reversed(false), loopCount(0),
+            outputs(0) {}
+        
+        void index(size_t first);
+        void restart(std::chrono::steady_clock::time_point);
+        bool contains(const Segment&, std::chrono::steady_clock::duration) const;
+        T    value(const Segment&, std::chrono::steady_clock::duration) const;
+        void eval(const Segment&, std::chrono::steady_clock::duration, T* out) const;
+        bool eval(std::chrono::steady_clock::time_point, T* out);
+        void wrap(std::chrono::steady_clock::time_point, EvalAfterEnd, T* out);
+        void finish(bool atBeginning, T* out);
+        std::chrono::steady_clock::duration total() const;
+        
+        // The segments' ends, as offsets from the start of the animation,
+        // allow the segment containing a time to be found with a binary
+        // search.  The cursor is the index of the segment found most recently,
+        // which is the most likely one to contain the next time (or to be just
+        // before or after it).  Since the segments' starting times are computed
+        // from the start of the current cycle, cycling does not change them.
+        
+        std::vector<Segment>                    segments;
+        size_t                                  cursor;
+        std::chrono::steady_clock::time_point   t0;
+        bool                                    running;
+        size_t                                  cycle;
+        bool                                    reversed;
+        size_t                                  loopCount;
+        
+        // The outputs the animation is bound to, if any.
+        
+        AnimOutputs<T>*                         outputs;
+        typename AnimOutputs<T>::Handle         handle;
+    };
     
-    template <typename T>
-    typename Anim<T>::Segment& Anim<T>::Segment::operator=(const Segment&o)
+    template <typename T, typename Ease>
+    void Anim<T, Ease>::Imp::index(size_t first)
     {
-        if (this != &o)
+        std::chrono::steady_clock::duration end = (first > 0) ? segments[first - 1]._end :
+            std::chrono::steady_clock::duration::zero();
+        for (size_t i = first; i < segments.size(); i++)
         {
-            _m->val = o._m->val;
-            _m->val0 = o._m->val0;
-            _m->val1 = o._m->val1;
-            _m->duration = o._m->duration;
-            _m->t0 = o._m->t0;
+            end += segments[i]._duration;
+            segments[i]._end = end;
         }
-        return *this;
+        if (first == 0)
+            cursor = 0;
     }
     
-    template <typename T>
-    T Anim<T>::Segment::value0() const
+    template <typename T, typename Ease>
+    void Anim<T, Ease>::Imp::restart(std::chrono::steady_clock::time_point t)
     {
-        return _m->val0;
+        t0 = t;
+        cursor = 0;
+        cycle = 0;
+        reversed = false;
     }
     
-    template <typename T>
-    T Anim<T>::Segment::value1() const
+    template <typename T, typename Ease>
+    std::chrono::steady_clock::duration Anim<T, Ease>::Imp::total() const
     {
-        return _m->val1;
+        return segments.back()._end;
     }
     
-    template <typename T>
-    std::chrono::seconds Anim<T>::Segment::duration() const
+    // The segments are evaluated at a phase, the offset into the current cycle
+    // in the direction of play.
+    
+    template <typename T, typename Ease>
+    bool Anim<T, Ease>::Imp::contains(const Segment& segment,
+                                      std::chrono::steady_clock::duration p) const
     {
-        return _m->duration;
+        return ((segment._end - segment._duration <= p) && (p < segment._end));
     }
     
-    //
+    template <typename T, typename Ease>
+    T Anim<T, Ease>::Imp::value(const Segment& segment,
+                                std::chrono::steady_clock::duration p) const
+    {
+        std::chrono::steady_clock::duration s0 = segment._end - segment._duration;
+        if (p < s0)
+            return segment._val0;
+        if (p >= segment._end)
+            return segment._val1;
+        float s = std::chrono::duration<float>(p - s0).count() /
+            std::chrono::duration<float>(segment._duration).count();
+        return AnimTraits<T>::interp(segment._val0, segment._val1, Ease::eval(s));
+    }
+    
+    // The value is written to out, or to the segment's variable if out is 0.
     
-    template <typename T>
-    class Anim<T>::Imp
+    template <typename T, typename Ease>
+    void Anim<T, Ease>::Imp::eval(const Segment& segment,
+                                  std::chrono::steady_clock::duration p, T* out) const
     {
-    public:
-        Imp() : running(false) {}
+        *(out ? out : segment._val) = value(segment, p);
+    }
+    
+    template <typename T, typename Ease>
+    bool Anim<T, Ease>::Imp::eval(std::chrono::steady_clock::time_point t, T* out)
+    {
+        std::chrono::steady_clock::duration e = t - t0;
+        std::chrono::steady_clock::duration end = total();
+        if (e >= end)
+            return false;
+        if (e < std::chrono::steady_clock::duration::zero())
+            e = std::chrono::steady_clock::duration::zero();
         
-        void restart(std::chrono::steady_clock::time_point);
-        bool eval(std::chrono::steady_clock::time_point);
+        // Playing backwards, the phase runs from the end down to just above
+        // zero, so the end itself is in the last segment.
         
-        std::vector<Segment>                  segments;
-        std::chrono::steady_clock::time_point t0;
-        bool                                  running;
-    };
+        std::chrono::steady_clock::duration p = reversed ? end - e : e;
+        if (!contains(segments[cursor], p))
+        {
+            if (p >= end)
+            {
+                cursor = segments.size() - 1;
+            }
+            else if ((cursor + 1 < segments.size()) && contains(segments[cursor + 1], p))
+            {
+                cursor++;
+            }
+            else if ((cursor > 0) && contains(segments[cursor - 1], p))
+            {
+                cursor--;
+            }
+            else
+            {
+                cursor = std::upper_bound(segments.begin(), segments.end(), p,
+                                          [](std::chrono::steady_clock::duration p,
+                                             const Segment& segment)
+                                          { return p < segment._end; }) - segments.begin();
+            }
+        }
+        
+        eval(segments[cursor], p, out);
+        return true;
+    }
     
-    template <typename T>
-    void Anim<T>::Imp::restart(std::chrono::steady_clock::time_point t)
+    template <typename T, typename Ease>
+    void Anim<T, Ease>::Imp::finish(bool atBeginning, T* out)
     {
-        for (Segment& segment : segments)
+        if (atBeginning)
+        {
+            cursor = 0;
+            *(out ? out : segments.front()._val) = segments.front()._val0;
+        }
+        else
         {
-            segment._m->setStart(t);
-            t += segment.duration();
+            cursor = segments.size() - 1;
+            *(out ? out : segments.back()._val) = segments.back()._val1;
         }
+        running = false;
     }
     
-    template <typename T>
-    bool Anim<T>::Imp::eval(std::chrono::steady_clock::time_point t)
+    template <typename T, typename Ease>
+    void Anim<T, Ease>::Imp::wrap(std::chrono::steady_clock::time_point t, EvalAfterEnd afterEnd,
+                                  T* out)
     {
-        for (const Segment& segment : segments)
+        std::chrono::steady_clock::duration end = total();
+        if ((afterEnd == StopAfterEnd) || (end == std::chrono::steady_clock::duration::zero()))
+        {
+            finish(reversed, out);
+            
+            // With no duration to cycle through, a cycling animation keeps
+            // running, holding its final value.
+            
+            if ((afterEnd != StopAfterEnd) && (loopCount == 0))
+                running = true;
+            return;
+        }
+        
+        // Skipping whole cycles costs the same however many there are.
+        
+        size_t cycles = size_t((t - t0) / end);
+        if ((loopCount > 0) && (cycle + cycles >= loopCount))
         {
-   
-            if (segment._m->contains(t))
+            size_t last = loopCount - 1;
+            if (last > cycle)
             {
-                segment._m->eval(t);
-                return true;
+                t0 += end * std::chrono::steady_clock::rep(last - cycle);
+                cycle = last;
             }
+            reversed = (afterEnd == PingPongAfterEnd) && (last % 2 == 1);
+            finish(reversed, out);
+            return;
         }
         
-        const Segment& segment = segments[segments.size()-1];
-        segment._m->eval(t);
-        return false;
+        t0 += end * std::chrono::steady_clock::rep(cycles);
+        cycle += cycles;
+        reversed = (afterEnd == PingPongAfterEnd) && (cycle % 2 == 1);
+        cursor = reversed ? segments.size() - 1 : 0;
+        (void) eval(t, out);
     }
     
-    template <typename T>
-    Anim<T>::Anim() :
+    template <typename T, typename Ease>
+    Anim<T, Ease>::Anim() :
         _m(new Imp)
     {
     }
     
-    template <typename T>
-    Anim<T>::~Anim()
+    template <typename T, typename Ease>
+    Anim<T, Ease>::~Anim()
     {
     }
     
-    template <typename T>
-    void Anim<T>::set(const std::vector<Segment>& segments)
+    template <typename T, typename Ease>
+    void Anim<T, Ease>::set(const std::vector<Segment>& segments)
     {
         _m->segments = segments;
+        _m->index(0);
+    }
+    
+    template <typename T, typename Ease>
+    void Anim<T, Ease>::set(std::vector<Segment>&& segments)
+    {
+        _m->segments = std::move(segments);
+        _m->index(0);
     }
     
-    template <typename T>
-    void Anim<T>::start(std::chrono::steady_clock::time_point t0)
+    template <typename T, typename Ease>
+    void Anim<T, Ease>::reserve(size_t count)
+    {
+        _m->segments.reserve(count);
+    }
+    
+    template <typename T, typename Ease>
+    template <typename... Args>
+    void Anim<T, Ease>::emplaceSegment(Args&&... args)
+    {
+        _m->segments.emplace_back(std::forward<Args>(args)...);
+        _m->index(_m->segments.size() - 1);
+    }
+    
+    template <typename T, typename Ease>
+    void Anim<T, Ease>::clear()
+    {
+        _m->segments.clear();
+        _m->cursor = 0;
+        _m->running = false;
+    }
+    
+    template <typename T, typename Ease>
+    void Anim<T, Ease>::start(std::chrono::steady_clock::time_point t0)
     {
         if (_m->segments.size() > 0)
         {
@@ -207,37 +325,134 @@ namespace Aut
         }
     }
     
-    template <typename T>
-    void Anim<T>::stop()
+    template <typename T, typename Ease>
+    void Anim<T, Ease>::stop()
     {
         _m->running = false;
     }
     
-    template <typename T>
-    bool Anim<T>::running() const
+    template <typename T, typename Ease>
+    bool Anim<T, Ease>::running() const
     {
         return _m->running;
     }
     
-    template <typename T>
-    void Anim<T>::eval(std::chrono::steady_clock::time_point t,
-                       EvalAfterEnd afterEnd)
+    template <typename T, typename Ease>
+    void Anim<T, Ease>::eval(std::chrono::steady_clock::time_point t,
+                             EvalAfterEnd afterEnd)
     {
         if (_m->running)
         {
-            if (!_m->eval(t))
-            {
-                if (afterEnd == RestartAfterEnd)
-                {
-                    _m->restart(t);
-                    (void) _m->eval(t);
-                }
-                else
-                {
-                    _m->running = false;
-                }
-            }
+            T* out = 0;
+            if (_m->outputs && !(out = _m->outputs->find(_m->handle)))
+                return;
+            if (!_m->eval(t, out))
+                _m->wrap(t, afterEnd, out);
+        }
+    }
+    
+    template <typename T, typename Ease>
+    void Anim<T, Ease>::eval(T& out, std::chrono::steady_clock::time_point t,
+                             EvalAfterEnd afterEnd)
+    {
+        if (_m->running)
+        {
+            if (!_m->eval(t, &out))
+                _m->wrap(t, afterEnd, &out);
+        }
+    }
+    
+    template <typename T, typename Ease>
+    BakedAnim<T> Anim<T, Ease>::bake(float sampleRate, float tolerance) const
+    {
+        BakedAnim<T> baked;
+        if (_m->segments.empty() || (sampleRate <= 0.0f))
+            return baked;
+        
+        // The samples are evenly spaced, with the last one at the end.
+        
+        std::chrono::steady_clock::duration total = _m->total();
+        size_t intervals = size_t(ceil(std::chrono::duration<double>(total).count() * sampleRate));
+        if (intervals < 1)
+            intervals = 1;
+        std::vector<T> samples;
+        samples.reserve(intervals + 1);
+        for (size_t i = 0; i <= intervals; i++)
+        {
+            std::chrono::steady_clock::duration p = total * std::chrono::steady_clock::rep(i) /
+                std::chrono::steady_clock::rep(intervals);
+            const Segment& segment = (p >= total) ? _m->segments.back() :
+                *std::upper_bound(_m->segments.begin(), _m->segments.end(), p,
+                                  [](std::chrono::steady_clock::duration p,
+                                     const Segment& segment)
+                                  { return p < segment._end; });
+            samples.push_back(_m->value(segment, p));
         }
+        
+        baked._m->val = _m->segments.front()._val;
+        baked._m->total = total;
+        baked._m->build(std::move(samples), tolerance);
+        return baked;
+    }
+    
+    template <typename T, typename Ease>
+    void Anim<T, Ease>::bind(AnimOutputs<T>& outputs, typename AnimOutputs<T>::Handle handle)
+    {
+        _m->outputs = &outputs;
+        _m->handle = handle;
+    }
+    
+    template <typename T, typename Ease>
+    void Anim<T, Ease>::unbind()
+    {
+        _m->outputs = 0;
+    }
+    
+    template <typename T, typename Ease>
+    void Anim<T, Ease>::setLoopCount(size_t count)
+    {
+        _m->loopCount = count;
+    }
+    
+    template <typename T, typename Ease>
+    size_t Anim<T, Ease>::loopCount() const
+    {
+        return _m->loopCount;
+    }
+    
+    template <typename T, typename Ease>
+    const std::vector<typename Anim<T, Ease>::Segment>& Anim<T, Ease>::segments() const
+    {
+        return _m->segments;
+    }
+    
+    template <typename T, typename Ease>
+    size_t Anim<T, Ease>::segment() const
+    {
+        return _m->cursor;
+    }
+    
+    template <typename T, typename Ease>
+    std::chrono::steady_clock::time_point Anim<T, Ease>::segmentEnd() const
+    {
+        if (_m->segments.empty())
+            return _m->t0;
+        const Segment& segment = _m->segments[_m->cursor];
+        if (_m->reversed)
+            return _m->t0 + (_m->total() - (segment._end - segment._duration));
+        return _m->t0 + segment._end;
+    }
+    
+    template <typename T, typename Ease>
+    size_t Anim<T, Ease>::cycle() const
+    {
+        return _m->cycle;
+    }
+    
+    template <typename T, typename Ease>
+    bool Anim<T, Ease>::reversed() const
+    {
+        return _m->reversed;
     }
 }
 
@@ -0,0 +1,116 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutAnimManager.h
+//
+// A template class for managing many animations of which most, at any time,
+// are stopped, finished, or in segments whose beginning and ending values are
+// the same.  Only animations in segments whose values change are evaluated on
+// every call to eval(); the others wait in a timer wheel, keyed by the time of
+// their next segment boundary, and cost nothing until that time arrives.
+// Callbacks can be registered for the ends of segments and of animations.
+//
+
+#ifndef __AutAnimManager__
+#define __AutAnimManager__
+
+#include "AutAnim.h"
+#include <chrono>
+#include <functional>
+#include <memory>
+
+namespace Aut
+{
+    
+    template <typename T, typename Ease = FastCosineEase>
+    class AnimManager
+    {
+    public:
+        
+        // Segment boundaries are tracked to the specified resolution, from
+        // the specified starting time.  Boundaries before the starting time
+        // are all due at once, so animations evaluated only at earlier times
+        // (e.g., with simulated times from the clock's epoch) are evaluated
+        // on every call to eval(); the starting time should be no later than
+        // the earliest time the animations are started or evaluated at.
+        
+        AnimManager(std::chrono::steady_clock::duration tick =
+                    std::chrono::milliseconds(1),
+                    std::chrono::steady_clock::time_point start =
+                    std::chrono::steady_clock::now());
+        ~AnimManager();
+        
+        // Add an animation, to be evaluated with the specified treatment of
+        // times after the end, returning the index that identifies it in the
+        // other routines.  The animation must outlive the manager.  It should
+        // be started and stopped through the manager.
+        
+        size_t  add(Anim<T, Ease>& anim,
+                    typename Anim<T, Ease>::EvalAfterEnd afterEnd =
+                    Anim<T, Ease>::RestartAfterEnd);
+        
+        // Start, stop and check an animation, as for Anim<T>.
+        
+        void    start(size_t index, std::chrono::steady_clock::time_point t0 =
+                      std::chrono::steady_clock::now());
+        void    stop(size_t index);
+        bool    running(size_t index) const;
+        
+        // Set the functions called when each segment of an animation ends
+        // (with the animation's index and the segment's index), and when the
+        // animation ends (with the animation's index).  For an animation that
+        // restarts after its end, the function for the end is called at the
+        // end of each cycle.  If a call to eval() passes several boundaries,
+        // even several whole cycles, the functions are called for each of
+        // them, in order.  The functions may add, start and stop animations.
+        
+        void    setSegmentEndFunction(size_t index, std::function<void(size_t, size_t)>);
+        void    setEndFunction(size_t index, std::function<void(size_t)>);
+        
+        // Evaluate the animations that need it as of the specified time.
+        
+        void    eval(std::chrono::steady_clock::time_point t =
+                     std::chrono::steady_clock::now());
+        
+        // Return the number of animations, and the number currently being
+        // evaluated on every call to eval().
+        
+        size_t  size() const;
+        size_t  active() const;
+        
+    private:
+        
+        // Details of the class' data are "hidden" in the Imp.h file.
+        
+        class Imp;
+        std::unique_ptr<Imp> _m;
+    };
+    
+}
+
+// The template definitions in the following header file should be considered
+// private implementation details.
+
+#include "AutAnimManagerImp.h"
+
+#endif
@@ -0,0 +1,344 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutAnimManagerImp.h
+//
+// The template definitions in the this header file should be considered
+// private implementation details.
+//
+
+#ifndef __AutAnimManagerImp_h
+#define __AutAnimManagerImp_h
+
+#include "AutAnimManager.h"
+#include "AutTimerWheel.h"
+#include <algorithm>
+#include <vector>
+
+namespace Aut
+{
+    template <typename T, typename Ease>
+    class AnimManager<T, Ease>::Imp
+    {
+    public:
+        Imp(std::chrono::steady_clock::duration tick, std::chrono::steady_clock::time_point start) :
+            wheel(tick, start) {}
+        
+        static const size_t none = size_t(-1);
+        
+        struct Entry
+        {
+            Anim<T, Ease>*                          anim;
+            typename Anim<T, Ease>::EvalAfterEnd    afterEnd;
+            std::function<void(size_t, size_t)>     segmentEndFunc;
+            std::function<void(size_t)>             endFunc;
+            
+            // The segment as of the last evaluation, or as of the start for
+            // an animation just started (none if the animation is stopped),
+            // and the index in the active list (none if the animation is not
+            // active).
+            
+            size_t                                  segment;
+            std::chrono::steady_clock::time_point   segmentEnd;
+            size_t                                  cycle;
+            bool                                    reversed;
+            size_t                                  activeIndex;
+        };
+        
+        void begin(size_t index);
+        void activate(size_t index);
+        void deactivate(size_t index);
+        void update(size_t index, bool wasRunning);
+        void segmentsEnded(size_t index, size_t from, size_t to, bool reversed);
+        void cyclesEnded(size_t index, size_t segment, bool reversed, size_t from, size_t to);
+        
+        std::vector<Entry>                          entries;
+        std::vector<size_t>                         activeList;
+        TimerWheel                                  wheel;
+        std::vector<size_t>                         due;
+        std::vector<size_t>                         work;
+    };
+    
+    template <typename T, typename Ease>
+    void AnimManager<T, Ease>::Imp::begin(size_t index)
+    {
+        // The animation is evaluated on the next call to eval(), which
+        // determines whether it needs to stay active, and reports the
+        // boundaries passed since the state the animation has now (the
+        // first segment of the first cycle, if it was just started).
+        
+        Entry& entry = entries[index];
+        const Anim<T, Ease>& anim = *entry.anim;
+        entry.segment = anim.segments().empty() ? none : anim.segment();
+        entry.segmentEnd = anim.segmentEnd();
+        entry.cycle = anim.cycle();
+        entry.reversed = anim.reversed();
+        wheel.cancel(index);
+        activate(index);
+    }
+    
+    template <typename T, typename Ease>
+    void AnimManager<T, Ease>::Imp::activate(size_t index)
+    {
+        Entry& entry = entries[index];
+        if (entry.activeIndex == none)
+        {
+            entry.activeIndex = activeList.size();
+            activeList.push_back(index);
+        }
+    }
+    
+    template <typename T, typename Ease>
+    void AnimManager<T, Ease>::Imp::deactivate(size_t index)
+    {
+        Entry& entry = entries[index];
+        if (entry.activeIndex != none)
+        {
+            size_t moved = activeList.back();
+            activeList[entry.activeIndex] = moved;
+            entries[moved].activeIndex = entry.activeIndex;
+            activeList.pop_back();
+            entry.activeIndex = none;
+        }
+    }
+    
+    // Call the function for the segments passed going from one segment to
+    // another (exclusive), in the direction of play.  Going backwards, a
+    // destination of none is before the first segment.  The function is
+    // copied, since it may add animations, moving the entries.
+    
+    template <typename T, typename Ease>
+    void AnimManager<T, Ease>::Imp::segmentsEnded(size_t index, size_t from, size_t to,
+                                                  bool reversed)
+    {
+        std::function<void(size_t, size_t)> func = entries[index].segmentEndFunc;
+        if (func)
+        {
+            if (!reversed)
+            {
+                for (size_t i = from; i < to; i++)
+                    func(index, i);
+            }
+            else
+            {
+                for (size_t i = from + 1; i > to + 1; i--)
+                    func(index, i - 1);
+            }
+        }
+    }
+    
+    // Call the functions for the ends of the cycles from one cycle to
+    // another (exclusive), the first of them passed from the specified
+    // segment in the specified direction.
+    
+    template <typename T, typename Ease>
+    void AnimManager<T, Ease>::Imp::cyclesEnded(size_t index, size_t segment, bool reversed,
+                                                size_t from, size_t to)
+    {
+        size_t count = entries[index].anim->segments().size();
+        bool pingPong = (entries[index].afterEnd == Anim<T, Ease>::PingPongAfterEnd);
+        std::function<void(size_t)> func = entries[index].endFunc;
+        if (!func && !entries[index].segmentEndFunc)
+            return;
+        for (size_t cycle = from; cycle < to; cycle++)
+        {
+            if (cycle > from)
+            {
+                reversed = pingPong && (cycle % 2 == 1);
+                segment = reversed ? count - 1 : 0;
+            }
+            segmentsEnded(index, segment, reversed ? none : count, reversed);
+            if (func)
+                func(index);
+        }
+    }
+    
+    template <typename T, typename Ease>
+    void AnimManager<T, Ease>::Imp::update(size_t index, bool wasRunning)
+    {
+        Entry& entry = entries[index];
+        const Anim<T, Ease>& anim = *entry.anim;
+        size_t previous = entry.segment;
+        size_t count = anim.segments().size();
+        
+        if (!anim.running() || (count == 0))
+        {
+            deactivate(index);
+            wheel.cancel(index);
+            entry.segment = none;
+            
+            // Stopping at the end of its last cycle, an animation may have
+            // passed the ends of earlier ones.
+            
+            if (wasRunning && (previous != none))
+                cyclesEnded(index, previous, entry.reversed, entry.cycle,
+                            std::max(anim.cycle(), entry.cycle) + 1);
+            return;
+        }
+        
+        size_t current = anim.segment();
+        std::chrono::steady_clock::time_point end = anim.segmentEnd();
+        bool moved = (previous == none) || (current != previous) || (end != entry.segmentEnd);
+        bool wrapped = (previous != none) && (anim.cycle() != entry.cycle);
+        size_t wasCycle = entry.cycle;
+        bool wasReversed = entry.reversed;
+        entry.segment = current;
+        entry.segmentEnd = end;
+        entry.cycle = anim.cycle();
+        entry.reversed = anim.reversed();
+        
+        // An animation in a segment with no change in value needs no more
+        // evaluation until the segment ends.
+        
+        const typename Anim<T, Ease>::Segment& segment = anim.segments()[current];
+        if (segment.value0() == segment.value1())
+            deactivate(index);
+        else
+            activate(index);
+        if (moved || !wheel.scheduled(index))
+            wheel.schedule(index, end);
+        
+        // The functions are called last, in case they start or stop
+        // animations, and the entry is not used after they are called, in
+        // case they add animations.
+        
+        size_t cycle = entry.cycle;
+        bool reversed = entry.reversed;
+        if (wrapped)
+        {
+            cyclesEnded(index, previous, wasReversed, wasCycle, cycle);
+            segmentsEnded(index, reversed ? count - 1 : 0, current, reversed);
+        }
+        else if (previous != none)
+        {
+            segmentsEnded(index, previous, current, reversed);
+        }
+    }
+    
+    template <typename T, typename Ease>
+    AnimManager<T, Ease>::AnimManager(std::chrono::steady_clock::duration tick,
+                                      std::chrono::steady_clock::time_point start) :
+        _m(new Imp(tick, start))
+    {
+    }
+    
+    template <typename T, typename Ease>
+    AnimManager<T, Ease>::~AnimManager()
+    {
+    }
+    
+    template <typename T, typename Ease>
+    size_t AnimManager<T, Ease>::add(Anim<T, Ease>& anim,
+                                     typename Anim<T, Ease>::EvalAfterEnd afterEnd)
+    {
+        typename Imp::Entry entry;
+        entry.anim = &anim;
+        entry.afterEnd = afterEnd;
+        entry.segment = Imp::none;
+        entry.cycle = 0;
+        entry.reversed = false;
+        entry.activeIndex = Imp::none;
+        
+        size_t index = _m->entries.size();
+        _m->entries.push_back(entry);
+        if (anim.running())
+            _m->begin(index);
+        return index;
+    }
+    
+    template <typename T, typename Ease>
+    void AnimManager<T, Ease>::start(size_t index, std::chrono::steady_clock::time_point t0)
+    {
+        _m->entries[index].anim->start(t0);
+        if (_m->entries[index].anim->running())
+            _m->begin(index);
+    }
+    
+    template <typename T, typename Ease>
+    void AnimManager<T, Ease>::stop(size_t index)
+    {
+        _m->entries[index].anim->stop();
+        _m->entries[index].segment = Imp::none;
+        _m->deactivate(index);
+        _m->wheel.cancel(index);
+    }
+    
+    template <typename T, typename Ease>
+    bool AnimManager<T, Ease>::running(size_t index) const
+    {
+        return _m->entries[index].anim->running();
+    }
+    
+    template <typename T, typename Ease>
+    void AnimManager<T, Ease>::setSegmentEndFunction(size_t index,
+                                                     std::function<void(size_t, size_t)> func)
+    {
+        _m->entries[index].segmentEndFunc = func;
+    }
+    
+    template <typename T, typename Ease>
+    void AnimManager<T, Ease>::setEndFunction(size_t index, std::function<void(size_t)> func)
+    {
+        _m->entries[index].endFunc = func;
+    }
+    
+    template <typename T, typename Ease>
+    void AnimManager<T, Ease>::eval(std::chrono::steady_clock::time_point t)
+    {
+        // The animations to evaluate are those that are active, and those
+        // that have reached a segment boundary.
+        
+        _m->due.clear();
+        _m->wheel.advance(t, _m->due);
+        
+        _m->work.assign(_m->activeList.begin(), _m->activeList.end());
+        for (size_t index : _m->due)
+        {
+            if (_m->entries[index].activeIndex == Imp::none)
+                _m->work.push_back(index);
+        }
+        
+        for (size_t index : _m->work)
+        {
+            typename Imp::Entry& entry = _m->entries[index];
+            bool wasRunning = entry.anim->running();
+            entry.anim->eval(t, entry.afterEnd);
+            _m->update(index, wasRunning);
+        }
+    }
+    
+    template <typename T, typename Ease>
+    size_t AnimManager<T, Ease>::size() const
+    {
+        return _m->entries.size();
+    }
+    
+    template <typename T, typename Ease>
+    size_t AnimManager<T, Ease>::active() const
+    {
+        return _m->activeList.size();
+    }
+    
+}
+
+#endif
@@ -0,0 +1,118 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutAnimOutputs.h
+//
+// A template class holding animated values of type T in one contiguous
+// array, addressed by stable handles.  Animations bound to a handle (with
+// Anim<T>::bind()) write their values into the array instead of through
+// pointers to variables scattered in memory, and consumers read all the
+// values linearly with data().  Removing a value moves the last value into
+// its place, so the array stays dense, and the handles of the moved values
+// stay valid.  A removed value's handle becomes invalid, and stays invalid
+// as other values are added.
+//
+
+#ifndef __AutAnimOutputs__
+#define __AutAnimOutputs__
+
+#include <memory>
+#include <stdint.h>
+
+namespace Aut
+{
+    
+    template <typename T>
+    class AnimOutputs
+    {
+    public:
+        
+        AnimOutputs();
+        ~AnimOutputs();
+        
+        // A handle is a small value that is cheap to copy.  A default
+        // handle is invalid.
+        
+        class Handle
+        {
+        public:
+            Handle() : _id(uint32_t(-1)), _generation(0) {}
+            
+        private:
+            uint32_t    _id;
+            uint32_t    _generation;
+            
+            friend class AnimOutputs;
+        };
+        
+        // Add a value, returning its handle.
+        
+        Handle      add(const T& val = T());
+        
+        // Remove a value.  Removing an invalid handle does nothing.
+        
+        void        remove(Handle);
+        
+        // Return whether the handle refers to a value that has not been
+        // removed.
+        
+        bool        valid(Handle) const;
+        
+        // Access a value, which must be valid.  The version returning a
+        // pointer returns 0 for an invalid handle.
+        
+        T&          operator[](Handle);
+        const T&    operator[](Handle) const;
+        T*          find(Handle);
+        
+        // Return the position of a valid handle's value in the array.  The
+        // position changes when other values are removed.
+        
+        size_t      index(Handle) const;
+        
+        // Access the values in the array, in the order they were added
+        // except where removals moved values.
+        
+        const T*    data() const;
+        size_t      size() const;
+        
+        // Reserve room for a number of values, so adding does not allocate.
+        
+        void        reserve(size_t count);
+        
+    private:
+        
+        // Details of the class' data are "hidden" in the Imp.h file.
+        
+        class Imp;
+        std::unique_ptr<Imp> _m;
+    };
+    
+}
+
+// The template definitions in the following header file should be considered
+// private implementation details.
+
+#include "AutAnimOutputsImp.h"
+
+#endif
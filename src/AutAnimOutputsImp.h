@@ -0,0 +1,186 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutAnimOutputsImp.h
+//
+// The template definitions in the this header file should be considered
+// private implementation details.
+//
+
+#ifndef __AutAnimOutputsImp_h
+#define __AutAnimOutputsImp_h
+
+#include "AutAnimOutputs.h"
+#include <utility>
+#include <vector>
+
+namespace Aut
+{
+    template <typename T>
+    class AnimOutputs<T>::Imp
+    {
+    public:
+        
+        // Each handle's id indexes the slots, which hold the position of the
+        // id's value (if any) and the generation of the id, which is
+        // incremented when the value is removed.  Removed ids are reused
+        // with the next generation, so an old handle does not match them.
+        // An id that reaches the last generation is retired: no handle is
+        // ever made with that generation, and none is valid with it.
+        
+        struct Slot
+        {
+            uint32_t                index;
+            uint32_t                generation;
+        };
+        
+        static const uint32_t retired = uint32_t(-1);
+        
+        bool valid(Handle h) const
+        {
+            return (h._id < slots.size()) && (slots[h._id].generation == h._generation) &&
+                (h._generation != retired);
+        }
+        
+        std::vector<T>              values;
+        std::vector<uint32_t>       ids;
+        std::vector<Slot>           slots;
+        std::vector<uint32_t>       freeIds;
+    };
+    
+    template <typename T>
+    const uint32_t AnimOutputs<T>::Imp::retired;
+    
+    template <typename T>
+    AnimOutputs<T>::AnimOutputs() :
+        _m(new Imp)
+    {
+    }
+    
+    template <typename T>
+    AnimOutputs<T>::~AnimOutputs()
+    {
+    }
+    
+    template <typename T>
+    typename AnimOutputs<T>::Handle AnimOutputs<T>::add(const T& val)
+    {
+        uint32_t id;
+        if (!_m->freeIds.empty())
+        {
+            id = _m->freeIds.back();
+            _m->freeIds.pop_back();
+        }
+        else
+        {
+            id = uint32_t(_m->slots.size());
+            typename Imp::Slot slot = { 0, 0 };
+            _m->slots.push_back(slot);
+        }
+        _m->slots[id].index = uint32_t(_m->values.size());
+        _m->values.push_back(val);
+        _m->ids.push_back(id);
+        
+        Handle h;
+        h._id = id;
+        h._generation = _m->slots[id].generation;
+        return h;
+    }
+    
+    template <typename T>
+    void AnimOutputs<T>::remove(Handle h)
+    {
+        if (!_m->valid(h))
+            return;
+        
+        uint32_t i = _m->slots[h._id].index;
+        uint32_t last = uint32_t(_m->values.size() - 1);
+        if (i != last)
+        {
+            _m->values[i] = std::move(_m->values[last]);
+            _m->ids[i] = _m->ids[last];
+            _m->slots[_m->ids[i]].index = i;
+        }
+        _m->values.pop_back();
+        _m->ids.pop_back();
+        
+        // An id whose generation would wrap around is retired instead of
+        // reused, so no old handle can ever match it.
+        
+        if (++_m->slots[h._id].generation != Imp::retired)
+            _m->freeIds.push_back(h._id);
+    }
+    
+    template <typename T>
+    bool AnimOutputs<T>::valid(Handle h) const
+    {
+        return _m->valid(h);
+    }
+    
+    template <typename T>
+    T& AnimOutputs<T>::operator[](Handle h)
+    {
+        return _m->values[_m->slots[h._id].index];
+    }
+    
+    template <typename T>
+    const T& AnimOutputs<T>::operator[](Handle h) const
+    {
+        return _m->values[_m->slots[h._id].index];
+    }
+    
+    template <typename T>
+    T* AnimOutputs<T>::find(Handle h)
+    {
+        return _m->valid(h) ? &_m->values[_m->slots[h._id].index] : 0;
+    }
+    
+    template <typename T>
+    size_t AnimOutputs<T>::index(Handle h) const
+    {
+        return _m->slots[h._id].index;
+    }
+    
+    template <typename T>
+    const T* AnimOutputs<T>::data() const
+    {
+        return _m->values.data();
+    }
+    
+    template <typename T>
+    size_t AnimOutputs<T>::size() const
+    {
+        return _m->values.size();
+    }
+    
+    template <typename T>
+    void AnimOutputs<T>::reserve(size_t count)
+    {
+        _m->values.reserve(count);
+        _m->ids.reserve(count);
+        _m->slots.reserve(count);
+    }
+    
+}
+
+#endif
@@ -0,0 +1,236 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutAnimScheduler.cpp
+//
+
+#include "AutAnimScheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Aut
+{
+    namespace
+    {
+        // How many times a thread checks for new work (or for the end of the
+        // work) before blocking, which avoids the cost of waking up threads
+        // when eval() is called at a high rate.
+        
+        const int spinCount = 1000;
+        
+        struct Entry
+        {
+            void*                        anim;
+            void (*func)(void*, int, std::chrono::steady_clock::time_point);
+            int                          afterEnd;
+        };
+        
+        // The range of chunks initially assigned to a thread.  Chunks are
+        // claimed by incrementing next, by the owning thread or by a thief,
+        // so each chunk is claimed exactly once.  Padding keeps the ranges of
+        // different threads on different cache lines.
+        
+        struct Range
+        {
+            std::atomic<size_t>          next;
+            size_t                       end;
+            char                         padding[64 - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+        };
+    }
+    
+    class AnimScheduler::Imp
+    {
+    public:
+        Imp(size_t chunk) : chunkSize(chunk > 0 ? chunk : 1), generation(0),
+            pending(0), stopping(false) {}
+        
+        void work(size_t worker);
+        void participate(size_t participant);
+        void evalChunk(size_t chunk);
+        
+        std::vector<Entry>                      entries;
+        size_t                                  chunkSize;
+        std::chrono::steady_clock::time_point   t;
+        
+        std::vector<std::thread>                workers;
+        std::unique_ptr<Range[]>                ranges;
+        
+        // The generation changes when there is new work for the workers,
+        // and pending counts the workers that have not finished it.
+        
+        std::atomic<size_t>                     generation;
+        std::atomic<size_t>                     pending;
+        std::atomic<bool>                       stopping;
+        std::mutex                              startMutex;
+        std::condition_variable                 startCondition;
+        std::mutex                              doneMutex;
+        std::condition_variable                 doneCondition;
+    };
+    
+    void AnimScheduler::Imp::evalChunk(size_t chunk)
+    {
+        size_t begin = chunk * chunkSize;
+        size_t end = std::min(begin + chunkSize, entries.size());
+        for (size_t i = begin; i < end; i++)
+            entries[i].func(entries[i].anim, entries[i].afterEnd, t);
+    }
+    
+    void AnimScheduler::Imp::participate(size_t participant)
+    {
+        size_t participants = workers.size() + 1;
+        for (size_t k = 0; k < participants; k++)
+        {
+            // The first range is the participant's own, and the others are
+            // stolen from.
+            
+            Range& range = ranges[(participant + k) % participants];
+            size_t chunk;
+            while ((chunk = range.next.fetch_add(1, std::memory_order_relaxed)) < range.end)
+                evalChunk(chunk);
+        }
+    }
+    
+    void AnimScheduler::Imp::work(size_t worker)
+    {
+        size_t seen = 0;
+        for (;;)
+        {
+            size_t current = generation.load(std::memory_order_acquire);
+            for (int i = 0; (i < spinCount) && (current == seen); i++)
+            {
+                std::this_thread::yield();
+                current = generation.load(std::memory_order_acquire);
+            }
+            if (current == seen)
+            {
+                std::unique_lock<std::mutex> lock(startMutex);
+                startCondition.wait(lock, [&]
+                {
+                    return generation.load(std::memory_order_acquire) != seen;
+                });
+                current = generation.load(std::memory_order_acquire);
+            }
+            seen = current;
+            
+            if (stopping.load())
+                return;
+            
+            participate(worker + 1);
+            
+            if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                std::lock_guard<std::mutex> lock(doneMutex);
+                doneCondition.notify_one();
+            }
+        }
+    }
+    
+    AnimScheduler::AnimScheduler(size_t threads, size_t chunkSize) :
+        _m(new Imp(chunkSize))
+    {
+        _m->ranges.reset(new Range[threads + 1]);
+        for (size_t i = 0; i < threads; i++)
+            _m->workers.push_back(std::thread(&Imp::work, _m.get(), i));
+    }
+    
+    AnimScheduler::~AnimScheduler()
+    {
+        _m->stopping = true;
+        {
+            std::lock_guard<std::mutex> lock(_m->startMutex);
+            _m->generation++;
+        }
+        _m->startCondition.notify_all();
+        for (std::thread& worker : _m->workers)
+            worker.join();
+    }
+    
+    size_t AnimScheduler::defaultThreads()
+    {
+        unsigned int n = std::thread::hardware_concurrency();
+        return (n > 1) ? n - 1 : 0;
+    }
+    
+    void AnimScheduler::add(void* anim, EvalFunction func, int afterEnd)
+    {
+        Entry entry = { anim, func, afterEnd };
+        _m->entries.push_back(entry);
+    }
+    
+    void AnimScheduler::clear()
+    {
+        _m->entries.clear();
+    }
+    
+    size_t AnimScheduler::size() const
+    {
+        return _m->entries.size();
+    }
+    
+    void AnimScheduler::eval(std::chrono::steady_clock::time_point t)
+    {
+        _m->t = t;
+        size_t chunks = (_m->entries.size() + _m->chunkSize - 1) / _m->chunkSize;
+        
+        // With little work, waking the workers would cost more than it saves.
+        
+        if ((chunks <= 1) || _m->workers.empty())
+        {
+            for (size_t chunk = 0; chunk < chunks; chunk++)
+                _m->evalChunk(chunk);
+            return;
+        }
+        
+        size_t participants = _m->workers.size() + 1;
+        for (size_t p = 0; p < participants; p++)
+        {
+            _m->ranges[p].next.store(chunks * p / participants, std::memory_order_relaxed);
+            _m->ranges[p].end = chunks * (p + 1) / participants;
+        }
+        _m->pending.store(_m->workers.size(), std::memory_order_relaxed);
+        
+        {
+            std::lock_guard<std::mutex> lock(_m->startMutex);
+            _m->generation.fetch_add(1, std::memory_order_release);
+        }
+        _m->startCondition.notify_all();
+        
+        _m->participate(0);
+        
+        for (int i = 0; (i < spinCount) && (_m->pending.load(std::memory_order_acquire) != 0); i++)
+            std::this_thread::yield();
+        if (_m->pending.load(std::memory_order_acquire) != 0)
+        {
+            std::unique_lock<std::mutex> lock(_m->doneMutex);
+            _m->doneCondition.wait(lock, [&]
+            {
+                return _m->pending.load(std::memory_order_acquire) == 0;
+            });
+        }
+    }
+    
+}
@@ -0,0 +1,130 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutAnimScheduler.h
+//
+// A class for evaluating large sets of independent animations in parallel.
+// The animations are split into chunks, which are evaluated by a pool of
+// worker threads (and the thread calling eval()); a thread that finishes its
+// own chunks steals chunks that other threads have not started yet.
+//
+
+#ifndef __AutAnimScheduler__
+#define __AutAnimScheduler__
+
+#include "AutAnim.h"
+#include <chrono>
+#include <memory>
+
+namespace Aut
+{
+    
+    class AnimScheduler
+    {
+    public:
+        
+        // The worker threads are created by the constructor.  By default,
+        // there is one per hardware thread other than the thread calling
+        // eval().  Animations are evaluated in chunks of the specified size.
+        
+        AnimScheduler(size_t threads = defaultThreads(), size_t chunkSize = 256);
+        ~AnimScheduler();
+        
+        static size_t defaultThreads();
+        
+        // Add an animation, or a contiguous array of animations, to be
+        // evaluated with the specified treatment of times after the end.  The
+        // animations must outlive the scheduler (or the next call to clear()),
+        // and no two of them may animate the same variable, since they may be
+        // evaluated at the same time by different threads.
+        
+        template <typename T, typename Ease>
+        void    add(Anim<T, Ease>& anim,
+                    typename Anim<T, Ease>::EvalAfterEnd afterEnd =
+                    Anim<T, Ease>::RestartAfterEnd);
+        
+        template <typename T, typename Ease>
+        void    add(Anim<T, Ease>* anims, size_t count,
+                    typename Anim<T, Ease>::EvalAfterEnd afterEnd =
+                    Anim<T, Ease>::RestartAfterEnd);
+        
+        // Remove all the animations.
+        
+        void    clear();
+        
+        // Return the number of animations that have been added.
+        
+        size_t  size() const;
+        
+        // Evaluate every animation exactly once, as of the specified time,
+        // returning when all the evaluations are done.  The results are the
+        // same as evaluating the animations one after another on one thread.
+        
+        void    eval(std::chrono::steady_clock::time_point t =
+                     std::chrono::steady_clock::now());
+        
+    private:
+        
+        // Animations of different types are evaluated through functions that
+        // restore the type.
+        
+        typedef void (*EvalFunction)(void* anim, int afterEnd,
+                                     std::chrono::steady_clock::time_point t);
+        
+        template <typename T, typename Ease>
+        static void evalAnim(void* anim, int afterEnd,
+                             std::chrono::steady_clock::time_point t);
+        
+        void    add(void* anim, EvalFunction func, int afterEnd);
+        
+        // Details of the class' data are "hidden" in the .cpp file.
+        
+        class Imp;
+        std::unique_ptr<Imp> _m;
+    };
+    
+    template <typename T, typename Ease>
+    void AnimScheduler::evalAnim(void* anim, int afterEnd,
+                                 std::chrono::steady_clock::time_point t)
+    {
+        static_cast<Anim<T, Ease>*>(anim)->eval(t, typename Anim<T, Ease>::EvalAfterEnd(afterEnd));
+    }
+    
+    template <typename T, typename Ease>
+    void AnimScheduler::add(Anim<T, Ease>& anim,
+                            typename Anim<T, Ease>::EvalAfterEnd afterEnd)
+    {
+        add(&anim, &evalAnim<T, Ease>, afterEnd);
+    }
+    
+    template <typename T, typename Ease>
+    void AnimScheduler::add(Anim<T, Ease>* anims, size_t count,
+                            typename Anim<T, Ease>::EvalAfterEnd afterEnd)
+    {
+        for (size_t i = 0; i < count; i++)
+            add(&anims[i], &evalAnim<T, Ease>, afterEnd);
+    }
+    
+}
+
+#endif
@@ -0,0 +1,100 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutAnimSystem.h
+//
+// A template class for evaluating many animations of variables of the same
+// type, with the same easing policy, at once.  Each animation (a "track") is specified and behaves like an
+// Aut::Anim<T>, but the data for all the tracks is stored in contiguous arrays
+// so a single call evaluates every track in a few tight passes, which the
+// compiler (or explicit SSE code, for float) can vectorize.
+//
+
+#ifndef __AutAnimSystem__
+#define __AutAnimSystem__
+
+#include "AutAnim.h"
+#include <chrono>
+#include <vector>
+#include <memory>
+
+namespace Aut
+{
+    
+    template <typename T, typename Ease = FastCosineEase>
+    class AnimSystem
+    {
+    public:
+        
+        AnimSystem();
+        ~AnimSystem();
+        
+        // Add a track, specified as a sequence of segments as for
+        // Anim<T>::set().  The returned index identifies the track in the
+        // other routines.  The track is not running until it is started.
+        
+        size_t  add(const std::vector<typename Anim<T, Ease>::Segment>& segments);
+        
+        // Return the number of tracks that have been added.
+        
+        size_t  size() const;
+        
+        // Start a track as of the specified time.
+        
+        void    start(size_t track, std::chrono::steady_clock::time_point t0 =
+                      std::chrono::steady_clock::now());
+        
+        // Stop a track.
+        
+        void    stop(size_t track);
+        
+        // Return whether a track is running or not.
+        
+        bool    running(size_t track) const;
+        
+        // Evaluate all the running tracks as of the specified time, with the
+        // same treatment of times after the end of a track as Anim<T>::eval().
+        // The easing for all the tracks is computed in one pass, which uses
+        // SSE for the default FastCosineEase policy.
+        
+        void    eval(std::chrono::steady_clock::time_point t =
+                     std::chrono::steady_clock::now(),
+                     typename Anim<T, Ease>::EvalAfterEnd afterEnd =
+                     Anim<T, Ease>::RestartAfterEnd);
+        
+    private:
+        
+        // Details of the class' data are "hidden" in the Imp.h file.
+        
+        class Imp;
+        std::unique_ptr<Imp> _m;
+    };
+    
+}
+
+// The template definitions in the following header file should be considered
+// private implementation details.
+
+#include "AutAnimSystemImp.h"
+
+#endif
@@ -0,0 +1,375 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutAnimSystemImp.h
+//
+// The template definitions in the this header file should be considered
+// private implementation details.
+//
+
+#ifndef __AutAnimSystemImp_h
+#define __AutAnimSystemImp_h
+
+#include "AutAnimSystem.h"
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+namespace Aut
+{
+    // Compute the ease weight for each track, given the elapsed time and the
+    // beginning time and inverse duration of the track's current segment.
+    
+    template <typename Ease>
+    struct AnimSystemWeights
+    {
+        static void eval(const float* elapsed, const float* begin,
+                         const float* invDuration, float* weight, size_t n)
+        {
+            for (size_t i = 0; i < n; i++)
+                weight[i] = Ease::eval((elapsed[i] - begin[i]) * invDuration[i]);
+        }
+    };
+    
+    // For the default policy, the polynomial is evaluated four tracks at a time
+    // with SSE.
+    
+    template <>
+    struct AnimSystemWeights<FastCosineEase>
+    {
+        static void eval(const float* elapsed, const float* begin,
+                         const float* invDuration, float* weight, size_t n)
+        {
+            size_t i = 0;
+            
+#if defined(__SSE__)
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps(1.0f);
+            const __m128 half = _mm_set1_ps(0.5f);
+            const __m128 c1 = _mm_set1_ps(FastCosineEase::c1);
+            const __m128 c3 = _mm_set1_ps(FastCosineEase::c3);
+            const __m128 c5 = _mm_set1_ps(FastCosineEase::c5);
+            const __m128 c7 = _mm_set1_ps(FastCosineEase::c7);
+            
+            for (; i + 4 <= n; i += 4)
+            {
+                __m128 u = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(elapsed + i),
+                                                 _mm_loadu_ps(begin + i)),
+                                      _mm_loadu_ps(invDuration + i));
+                __m128 x = _mm_sub_ps(u, half);
+                __m128 x2 = _mm_mul_ps(x, x);
+                __m128 p = _mm_add_ps(c5, _mm_mul_ps(x2, c7));
+                p = _mm_add_ps(c3, _mm_mul_ps(x2, p));
+                p = _mm_add_ps(c1, _mm_mul_ps(x2, p));
+                __m128 w = _mm_add_ps(half, _mm_mul_ps(x, p));
+                w = _mm_min_ps(_mm_max_ps(w, zero), one);
+                
+                __m128 atEnd = _mm_cmpge_ps(u, one);
+                w = _mm_or_ps(_mm_and_ps(atEnd, one), _mm_andnot_ps(atEnd, w));
+                __m128 atBegin = _mm_cmple_ps(u, zero);
+                w = _mm_andnot_ps(atBegin, w);
+                
+                _mm_storeu_ps(weight + i, w);
+            }
+#endif
+            
+            for (; i < n; i++)
+                weight[i] = FastCosineEase::eval((elapsed[i] - begin[i]) * invDuration[i]);
+        }
+    };
+    
+    // Interpolate between the beginning and ending values of each track's
+    // current segment.
+    
+    template <typename T>
+    void animSystemLerp(const float* weight, const T* val0, const T* val1,
+                        T* result, size_t n)
+    {
+        for (size_t i = 0; i < n; i++)
+            result[i] = AnimTraits<T>::interp(val0[i], val1[i], weight[i]);
+    }
+    
+    inline void animSystemLerp(const float* weight, const float* val0,
+                               const float* val1, float* result, size_t n)
+    {
+        size_t i = 0;
+        
+#if defined(__SSE__)
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128 a = _mm_loadu_ps(val0 + i);
+            __m128 b = _mm_loadu_ps(val1 + i);
+            __m128 w = _mm_loadu_ps(weight + i);
+            _mm_storeu_ps(result + i, _mm_add_ps(a, _mm_mul_ps(w, _mm_sub_ps(b, a))));
+        }
+#endif
+        
+        for (; i < n; i++)
+            result[i] = val0[i] + weight[i] * (val1[i] - val0[i]);
+    }
+    
+    //
+    
+    template <typename T, typename Ease>
+    class AnimSystem<T, Ease>::Imp
+    {
+    public:
+        void activate(size_t track, size_t segment);
+        void seek(size_t track, float elapsed);
+        
+        // The data for each segment, in milliseconds from the start of the
+        // track.  The segments of each track are contiguous.
+        
+        std::vector<float>                                  segBegin;
+        std::vector<float>                                  segEnd;
+        std::vector<T>                                      segVal0;
+        std::vector<T>                                      segVal1;
+        std::vector<T*>                                     segVar;
+        
+        // The data for each track.  The cursor is the index of the current
+        // segment, which usually changes only by moving to the next one, or
+        // to the previous one when playing backward.
+        
+        std::vector<size_t>                                 first;
+        std::vector<size_t>                                 last;
+        std::vector<size_t>                                 cursor;
+        std::vector<std::chrono::steady_clock::time_point>  t0;
+        std::vector<char>                                   running;
+        std::vector<char>                                   reversed;
+        
+        // The data for the current segment of each track, and space for the
+        // intermediate results of evaluation.
+        
+        std::vector<float>                                  begin;
+        std::vector<float>                                  invDuration;
+        std::vector<T>                                      val0;
+        std::vector<T>                                      val1;
+        std::vector<T*>                                     var;
+        std::vector<float>                                  elapsed;
+        std::vector<float>                                  weight;
+        std::vector<T>                                      result;
+        std::vector<char>                                   write;
+    };
+    
+    template <typename T, typename Ease>
+    void AnimSystem<T, Ease>::Imp::activate(size_t track, size_t segment)
+    {
+        cursor[track] = segment;
+        begin[track] = segBegin[segment];
+        float duration = segEnd[segment] - segBegin[segment];
+        invDuration[track] = (duration > 0.0f) ? 1.0f / duration : FLT_MAX;
+        val0[track] = segVal0[segment];
+        val1[track] = segVal1[segment];
+        var[track] = segVar[segment];
+    }
+    
+    template <typename T, typename Ease>
+    void AnimSystem<T, Ease>::Imp::seek(size_t track, float e)
+    {
+        // As for Anim<T>, reversing usually moves to the previous segment,
+        // and a larger step back is found with a binary search, to keep
+        // playing backward from costing time quadratic in the segments.
+        
+        size_t segment = cursor[track];
+        if (e < segBegin[segment])
+        {
+            if ((segment > first[track]) && (e >= segBegin[segment - 1]))
+                segment--;
+            else
+                segment = std::upper_bound(segEnd.begin() + first[track],
+                                           segEnd.begin() + last[track], e) - segEnd.begin();
+        }
+        while ((segment < last[track]) && (segEnd[segment] <= e))
+            segment++;
+        if (segment != cursor[track])
+            activate(track, segment);
+    }
+    
+    template <typename T, typename Ease>
+    AnimSystem<T, Ease>::AnimSystem() :
+        _m(new Imp)
+    {
+    }
+    
+    template <typename T, typename Ease>
+    AnimSystem<T, Ease>::~AnimSystem()
+    {
+    }
+    
+    template <typename T, typename Ease>
+    size_t AnimSystem<T, Ease>::add(const std::vector<typename Anim<T, Ease>::Segment>& segments)
+    {
+        size_t track = _m->first.size();
+        size_t first = _m->segBegin.size();
+        
+        float t = 0.0f;
+        for (const typename Anim<T, Ease>::Segment& segment : segments)
+        {
+            _m->segBegin.push_back(t);
+            t += std::chrono::duration<float, std::milli>(segment.duration()).count();
+            _m->segEnd.push_back(t);
+            _m->segVal0.push_back(segment.value0());
+            _m->segVal1.push_back(segment.value1());
+            _m->segVar.push_back(segment.variable());
+        }
+        if (segments.empty())
+        {
+            _m->segBegin.push_back(0.0f);
+            _m->segEnd.push_back(0.0f);
+            _m->segVal0.push_back(T());
+            _m->segVal1.push_back(T());
+            _m->segVar.push_back(0);
+        }
+        
+        _m->first.push_back(first);
+        _m->last.push_back(_m->segBegin.size() - 1);
+        _m->cursor.push_back(first);
+        _m->t0.push_back(std::chrono::steady_clock::time_point());
+        _m->running.push_back(0);
+        _m->reversed.push_back(0);
+        
+        _m->begin.push_back(0.0f);
+        _m->invDuration.push_back(0.0f);
+        _m->val0.push_back(T());
+        _m->val1.push_back(T());
+        _m->var.push_back(0);
+        _m->elapsed.push_back(0.0f);
+        _m->weight.push_back(0.0f);
+        _m->result.push_back(T());
+        _m->write.push_back(0);
+        
+        _m->activate(track, first);
+        return track;
+    }
+    
+    template <typename T, typename Ease>
+    size_t AnimSystem<T, Ease>::size() const
+    {
+        return _m->first.size();
+    }
+    
+    template <typename T, typename Ease>
+    void AnimSystem<T, Ease>::start(size_t track, std::chrono::steady_clock::time_point t0)
+    {
+        // As with Anim<T>, a track with no segments (or no variable to animate)
+        // cannot be started.
+        
+        if (_m->segVar[_m->first[track]])
+        {
+            _m->running[track] = 1;
+            _m->reversed[track] = 0;
+            _m->t0[track] = t0;
+            _m->activate(track, _m->first[track]);
+        }
+    }
+    
+    template <typename T, typename Ease>
+    void AnimSystem<T, Ease>::stop(size_t track)
+    {
+        _m->running[track] = 0;
+    }
+    
+    template <typename T, typename Ease>
+    bool AnimSystem<T, Ease>::running(size_t track) const
+    {
+        return _m->running[track] != 0;
+    }
+    
+    template <typename T, typename Ease>
+    void AnimSystem<T, Ease>::eval(std::chrono::steady_clock::time_point t,
+                                   typename Anim<T, Ease>::EvalAfterEnd afterEnd)
+    {
+        size_t n = _m->first.size();
+        
+        // The first pass finds the current segment of each running track,
+        // which for time moving forward is usually the same as last time.
+        
+        for (size_t i = 0; i < n; i++)
+        {
+            _m->write[i] = _m->running[i];
+            if (!_m->running[i])
+            {
+                _m->elapsed[i] = _m->begin[i];
+                continue;
+            }
+            
+            // Converting through double keeps whole milliseconds exact, so
+            // segment boundaries are found at the same times as by Anim<T>.
+            
+            double elapsed = std::chrono::duration<double, std::milli>(t - _m->t0[i]).count();
+            float end = _m->segEnd[_m->last[i]];
+            if (elapsed >= end)
+            {
+                // As with Anim<T>, the phase of a cycling track is the time
+                // since the start modulo the track's duration, and with no
+                // duration to cycle through, a cycling track keeps running,
+                // holding its final value.
+                
+                if (afterEnd == Anim<T, Ease>::StopAfterEnd)
+                {
+                    _m->running[i] = 0;
+                }
+                else if (end > 0.0f)
+                {
+                    double cycles = floor(elapsed / end);
+                    _m->t0[i] += std::chrono::duration_cast<std::chrono::steady_clock::duration>
+                        (std::chrono::duration<double, std::milli>(cycles * end));
+                    elapsed = std::chrono::duration<double, std::milli>(t - _m->t0[i]).count();
+                    if ((afterEnd == Anim<T, Ease>::PingPongAfterEnd) && (fmod(cycles, 2.0) == 1.0))
+                        _m->reversed[i] = !_m->reversed[i];
+                    else if (afterEnd != Anim<T, Ease>::PingPongAfterEnd)
+                        _m->reversed[i] = 0;
+                }
+            }
+            
+            float e = float(elapsed);
+            if (e < 0.0f)
+                e = 0.0f;
+            if (_m->reversed[i])
+                e = (e >= end) ? 0.0f : end - e;
+            
+            _m->seek(i, e);
+            _m->elapsed[i] = (e >= end) ? FLT_MAX : e;
+        }
+        
+        // The remaining passes work on all tracks, running or not, so they
+        // involve no branches and can be vectorized.
+        
+        AnimSystemWeights<Ease>::eval(_m->elapsed.data(), _m->begin.data(),
+                                      _m->invDuration.data(), _m->weight.data(), n);
+        animSystemLerp(_m->weight.data(), _m->val0.data(), _m->val1.data(),
+                       _m->result.data(), n);
+        
+        for (size_t i = 0; i < n; i++)
+        {
+            if (_m->write[i])
+                *_m->var[i] = _m->result[i];
+        }
+    }
+}
+
+#endif
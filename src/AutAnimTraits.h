@@ -0,0 +1,71 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutAnimTraits.h
+//
+// The interpolation used by the animation classes for values of type T, and
+// the distance between values used when approximating animations.  The
+// default interpolates linearly, as val0 + w * (val1 - val0), which needs T
+// to support addition, subtraction and multiplication by a float, and
+// measures distance as the absolute difference, which needs T to convert to
+// double.  Additive blending applies a fraction w of a delta as
+// val + w * delta.  Types for which that is not right (e.g., vectors or rotations)
+// specialize AnimTraits<T>.
+//
+
+#ifndef __AutAnimTraits__
+#define __AutAnimTraits__
+
+#include <math.h>
+
+namespace Aut
+{
+    
+    template <typename T>
+    struct AnimTraits
+    {
+        // Return the value a fraction w of the way from val0 to val1.
+        
+        static T interp(const T& val0, const T& val1, float w)
+        {
+            return val0 + w * (val1 - val0);
+        }
+        
+        // Return the distance between two values.
+        
+        static float distance(const T& val0, const T& val1)
+        {
+            return float(fabs(double(val1) - double(val0)));
+        }
+        
+        // Return the value with a fraction w of the delta added to it.
+        
+        static T add(const T& val, const T& delta, float w)
+        {
+            return val + w * delta;
+        }
+    };
+    
+}
+
+#endif
@@ -0,0 +1,106 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutBakedAnim.h
+//
+// A template class for playing an animation that has been sampled ("baked")
+// into a table of values, made with Aut::Anim<T>::bake().  Evaluating a baked
+// animation costs an index computation and a linear interpolation between two
+// samples, with no easing function and no search of segments, trading memory
+// for time.  Baking can also drop samples that linear interpolation between
+// their neighbors reproduces within a tolerance, so flat or linear stretches
+// of an animation need few samples; evaluation then finds the samples around
+// a time through a coarse, evenly spaced index, which is nearly as cheap.
+//
+
+#ifndef __AutBakedAnim__
+#define __AutBakedAnim__
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace Aut
+{
+    
+    template <typename T, typename Ease> class Anim;
+    
+    template <typename T>
+    class BakedAnim
+    {
+    public:
+        
+        // A baked animation made by default, or moved from, has no samples
+        // and no variable, so it does not start.
+        
+        BakedAnim();
+        BakedAnim(BakedAnim&& other);
+        ~BakedAnim();
+        
+        BakedAnim& operator=(BakedAnim&& other);
+        
+        // Return the number of samples kept, and the duration.
+        
+        size_t  size() const;
+        std::chrono::steady_clock::duration duration() const;
+        
+        // Access the variable being animated, which is that of the first
+        // segment of the animation that was baked.
+        
+        T*      variable() const;
+        void    setVariable(T* val);
+        
+        // Start, stop and check the animation, as for Aut::Anim<T>.
+        
+        void    start(std::chrono::steady_clock::time_point t0 =
+                      std::chrono::steady_clock::now());
+        void    stop();
+        bool    running() const;
+        
+        // Evaluate the animation as of the specified time, as for
+        // Aut::Anim<T>.
+        
+        enum EvalAfterEnd { RestartAfterEnd, StopAfterEnd, PingPongAfterEnd };
+        
+        void    eval(std::chrono::steady_clock::time_point t =
+                     std::chrono::steady_clock::now(),
+                     EvalAfterEnd afterEnd = RestartAfterEnd);
+        
+    private:
+        
+        // Details of the class' data are "hidden" in the Imp.h file.
+        
+        class Imp;
+        std::unique_ptr<Imp> _m;
+        
+        template <typename U, typename Ease> friend class Anim;
+    };
+    
+}
+
+// The template definitions in the following header file should be considered
+// private implementation details.
+
+#include "AutBakedAnimImp.h"
+
+#endif
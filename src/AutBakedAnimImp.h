@@ -0,0 +1,319 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutBakedAnimImp.h
+//
+// The template definitions in the this header file should be considered
+// private implementation details.
+//
+
+#ifndef __AutBakedAnimImp_h
+#define __AutBakedAnimImp_h
+
+#include "AutBakedAnim.h"
+#include "AutAnimTraits.h"
+
+namespace Aut
+{
+    template <typename T>
+    class BakedAnim<T>::Imp
+    {
+    public:
+        Imp() : val(0), step(0.0f), invStep(0.0f), invCell(0.0f),
+            total(std::chrono::steady_clock::duration::zero()), running(false), reversed(false) {}
+        
+        void build(std::vector<T>&& samples, float tolerance);
+        bool fits(const std::vector<T>& samples, size_t a, size_t b, float tolerance) const;
+        bool eval(std::chrono::steady_clock::time_point t);
+        void finish();
+        
+        // The values of the samples, evenly spaced by step seconds if times
+        // is empty, or at the times (in seconds) otherwise.  For uneven
+        // spacing, the time is divided into evenly spaced cells, each with
+        // the index of the last sample at or before its beginning, so finding
+        // the samples around a time starts with an index computation.
+        
+        T*                                      val;
+        std::vector<T>                          values;
+        std::vector<float>                      times;
+        std::vector<size_t>                     cells;
+        float                                   step;
+        float                                   invStep;
+        float                                   invCell;
+        std::chrono::steady_clock::duration     total;
+        std::chrono::steady_clock::time_point   t0;
+        bool                                    running;
+        bool                                    reversed;
+    };
+    
+    // Return whether linear interpolation between samples a and b reproduces
+    // the samples between them within the tolerance.
+    
+    template <typename T>
+    bool BakedAnim<T>::Imp::fits(const std::vector<T>& samples, size_t a, size_t b,
+                                 float tolerance) const
+    {
+        float inv = 1.0f / float(b - a);
+        for (size_t i = a + 1; i < b; i++)
+        {
+            T approx = AnimTraits<T>::interp(samples[a], samples[b], float(i - a) * inv);
+            if (AnimTraits<T>::distance(approx, samples[i]) > tolerance)
+                return false;
+        }
+        return true;
+    }
+    
+    template <typename T>
+    void BakedAnim<T>::Imp::build(std::vector<T>&& samples, float tolerance)
+    {
+        float seconds = std::chrono::duration<float>(total).count();
+        step = seconds / float(samples.size() - 1);
+        invStep = (step > 0.0f) ? 1.0f / step : 0.0f;
+        times.clear();
+        cells.clear();
+        
+        if (tolerance <= 0.0f)
+        {
+            values = std::move(samples);
+            return;
+        }
+        
+        // Each kept sample is followed by a far sample that linear
+        // interpolation can reach without missing the samples in between.
+        // Checking a span costs its length, so rather than trying each
+        // sample in turn, which would cost the square of the span, the
+        // search doubles its step while the spans fit and then halves it,
+        // checking a logarithmic number of spans.
+        
+        std::vector<size_t> kept(1, 0);
+        size_t last = samples.size() - 1;
+        for (size_t a = 0; a < last; )
+        {
+            size_t b = a + 1;
+            size_t jump = 1;
+            bool growing = true;
+            while (jump > 0)
+            {
+                if ((jump <= last - b) && fits(samples, a, b + jump, tolerance))
+                {
+                    b += jump;
+                    if (growing)
+                        jump *= 2;
+                }
+                else
+                {
+                    growing = false;
+                    jump /= 2;
+                }
+            }
+            kept.push_back(b);
+            a = b;
+        }
+        
+        if (kept.size() == samples.size())
+        {
+            values = std::move(samples);
+            return;
+        }
+        
+        values.clear();
+        values.reserve(kept.size());
+        times.reserve(kept.size());
+        for (size_t i : kept)
+        {
+            values.push_back(samples[i]);
+            times.push_back((i == last) ? seconds : float(i) * step);
+        }
+        
+        size_t cellCount = values.size();
+        invCell = float(cellCount) / seconds;
+        cells.reserve(cellCount);
+        size_t k = 0;
+        for (size_t c = 0; c < cellCount; c++)
+        {
+            float begin = float(c) / invCell;
+            while ((k + 1 < times.size() - 1) && (times[k + 1] <= begin))
+                k++;
+            cells.push_back(k);
+        }
+    }
+    
+    template <typename T>
+    bool BakedAnim<T>::Imp::eval(std::chrono::steady_clock::time_point t)
+    {
+        std::chrono::steady_clock::duration e = t - t0;
+        if (e >= total)
+            return false;
+        if (e < std::chrono::steady_clock::duration::zero())
+            e = std::chrono::steady_clock::duration::zero();
+        if (reversed)
+            e = total - e;
+        float p = std::chrono::duration<float>(e).count();
+        
+        size_t i;
+        float w;
+        if (times.empty())
+        {
+            float x = p * invStep;
+            i = size_t(x);
+            if (i >= values.size() - 1)
+            {
+                *val = values.back();
+                return true;
+            }
+            w = x - float(i);
+        }
+        else
+        {
+            size_t last = times.size() - 1;
+            if (p >= times[last])
+            {
+                *val = values.back();
+                return true;
+            }
+            size_t c = size_t(p * invCell);
+            i = cells[(c < cells.size()) ? c : cells.size() - 1];
+            while (times[i + 1] <= p)
+                i++;
+            while ((i > 0) && (times[i] > p))
+                i--;
+            w = (p - times[i]) / (times[i + 1] - times[i]);
+        }
+        
+        *val = AnimTraits<T>::interp(values[i], values[i + 1], w);
+        return true;
+    }
+    
+    template <typename T>
+    void BakedAnim<T>::Imp::finish()
+    {
+        *val = reversed ? values.front() : values.back();
+        running = false;
+    }
+    
+    template <typename T>
+    BakedAnim<T>::BakedAnim() :
+        _m(new Imp)
+    {
+    }
+    
+    template <typename T>
+    BakedAnim<T>::BakedAnim(BakedAnim&& other) :
+        _m(std::move(other._m))
+    {
+        other._m.reset(new Imp);
+    }
+    
+    template <typename T>
+    BakedAnim<T>::~BakedAnim()
+    {
+    }
+    
+    template <typename T>
+    BakedAnim<T>& BakedAnim<T>::operator=(BakedAnim&& other)
+    {
+        if (&other != this)
+        {
+            _m = std::move(other._m);
+            other._m.reset(new Imp);
+        }
+        return *this;
+    }
+    
+    template <typename T>
+    size_t BakedAnim<T>::size() const
+    {
+        return _m->values.size();
+    }
+    
+    template <typename T>
+    std::chrono::steady_clock::duration BakedAnim<T>::duration() const
+    {
+        return _m->total;
+    }
+    
+    template <typename T>
+    T* BakedAnim<T>::variable() const
+    {
+        return _m->val;
+    }
+    
+    template <typename T>
+    void BakedAnim<T>::setVariable(T* val)
+    {
+        _m->val = val;
+    }
+    
+    template <typename T>
+    void BakedAnim<T>::start(std::chrono::steady_clock::time_point t0)
+    {
+        if (_m->val && !_m->values.empty())
+        {
+            _m->running = true;
+            _m->reversed = false;
+            _m->t0 = t0;
+        }
+    }
+    
+    template <typename T>
+    void BakedAnim<T>::stop()
+    {
+        _m->running = false;
+    }
+    
+    template <typename T>
+    bool BakedAnim<T>::running() const
+    {
+        return _m->running;
+    }
+    
+    template <typename T>
+    void BakedAnim<T>::eval(std::chrono::steady_clock::time_point t, EvalAfterEnd afterEnd)
+    {
+        if (!_m->running || _m->eval(t))
+            return;
+        
+        // As with Aut::Anim<T>, the phase of a cycling animation is the time
+        // since the start modulo the duration.
+        
+        if ((afterEnd == StopAfterEnd) ||
+            (_m->total == std::chrono::steady_clock::duration::zero()))
+        {
+            _m->finish();
+            if (afterEnd != StopAfterEnd)
+                _m->running = true;
+            return;
+        }
+        
+        std::chrono::steady_clock::rep cycles = (t - _m->t0) / _m->total;
+        _m->t0 += _m->total * cycles;
+        if (afterEnd == PingPongAfterEnd)
+            _m->reversed = (_m->reversed != (cycles % 2 == 1));
+        else
+            _m->reversed = false;
+        (void) _m->eval(t);
+    }
+    
+}
+
+#endif
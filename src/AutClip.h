@@ -0,0 +1,267 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutClip.h
+//
+// Template classes for storing animation segments in a compact binary file
+// (a "clip file") and playing them directly from a memory mapping of that
+// file.  A clip is a sequence of segments, like the segments of Aut::Anim<T>
+// but without the variable being animated, and with the easing of each
+// segment stored as a tag.  A file holds any number of clips with values of
+// one type.  Reading a file maps it and checks its header; the segments are
+// never copied, so loading many clips costs little more than opening a file.
+//
+// The format is versioned, and uses the native byte order and layout of the
+// value type, so a file is portable only between similar platforms.
+//
+
+#ifndef __AutClip__
+#define __AutClip__
+
+#include "AutAnim.h"
+#include "AutEase.h"
+#include "AutVec.h"
+#include <chrono>
+#include <memory>
+#include <string>
+#include <stdint.h>
+
+namespace Aut
+{
+    
+    // The tags for the easing of segments in clips, for the policies of
+    // AutEase.h.  The values are part of the file format.
+    
+    enum ClipEase
+    {
+        ClipLinear = 0,
+        ClipStep = 1,
+        ClipSmoothstep = 2,
+        ClipCosine = 3,
+        ClipFastCosine = 4,
+        ClipBezier = 5,
+        ClipBezierIn = 6,
+        ClipBezierOut = 7,
+        ClipBezierInOut = 8
+    };
+    
+    // Evaluate the easing policy with the specified tag.
+    
+    inline float clipEase(ClipEase ease, float s);
+    
+    // The tag for an easing policy.  Only the policies with tags can be
+    // stored in clips.
+    
+    template <typename Ease> struct ClipEaseTag;
+    
+    template <> struct ClipEaseTag<LinearEase>      { static const ClipEase value = ClipLinear; };
+    template <> struct ClipEaseTag<StepEase>        { static const ClipEase value = ClipStep; };
+    template <> struct ClipEaseTag<SmoothstepEase>  { static const ClipEase value = ClipSmoothstep; };
+    template <> struct ClipEaseTag<CosineEase>      { static const ClipEase value = ClipCosine; };
+    template <> struct ClipEaseTag<FastCosineEase>  { static const ClipEase value = ClipFastCosine; };
+    template <> struct ClipEaseTag<BezierEase>      { static const ClipEase value = ClipBezier; };
+    template <> struct ClipEaseTag<BezierEaseIn>    { static const ClipEase value = ClipBezierIn; };
+    template <> struct ClipEaseTag<BezierEaseOut>   { static const ClipEase value = ClipBezierOut; };
+    template <> struct ClipEaseTag<BezierEaseInOut> { static const ClipEase value = ClipBezierInOut; };
+    
+    // The tag for the type of the values in a clip file, which is checked
+    // (along with the size of the type) when the file is read.  Types without
+    // a specific tag have the tag 0, and are checked only by size.  The
+    // values are part of the file format.
+    
+    template <typename T> struct ClipValueType  { static const uint16_t value = 0; };
+    
+    template <> struct ClipValueType<float>     { static const uint16_t value = 1; };
+    template <> struct ClipValueType<double>    { static const uint16_t value = 2; };
+    template <> struct ClipValueType<int32_t>   { static const uint16_t value = 3; };
+    template <> struct ClipValueType<Quat>      { static const uint16_t value = 4; };
+    
+    template <size_t N> struct ClipValueType<Vec<N>> { static const uint16_t value = 0x100 + N; };
+    
+    // The layout of a segment in a clip file.
+    
+    template <typename T> struct ClipRecord;
+    
+    // A clip, as a view of segments stored elsewhere (in a ClipFile<T> or a
+    // ClipWriter<T>), which must outlive it.  Clips are plain values, cheap
+    // to copy.
+    
+    template <typename T>
+    class Clip
+    {
+    public:
+        
+        Clip();
+        
+        // Return the number of segments, and the total duration.
+        
+        size_t                              size() const;
+        std::chrono::steady_clock::duration duration() const;
+        
+        // Access the beginning and ending values, duration and easing of a
+        // segment.
+        
+        T                                   value0(size_t i) const;
+        T                                   value1(size_t i) const;
+        std::chrono::steady_clock::duration duration(size_t i) const;
+        ClipEase                            ease(size_t i) const;
+        
+    private:
+        
+        Clip(const ClipRecord<T>* records, size_t size);
+        
+        const ClipRecord<T>*                _records;
+        size_t                              _size;
+        
+        template <typename U> friend class ClipWriter;
+        template <typename U> friend class ClipFile;
+        template <typename U> friend class ClipPlayer;
+    };
+    
+    // Building and writing a clip file.
+    
+    template <typename T>
+    class ClipWriter
+    {
+    public:
+        
+        ClipWriter();
+        ~ClipWriter();
+        
+        // Begin a new clip, returning its index, then append segments to it.
+        
+        size_t  beginClip();
+        void    addSegment(const T& val0, const T& val1,
+                           std::chrono::steady_clock::duration duration,
+                           ClipEase ease = ClipFastCosine);
+        
+        // Add a clip with the segments of an animation, returning its index.
+        
+        template <typename Ease>
+        size_t  addClip(const Anim<T, Ease>& anim);
+        
+        // Return the number of clips, and a clip, which is valid until the
+        // next change to the writer.
+        
+        size_t  size() const;
+        Clip<T> clip(size_t i) const;
+        
+        // Write the clips to a file, returning false (after reporting the
+        // problem with Aut::error()) if the file cannot be written.
+        
+        bool    write(const std::string& path) const;
+        
+    private:
+        
+        // Details of the class' data are "hidden" in the Imp.h file.
+        
+        class Imp;
+        std::unique_ptr<Imp> _m;
+    };
+    
+    // Reading a clip file.
+    
+    template <typename T>
+    class ClipFile
+    {
+    public:
+        
+        // Map the file at the specified path.  If the file cannot be mapped,
+        // or its header does not match the format, version and value type,
+        // the problem is reported with Aut::error() and the file has no clips.
+        
+        ClipFile(const std::string& path);
+        ~ClipFile();
+        
+        // Return whether the file was mapped and matched the format.
+        
+        bool    valid() const;
+        
+        // Return the number of clips, and a clip, which is valid for the
+        // lifetime of this instance.
+        
+        size_t  size() const;
+        Clip<T> clip(size_t i) const;
+        
+    private:
+        
+        // Details of the class' data are "hidden" in the Imp.h file.
+        
+        class Imp;
+        std::unique_ptr<Imp> _m;
+    };
+    
+    // Playing a clip, evaluated like Aut::Anim<T> but reading the segments
+    // from the clip.  Players are plain values with no allocated data, so
+    // many can be set up at little cost.
+    
+    template <typename T>
+    class ClipPlayer
+    {
+    public:
+        
+        // Play the specified clip by changing the specified variable.
+        
+        ClipPlayer(T* val = 0, const Clip<T>& clip = Clip<T>());
+        
+        // Change the variable and clip, stopping the player.
+        
+        void    set(T* val, const Clip<T>& clip);
+        
+        // Start, stop and check the player, as for Aut::Anim<T>.
+        
+        void    start(std::chrono::steady_clock::time_point t0 =
+                      std::chrono::steady_clock::now());
+        void    stop();
+        bool    running() const;
+        
+        // Evaluate the clip as of the specified time, as for Aut::Anim<T>
+        // (which also offers playing backwards every other cycle).
+        
+        enum EvalAfterEnd { RestartAfterEnd, StopAfterEnd };
+        
+        void    eval(std::chrono::steady_clock::time_point t =
+                     std::chrono::steady_clock::now(),
+                     EvalAfterEnd afterEnd = RestartAfterEnd);
+        
+    private:
+        
+        bool    contains(size_t i, std::chrono::nanoseconds e) const;
+        void    eval(size_t i, std::chrono::nanoseconds e) const;
+        bool    evalAt(std::chrono::steady_clock::time_point t);
+        
+        T*                                      _val;
+        Clip<T>                                 _clip;
+        size_t                                  _cursor;
+        std::chrono::steady_clock::time_point   _t0;
+        bool                                    _running;
+    };
+    
+}
+
+// The template definitions in the following header file should be considered
+// private implementation details.
+
+#include "AutClipImp.h"
+
+#endif
@@ -0,0 +1,529 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutClipImp.h
+//
+// The template definitions in the this header file should be considered
+// private implementation details.
+//
+
+#ifndef __AutClipImp_h
+#define __AutClipImp_h
+
+#include "AutClip.h"
+#include "AutAlert.h"
+#include "AutMappedFile.h"
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <type_traits>
+#include <vector>
+#include <string.h>
+
+namespace Aut
+{
+    
+    // A clip file starts with a header, followed by the range of segments
+    // of each clip, followed by the segments of all the clips.  Everything
+    // is 16-byte aligned when the file is mapped at a page boundary.
+    
+    static const char     clipFileMagic[4] = { 'A', 'u', 't', 'C' };
+    static const uint16_t clipFileVersion = 1;
+    
+    struct ClipFileHeader
+    {
+        char        magic[4];
+        uint16_t    version;
+        uint16_t    valueType;
+        uint32_t    valueSize;
+        uint32_t    recordSize;
+        uint64_t    clipCount;
+        uint64_t    segmentCount;
+    };
+    
+    struct ClipFileRange
+    {
+        uint64_t    first;
+        uint64_t    size;
+    };
+    
+    // Times are in nanoseconds.  A segment's end is an offset from the start
+    // of its clip, which allows the segment containing a time to be found
+    // with a binary search.
+    
+    template <typename T>
+    struct ClipRecord
+    {
+        T           val0;
+        T           val1;
+        int64_t     end;
+        int64_t     duration;
+        uint32_t    ease;
+    };
+    
+    inline float clipEase(ClipEase ease, float s)
+    {
+        switch (ease)
+        {
+            case ClipLinear:        return LinearEase::eval(s);
+            case ClipStep:          return StepEase::eval(s);
+            case ClipSmoothstep:    return SmoothstepEase::eval(s);
+            case ClipCosine:        return CosineEase::eval(s);
+            case ClipFastCosine:    return FastCosineEase::eval(s);
+            case ClipBezier:        return BezierEase::eval(s);
+            case ClipBezierIn:      return BezierEaseIn::eval(s);
+            case ClipBezierOut:     return BezierEaseOut::eval(s);
+            case ClipBezierInOut:   return BezierEaseInOut::eval(s);
+        }
+        return LinearEase::eval(s);
+    }
+    
+    //
+    
+    template <typename T>
+    Clip<T>::Clip() :
+        _records(0), _size(0)
+    {
+    }
+    
+    template <typename T>
+    Clip<T>::Clip(const ClipRecord<T>* records, size_t size) :
+        _records(records), _size(size)
+    {
+    }
+    
+    template <typename T>
+    size_t Clip<T>::size() const
+    {
+        return _size;
+    }
+    
+    template <typename T>
+    std::chrono::steady_clock::duration Clip<T>::duration() const
+    {
+        return (_size > 0) ? std::chrono::nanoseconds(_records[_size - 1].end) :
+            std::chrono::steady_clock::duration::zero();
+    }
+    
+    template <typename T>
+    T Clip<T>::value0(size_t i) const
+    {
+        return _records[i].val0;
+    }
+    
+    template <typename T>
+    T Clip<T>::value1(size_t i) const
+    {
+        return _records[i].val1;
+    }
+    
+    template <typename T>
+    std::chrono::steady_clock::duration Clip<T>::duration(size_t i) const
+    {
+        return std::chrono::nanoseconds(_records[i].duration);
+    }
+    
+    template <typename T>
+    ClipEase Clip<T>::ease(size_t i) const
+    {
+        return ClipEase(_records[i].ease);
+    }
+    
+    //
+    
+    template <typename T>
+    class ClipWriter<T>::Imp
+    {
+    public:
+        std::vector<ClipRecord<T>>  records;
+        std::vector<ClipFileRange>  clips;
+    };
+    
+    template <typename T>
+    ClipWriter<T>::ClipWriter() :
+        _m(new Imp)
+    {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "Clip values must be trivially copyable");
+        static_assert(std::alignment_of<T>::value <= 16,
+                      "Clip values must need no more than 16-byte alignment");
+    }
+    
+    template <typename T>
+    ClipWriter<T>::~ClipWriter()
+    {
+    }
+    
+    template <typename T>
+    size_t ClipWriter<T>::beginClip()
+    {
+        ClipFileRange range = { _m->records.size(), 0 };
+        _m->clips.push_back(range);
+        return _m->clips.size() - 1;
+    }
+    
+    template <typename T>
+    void ClipWriter<T>::addSegment(const T& val0, const T& val1,
+                                   std::chrono::steady_clock::duration duration,
+                                   ClipEase ease)
+    {
+        if (_m->clips.empty())
+            beginClip();
+        ClipFileRange& range = _m->clips.back();
+        
+        // Clearing the record first keeps its padding from writing whatever
+        // happened to be in memory.
+        
+        ClipRecord<T> record;
+        memset(static_cast<void*>(&record), 0, sizeof(record));
+        record.val0 = val0;
+        record.val1 = val1;
+        record.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        record.end = ((range.size > 0) ? _m->records.back().end : 0) + record.duration;
+        record.ease = ease;
+        
+        _m->records.push_back(record);
+        range.size++;
+    }
+    
+    template <typename T>
+    template <typename Ease>
+    size_t ClipWriter<T>::addClip(const Anim<T, Ease>& anim)
+    {
+        size_t index = beginClip();
+        for (const typename Anim<T, Ease>::Segment& segment : anim.segments())
+            addSegment(segment.value0(), segment.value1(), segment.duration(),
+                       ClipEaseTag<Ease>::value);
+        return index;
+    }
+    
+    template <typename T>
+    size_t ClipWriter<T>::size() const
+    {
+        return _m->clips.size();
+    }
+    
+    template <typename T>
+    Clip<T> ClipWriter<T>::clip(size_t i) const
+    {
+        const ClipFileRange& range = _m->clips[i];
+        return Clip<T>(_m->records.data() + range.first, size_t(range.size));
+    }
+    
+    template <typename T>
+    bool ClipWriter<T>::write(const std::string& path) const
+    {
+        ClipFileHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, clipFileMagic, sizeof(header.magic));
+        header.version = clipFileVersion;
+        header.valueType = ClipValueType<T>::value;
+        header.valueSize = sizeof(T);
+        header.recordSize = sizeof(ClipRecord<T>);
+        header.clipCount = _m->clips.size();
+        header.segmentCount = _m->records.size();
+        
+        std::ofstream file(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            error("Cannot create clip file \"" + path + "\"");
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(_m->clips.data()),
+                   _m->clips.size() * sizeof(ClipFileRange));
+        file.write(reinterpret_cast<const char*>(_m->records.data()),
+                   _m->records.size() * sizeof(ClipRecord<T>));
+        file.close();
+        if (!file)
+        {
+            error("Cannot write clip file \"" + path + "\"");
+            return false;
+        }
+        return true;
+    }
+    
+    //
+    
+    template <typename T>
+    class ClipFile<T>::Imp
+    {
+    public:
+        Imp(const std::string& path) : file(path), valid(false), clips(0), records(0),
+            clipCount(0) {}
+        
+        bool check(const std::string& path);
+        
+        MappedFile              file;
+        bool                    valid;
+        const ClipFileRange*    clips;
+        const ClipRecord<T>*    records;
+        size_t                  clipCount;
+    };
+    
+    template <typename T>
+    bool ClipFile<T>::Imp::check(const std::string& path)
+    {
+        if (!file.valid())
+            return false;
+        
+        const char* data = static_cast<const char*>(file.data());
+        const ClipFileHeader* header = reinterpret_cast<const ClipFileHeader*>(data);
+        if ((file.size() < sizeof(ClipFileHeader)) ||
+            (memcmp(header->magic, clipFileMagic, sizeof(clipFileMagic)) != 0))
+        {
+            error("\"" + path + "\" is not a clip file");
+            return false;
+        }
+        if (header->version != clipFileVersion)
+        {
+            std::stringstream text;
+            text << "Clip file \"" << path << "\" has version " << header->version
+                 << ", but version " << clipFileVersion << " is expected";
+            error(text.str());
+            return false;
+        }
+        if ((header->valueType != ClipValueType<T>::value) ||
+            (header->valueSize != sizeof(T)) ||
+            (header->recordSize != sizeof(ClipRecord<T>)))
+        {
+            error("Clip file \"" + path + "\" has values of a different type");
+            return false;
+        }
+        
+        // The counts are checked against the file's size in a way that
+        // cannot overflow.
+        
+        uint64_t rest = file.size() - sizeof(ClipFileHeader);
+        if ((header->clipCount > rest / sizeof(ClipFileRange)) ||
+            (header->segmentCount != (rest - header->clipCount * sizeof(ClipFileRange)) /
+             sizeof(ClipRecord<T>)) ||
+            ((rest - header->clipCount * sizeof(ClipFileRange)) % sizeof(ClipRecord<T>) != 0))
+        {
+            error("Clip file \"" + path + "\" has the wrong size");
+            return false;
+        }
+        
+        const ClipFileRange* ranges =
+            reinterpret_cast<const ClipFileRange*>(data + sizeof(ClipFileHeader));
+        for (uint64_t i = 0; i < header->clipCount; i++)
+        {
+            if ((ranges[i].first > header->segmentCount) ||
+                (ranges[i].size > header->segmentCount - ranges[i].first))
+            {
+                error("Clip file \"" + path + "\" has a clip with invalid segments");
+                return false;
+            }
+        }
+        
+        // ClipPlayer finds segments with a binary search on their ends, so
+        // each clip's segments must follow one another from time 0.
+        
+        const ClipRecord<T>* segments = reinterpret_cast<const ClipRecord<T>*>(ranges + header->clipCount);
+        for (uint64_t i = 0; i < header->clipCount; i++)
+        {
+            int64_t end = 0;
+            const ClipRecord<T>* segment = segments + ranges[i].first;
+            for (uint64_t j = 0; j < ranges[i].size; j++, segment++)
+            {
+                if ((segment->duration < 0) ||
+                    (segment->duration > std::numeric_limits<int64_t>::max() - end) ||
+                    (segment->end != end + segment->duration))
+                {
+                    error("Clip file \"" + path + "\" has a clip with invalid times");
+                    return false;
+                }
+                end = segment->end;
+            }
+        }
+        
+        clips = ranges;
+        records = segments;
+        clipCount = size_t(header->clipCount);
+        return true;
+    }
+    
+    template <typename T>
+    ClipFile<T>::ClipFile(const std::string& path) :
+        _m(new Imp(path))
+    {
+        _m->valid = _m->check(path);
+    }
+    
+    template <typename T>
+    ClipFile<T>::~ClipFile()
+    {
+    }
+    
+    template <typename T>
+    bool ClipFile<T>::valid() const
+    {
+        return _m->valid;
+    }
+    
+    template <typename T>
+    size_t ClipFile<T>::size() const
+    {
+        return _m->clipCount;
+    }
+    
+    template <typename T>
+    Clip<T> ClipFile<T>::clip(size_t i) const
+    {
+        const ClipFileRange& range = _m->clips[i];
+        return Clip<T>(_m->records + range.first, size_t(range.size));
+    }
+    
+    //
+    
+    template <typename T>
+    ClipPlayer<T>::ClipPlayer(T* val, const Clip<T>& clip) :
+        _val(val), _clip(clip), _cursor(0), _running(false)
+    {
+    }
+    
+    template <typename T>
+    void ClipPlayer<T>::set(T* val, const Clip<T>& clip)
+    {
+        _val = val;
+        _clip = clip;
+        _cursor = 0;
+        _running = false;
+    }
+    
+    template <typename T>
+    void ClipPlayer<T>::start(std::chrono::steady_clock::time_point t0)
+    {
+        if (_clip.size() > 0)
+        {
+            _running = true;
+            _t0 = t0;
+            _cursor = 0;
+        }
+    }
+    
+    template <typename T>
+    void ClipPlayer<T>::stop()
+    {
+        _running = false;
+    }
+    
+    template <typename T>
+    bool ClipPlayer<T>::running() const
+    {
+        return _running;
+    }
+    
+    template <typename T>
+    bool ClipPlayer<T>::contains(size_t i, std::chrono::nanoseconds e) const
+    {
+        const ClipRecord<T>& record = _clip._records[i];
+        return ((record.end - record.duration <= e.count()) && (e.count() < record.end));
+    }
+    
+    template <typename T>
+    void ClipPlayer<T>::eval(size_t i, std::chrono::nanoseconds e) const
+    {
+        const ClipRecord<T>& record = _clip._records[i];
+        int64_t s0 = record.end - record.duration;
+        if (e.count() < s0)
+        {
+            *_val = record.val0;
+        }
+        else if (e.count() >= record.end)
+        {
+            *_val = record.val1;
+        }
+        else
+        {
+            float s = float(e.count() - s0) / float(record.duration);
+            *_val = AnimTraits<T>::interp(record.val0, record.val1, clipEase(ClipEase(record.ease), s));
+        }
+    }
+    
+    template <typename T>
+    bool ClipPlayer<T>::evalAt(std::chrono::steady_clock::time_point t)
+    {
+        std::chrono::nanoseconds e = std::chrono::duration_cast<std::chrono::nanoseconds>(t - _t0);
+        if (e.count() < 0)
+            e = std::chrono::nanoseconds(0);
+        if (!contains(_cursor, e))
+        {
+            const ClipRecord<T>* records = _clip._records;
+            size_t last = _clip._size - 1;
+            if (e.count() >= records[last].end)
+            {
+                _cursor = last;
+                eval(last, e);
+                return false;
+            }
+            
+            if ((_cursor < last) && contains(_cursor + 1, e))
+            {
+                _cursor++;
+            }
+            else
+            {
+                _cursor = std::upper_bound(records, records + _clip._size, e.count(),
+                                           [](int64_t e, const ClipRecord<T>& record)
+                                           { return e < record.end; }) - records;
+            }
+        }
+        
+        eval(_cursor, e);
+        return true;
+    }
+    
+    template <typename T>
+    void ClipPlayer<T>::eval(std::chrono::steady_clock::time_point t, EvalAfterEnd afterEnd)
+    {
+        if (_running)
+        {
+            if (!evalAt(t))
+            {
+                // As for Anim<T>, the phase of a cycling clip is the time
+                // since the start modulo the clip's duration.  With no
+                // duration to cycle through, the clip keeps running, holding
+                // its final value.
+                
+                int64_t end = _clip._records[_clip._size - 1].end;
+                if (afterEnd == StopAfterEnd)
+                {
+                    _running = false;
+                }
+                else if (end > 0)
+                {
+                    int64_t e = std::chrono::duration_cast<std::chrono::nanoseconds>(t - _t0).count();
+                    _t0 += std::chrono::duration_cast<std::chrono::steady_clock::duration>
+                        (std::chrono::nanoseconds((e / end) * end));
+                    _cursor = 0;
+                    evalAt(t);
+                }
+            }
+        }
+    }
+    
+}
+
+#endif
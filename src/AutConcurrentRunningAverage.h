@@ -0,0 +1,112 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutConcurrentRunningAverage.h
+//
+// A template class to compute running averages, like RunningAverage<T>, for
+// values added by any number of threads while other threads read the
+// average.  Adding a value is lock-free, and reading the average is
+// wait-free (a single atomic load).  As for RunningAverage<T>, the times of
+// values come from the clock that is the second template parameter, or are
+// supplied by the caller.
+//
+// The values and the sum are kept in atomic words along with a 32-bit tag
+// or count, so T is limited to 4 bytes (e.g., float or int32_t), for which
+// those words are 8 bytes, and lock-free on the usual platforms.  A double
+// would need 16-byte atomic operations, which GCC implements with locks in
+// libatomic (so the program would also need -latomic).
+//
+
+#ifndef __AutConcurrentRunningAverage__
+#define __AutConcurrentRunningAverage__
+
+#include <chrono>
+#include <memory>
+
+namespace Aut
+{
+    
+    template <typename T, typename Clock = std::chrono::steady_clock>
+    class ConcurrentRunningAverage
+    {
+        static_assert(sizeof(T) <= 4, "ConcurrentRunningAverage needs values of at most 4 bytes");
+        
+    public:
+        
+        // The capacity and time window are as for RunningAverage<T>.
+        
+        ConcurrentRunningAverage(size_t capacity = 5,
+                                 std::chrono::milliseconds window =
+                                 std::chrono::milliseconds(500));
+        ~ConcurrentRunningAverage();
+        
+        // Set and get the number of the most recent values used in the
+        // average.  Setting the capacity must not happen while other threads
+        // are using the instance.
+        
+        void                        setCapacity(size_t);
+        size_t                      capacity() const;
+        
+        // Set and get the time window.  When a value is added, the values
+        // added more than the time window before it are dropped, from the
+        // oldest, as for RunningAverage<T>.  A value that another thread is
+        // adding at the same moment is not dropped until a later add.
+        
+        void                        setWindow(std::chrono::milliseconds);
+        std::chrono::milliseconds   window() const;
+        
+        // Add a value to be used in the running average, as of the current
+        // time or as of the specified time.  Any number of threads may add
+        // values at once.
+        
+        void                        add(const T&);
+        void                        add(const T&, typename Clock::time_point);
+        
+        // Return the running average, or T() if no values have been added.
+        // The sum and the number of values are updated together, so the
+        // average is always that of some set of values recently added.
+        
+        T                           operator()() const;
+        
+        // Return whether adding and reading are lock-free, which depends on
+        // the platform's 8-byte atomic operations for a T and a 32-bit count
+        // together.
+        
+        bool                        isLockFree() const;
+        
+    private:
+        
+        // Details of the class' data are "hidden" in the Imp.h file.
+        
+        class Imp;
+        std::unique_ptr<Imp> _m;
+    };
+    
+}
+
+// The template definitions in the following header file should be considered
+// private implementation details.
+
+#include "AutConcurrentRunningAverageImp.h"
+
+#endif
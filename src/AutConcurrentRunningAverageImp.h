@@ -0,0 +1,364 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutConcurrentRunningAverageImp.h
+//
+// The template definitions in the this header file should be considered
+// private implementation details.
+//
+
+#ifndef __AutConcurrentRunningAverageImp_h
+#define __AutConcurrentRunningAverageImp_h
+
+#include "AutConcurrentRunningAverage.h"
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+
+namespace Aut
+{
+    template <typename T, typename Clock>
+    class ConcurrentRunningAverage<T, Clock>::Imp
+    {
+    public:
+        Imp(size_t cap, std::chrono::milliseconds win);
+        
+        // Each slot of the ring holds a value, tagged with the index of the
+        // add that claimed the slot (modulo 2^31) and whether the value is
+        // in use.  Adding a value claims the next index and exchanges the
+        // value into its slot, which returns the value it replaces, and
+        // expiring a value exchanges it for an unused entry with the same
+        // index, so each value is removed from the sum exactly once, however
+        // the threads interleave.  A value is added to the sum before it
+        // goes into the ring, so it is never removed from the sum before
+        // being added.
+        
+        struct Entry
+        {
+            T           val;
+            uint32_t    tag;
+        };
+        
+        static const uint32_t used = 0x80000000u;
+        static const uint32_t indexMask = 0x7FFFFFFFu;
+        
+        // The sum and the number of values in use, published together.
+        
+        struct State
+        {
+            T           sum;
+            uint32_t    count;
+        };
+        
+        void allocate(size_t cap);
+        void expire(int64_t now);
+        T    add(State&, const T& x, int change);
+        void update(const T& delta, int change);
+        void insert(const T&);
+        void remove(const Entry&);
+        
+        // The time of each slot's value, as a count of the clock's ticks.
+        // It is stored before the value, so it is at least as late as the
+        // time of the value seen in the slot.
+        
+        std::unique_ptr<std::atomic<Entry>[]>   ring;
+        std::unique_ptr<std::atomic<int64_t>[]> times;
+        size_t                                  capacity;
+        std::atomic<int64_t>                    window;
+        
+        // The fields written by every add are padded onto separate cache
+        // lines, so the threads adding values do not slow down the threads
+        // reading.  The values with indices from oldest up to next may
+        // still be in use; older ones have been replaced or expired.
+        
+        char                                    pad0[64];
+        std::atomic<uint64_t>                   next;
+        char                                    pad1[64];
+        std::atomic<uint64_t>                   oldest;
+        char                                    pad2[64];
+        std::atomic<State>                      state;
+        
+        // The rounding error left over by the updates of the sum, which is
+        // folded into the sum by the next update, so it does not accumulate
+        // as values are added and removed.  It plays the part of the
+        // compensation of RunningSum<T>, but is kept outside the state so
+        // the state stays small enough for lock-free atomic operations.
+        
+        std::atomic<T>                          error;
+        char                                    pad3[64];
+    };
+    
+    template <typename T, typename Clock>
+    const uint32_t ConcurrentRunningAverage<T, Clock>::Imp::used;
+    
+    template <typename T, typename Clock>
+    const uint32_t ConcurrentRunningAverage<T, Clock>::Imp::indexMask;
+    
+    template <typename T, typename Clock>
+    ConcurrentRunningAverage<T, Clock>::Imp::Imp(size_t cap, std::chrono::milliseconds win) :
+        capacity(0), window(std::chrono::duration_cast<typename Clock::duration>(win).count()),
+        next(0), oldest(0), error(T())
+    {
+        State s = { T(), 0 };
+        state.store(s);
+        allocate(cap);
+    }
+    
+    template <typename T, typename Clock>
+    void ConcurrentRunningAverage<T, Clock>::Imp::allocate(size_t cap)
+    {
+        ring.reset(cap > 0 ? new std::atomic<Entry>[cap] : 0);
+        times.reset(cap > 0 ? new std::atomic<int64_t>[cap] : 0);
+        capacity = cap;
+        
+        // Each slot starts as if its value from the previous time around
+        // the ring has expired.
+        
+        for (size_t i = 0; i < cap; i++)
+        {
+            Entry empty = { T(), uint32_t(i - cap) & indexMask };
+            ring[i].store(empty);
+            times[i].store(0);
+        }
+    }
+    
+    template <typename T, typename Clock>
+    void ConcurrentRunningAverage<T, Clock>::Imp::expire(int64_t now)
+    {
+        // Values expire from the oldest, until one is within the window or
+        // is still being added.
+        
+        for (;;)
+        {
+            uint64_t n = next.load();
+            uint64_t i = oldest.load();
+            if (n - i > capacity)
+            {
+                oldest.compare_exchange_weak(i, n - capacity);
+                continue;
+            }
+            if (i == n)
+                return;
+            
+            size_t slot = size_t(i % capacity);
+            Entry e = ring[slot].load();
+            uint32_t index = uint32_t(i) & indexMask;
+            if ((e.tag & indexMask) != index)
+            {
+                // An entry from an earlier time around the ring means the
+                // value is still being added; one from a later time means
+                // it was replaced.
+                
+                if (((e.tag - index) & indexMask) > (indexMask >> 1))
+                    return;
+                oldest.compare_exchange_weak(i, i + 1);
+                continue;
+            }
+            if (e.tag & used)
+            {
+                if (now - times[slot].load() <= window.load())
+                    return;
+                Entry empty = { T(), index };
+                if (!ring[slot].compare_exchange_strong(e, empty))
+                    continue;
+                remove(e);
+            }
+            oldest.compare_exchange_weak(i, i + 1);
+        }
+    }
+    
+    template <typename T, typename Clock>
+    T ConcurrentRunningAverage<T, Clock>::Imp::add(State& s, const T& x, int change)
+    {
+        // Knuth's TwoSum gives the rounding error of the addition exactly.
+        
+        State n;
+        T err;
+        do
+        {
+            n.count = uint32_t(int64_t(s.count) + change);
+            n.sum = s.sum + x;
+            T sx = n.sum - s.sum;
+            err = (s.sum - (n.sum - sx)) + (x - sx);
+            
+            // The sum of no values is exact.
+            
+            if (n.count == 0)
+            {
+                n.sum = T();
+                err = T();
+            }
+        }
+        while (!state.compare_exchange_weak(s, n));
+        s = n;
+        return err;
+    }
+    
+    template <typename T, typename Clock>
+    void ConcurrentRunningAverage<T, Clock>::Imp::update(const T& delta, int change)
+    {
+        // The delta is added to the sum along with the error left by earlier
+        // updates, and the rounding error of that is added to the sum right
+        // away, so the published sum is off by no more than the rounding of
+        // one addition.  What is left over is kept for the next update.
+        
+        T pending = error.exchange(T());
+        T x = delta + pending;
+        T xd = x - delta;
+        T residual = (delta - (x - xd)) + (pending - xd);
+        
+        State s = state.load();
+        T leftover = residual + add(s, x, change);
+        if (s.count == 0)
+            return;
+        if (!(leftover == T()))
+            leftover = add(s, leftover, 0);
+        
+        T e = error.load();
+        while (!error.compare_exchange_weak(e, e + leftover))
+            ;
+    }
+    
+    template <typename T, typename Clock>
+    void ConcurrentRunningAverage<T, Clock>::Imp::insert(const T& x)
+    {
+        update(x, 1);
+    }
+    
+    template <typename T, typename Clock>
+    void ConcurrentRunningAverage<T, Clock>::Imp::remove(const Entry& removed)
+    {
+        if (removed.tag & used)
+            update(-removed.val, -1);
+    }
+    
+    template <typename T, typename Clock>
+    ConcurrentRunningAverage<T, Clock>::ConcurrentRunningAverage(size_t cap, std::chrono::milliseconds win) :
+        _m(new Imp(cap, win))
+    {
+    }
+    
+    template <typename T, typename Clock>
+    ConcurrentRunningAverage<T, Clock>::~ConcurrentRunningAverage()
+    {
+    }
+    
+    template <typename T, typename Clock>
+    void ConcurrentRunningAverage<T, Clock>::setCapacity(size_t cap)
+    {
+        if (cap == _m->capacity)
+            return;
+        
+        // Keep the most recent values, which are in the slots before the
+        // next one to be claimed.
+        
+        std::vector<T> kept;
+        std::vector<int64_t> keptTimes;
+        uint64_t next = _m->next.load();
+        for (uint64_t i = next; (i-- > _m->oldest.load()) && (kept.size() < cap); )
+        {
+            size_t slot = size_t(i % _m->capacity);
+            typename Imp::Entry e = _m->ring[slot].load();
+            if (e.tag != ((uint32_t(i) & Imp::indexMask) | Imp::used))
+                break;
+            kept.push_back(e.val);
+            keptTimes.push_back(_m->times[slot].load());
+        }
+        
+        _m->allocate(cap);
+        typename Imp::State s = { T(), 0 };
+        _m->state.store(s);
+        _m->error.store(T());
+        _m->next.store(0);
+        _m->oldest.store(0);
+        for (size_t i = kept.size(); i-- > 0; )
+        {
+            uint64_t index = _m->next++;
+            typename Imp::Entry e = { kept[i], uint32_t(index) | Imp::used };
+            _m->times[index].store(keptTimes[i]);
+            _m->ring[index].store(e);
+            _m->insert(kept[i]);
+        }
+    }
+    
+    template <typename T, typename Clock>
+    size_t ConcurrentRunningAverage<T, Clock>::capacity() const
+    {
+        return _m->capacity;
+    }
+    
+    template <typename T, typename Clock>
+    void ConcurrentRunningAverage<T, Clock>::setWindow(std::chrono::milliseconds win)
+    {
+        _m->window.store(std::chrono::duration_cast<typename Clock::duration>(win).count());
+    }
+    
+    template <typename T, typename Clock>
+    std::chrono::milliseconds ConcurrentRunningAverage<T, Clock>::window() const
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>
+            (typename Clock::duration(_m->window.load()));
+    }
+    
+    template <typename T, typename Clock>
+    void ConcurrentRunningAverage<T, Clock>::add(const T& x)
+    {
+        add(x, Clock::now());
+    }
+    
+    template <typename T, typename Clock>
+    void ConcurrentRunningAverage<T, Clock>::add(const T& x, typename Clock::time_point t)
+    {
+        if (_m->capacity == 0)
+            return;
+        
+        int64_t now = t.time_since_epoch().count();
+        _m->expire(now);
+        
+        uint64_t i = _m->next.fetch_add(1);
+        size_t slot = size_t(i % _m->capacity);
+        typename Imp::Entry e = { x, (uint32_t(i) & Imp::indexMask) | Imp::used };
+        _m->times[slot].store(now);
+        _m->insert(x);
+        _m->remove(_m->ring[slot].exchange(e));
+    }
+    
+    template <typename T, typename Clock>
+    T ConcurrentRunningAverage<T, Clock>::operator()() const
+    {
+        typename Imp::State s = _m->state.load();
+        if (s.count == 0)
+            return T();
+        return s.sum / s.count;
+    }
+    
+    template <typename T, typename Clock>
+    bool ConcurrentRunningAverage<T, Clock>::isLockFree() const
+    {
+        std::atomic<typename Imp::Entry> entry;
+        return _m->state.is_lock_free() && entry.is_lock_free();
+    }
+    
+}
+
+#endif
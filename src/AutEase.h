@@ -0,0 +1,166 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutEase.h
+//
+// Easing policies for Aut::Anim<T, Ease>.  Each policy is a class with a
+// static eval() function that maps the fraction of a segment's duration that
+// has elapsed, s in [0, 1], to the fraction of the change from the segment's
+// beginning value to its ending value, with eval(0) = 0 and eval(1) = 1.
+// The functions are inline, and constexpr where the language allows.
+//
+
+#ifndef __AutEase__
+#define __AutEase__
+
+#include <math.h>
+
+namespace Aut
+{
+    
+    // The ease-in-ease-out curve (1 - cos(s * pi)) / 2, computed with cosf().
+    
+    struct CosineEase
+    {
+        static float eval(float s)
+        {
+            return (1.0f - cosf(s * float(M_PI))) / 2.0f;
+        }
+    };
+    
+    // The same curve as CosineEase, computed as 1/2 + sin((s - 1/2) * pi) / 2
+    // with the sine approximated by an odd polynomial fit over [-1/2, 1/2].
+    // The result is within 5e-7 of CosineEase's, and is exact at the ends.
+    // This is the default policy, as it needs no trigonometric functions.
+    
+    struct FastCosineEase
+    {
+        static constexpr float eval(float s)
+        {
+            return (s <= 0.0f) ? 0.0f : ((s >= 1.0f) ? 1.0f : clamp(poly(s - 0.5f)));
+        }
+        
+        static constexpr float poly(float x)
+        {
+            return 0.5f + x * (c1 + x * x * (c3 + x * x * (c5 + x * x * c7)));
+        }
+        
+        static constexpr float clamp(float w)
+        {
+            return (w < 0.0f) ? 0.0f : ((w > 1.0f) ? 1.0f : w);
+        }
+        
+        static constexpr float c1 = 1.5707918907f;
+        static constexpr float c3 = -2.5835948516f;
+        static constexpr float c5 = 1.2711199645f;
+        static constexpr float c7 = -0.2776849927f;
+    };
+    
+    // The smoothstep curve, 3s^2 - 2s^3, which is close to the cosine curve
+    // (within 0.011) and cheaper still.
+    
+    struct SmoothstepEase
+    {
+        static constexpr float eval(float s)
+        {
+            return (s <= 0.0f) ? 0.0f : ((s >= 1.0f) ? 1.0f : s * s * (3.0f - 2.0f * s));
+        }
+    };
+    
+    // A cubic Bezier curve from (0, 0) to (1, 1), with the inner control points
+    // (X1, Y1) and (X2, Y2) given in thousandths, as for CSS timing functions.
+    // X1 and X2 must be in [0, 1000].  The curve's parameter for s is found by
+    // a fixed number of Newton steps, which gives results within 1e-6 for the
+    // standard CSS curves, but less accurate results near where a curve is
+    // vertical (e.g., within 0.01 for X1 = 1000 and X2 = 0).  The Newton steps
+    // make this policy much more expensive to evaluate than the others.
+    
+    template <int X1, int Y1, int X2, int Y2>
+    struct CubicBezierEase
+    {
+        static constexpr float eval(float s)
+        {
+            return (s <= 0.0f) ? 0.0f : ((s >= 1.0f) ? 1.0f :
+                                         bezier(solve(s, s, 8), Y1 / 1000.0f, Y2 / 1000.0f));
+        }
+        
+        static constexpr float bezier(float t, float p1, float p2)
+        {
+            return 3.0f * (1.0f - t) * (1.0f - t) * t * p1 +
+                3.0f * (1.0f - t) * t * t * p2 + t * t * t;
+        }
+        
+        static constexpr float slope(float t, float p1, float p2)
+        {
+            return 3.0f * (1.0f - t) * (1.0f - t) * p1 +
+                6.0f * (1.0f - t) * t * (p2 - p1) + 3.0f * t * t * (1.0f - p2);
+        }
+        
+        static constexpr float step(float s, float t, float d)
+        {
+            return (d == 0.0f) ? t : clamp(t - (bezier(t, X1 / 1000.0f, X2 / 1000.0f) - s) / d);
+        }
+        
+        static constexpr float solve(float s, float t, int steps)
+        {
+            return (steps == 0) ? t :
+                solve(s, step(s, t, slope(t, X1 / 1000.0f, X2 / 1000.0f)), steps - 1);
+        }
+        
+        static constexpr float clamp(float t)
+        {
+            return (t < 0.0f) ? 0.0f : ((t > 1.0f) ? 1.0f : t);
+        }
+    };
+    
+    // The standard CSS timing functions.
+    
+    typedef CubicBezierEase<250, 100, 250, 1000>    BezierEase;
+    typedef CubicBezierEase<420, 0, 1000, 1000>     BezierEaseIn;
+    typedef CubicBezierEase<0, 0, 580, 1000>        BezierEaseOut;
+    typedef CubicBezierEase<420, 0, 580, 1000>      BezierEaseInOut;
+    
+    // Linear interpolation, with no easing.
+    
+    struct LinearEase
+    {
+        static constexpr float eval(float s)
+        {
+            return (s <= 0.0f) ? 0.0f : ((s >= 1.0f) ? 1.0f : s);
+        }
+    };
+    
+    // No interpolation: the beginning value holds for the whole segment, and
+    // the ending value takes over when the segment ends.
+    
+    struct StepEase
+    {
+        static constexpr float eval(float s)
+        {
+            return (s >= 1.0f) ? 1.0f : 0.0f;
+        }
+    };
+    
+}
+
+#endif
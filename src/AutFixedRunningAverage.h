@@ -0,0 +1,147 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutFixedRunningAverage.h
+//
+// A template class to compute running averages like RunningAverage<T>, for
+// a capacity that is a compile-time constant.  The values and their times
+// are stored inline in the object, in fixed-size arrays, so the averager
+// needs no heap allocation and its data is not behind a pointer.  An empty
+// averager can be constructed and read in constexpr contexts.
+//
+
+#ifndef __AutFixedRunningAverage__
+#define __AutFixedRunningAverage__
+
+#include <chrono>
+#include <stddef.h>
+
+namespace Aut
+{
+    
+    // The sum of Count values starting at Begin, as the sums of the two
+    // halves.  The recursion is over template arguments, so it is unrolled
+    // completely, and the pairs of halves are independent, so the additions
+    // can be vectorized (which a loop over floating-point values cannot be,
+    // without reassociating the additions).
+    
+    template <typename T, size_t Begin, size_t Count>
+    struct PairwiseSum
+    {
+        static constexpr T of(const T* v)
+        {
+            return PairwiseSum<T, Begin, Count / 2>::of(v) +
+                   PairwiseSum<T, Begin + Count / 2, Count - Count / 2>::of(v);
+        }
+    };
+    
+    template <typename T, size_t Begin>
+    struct PairwiseSum<T, Begin, 1>
+    {
+        static constexpr T of(const T* v) { return v[Begin]; }
+    };
+    
+    template <typename T, size_t Begin>
+    struct PairwiseSum<T, Begin, 0>
+    {
+        static constexpr T of(const T*) { return T(); }
+    };
+    
+    template <typename T, size_t N, typename Clock = std::chrono::steady_clock>
+    class FixedRunningAverage
+    {
+        static_assert(N > 0, "FixedRunningAverage needs a capacity of at least one");
+        
+    public:
+        
+        // The time window is as for RunningAverage<T>.  The capacity is N.
+        
+        constexpr FixedRunningAverage(std::chrono::milliseconds window =
+                                      std::chrono::milliseconds(500)) :
+            _values(), _times(), _first(0), _count(0), _window(window)
+        {
+        }
+        
+        // The capacity cannot be changed, so unlike RunningAverage<T> there is
+        // no setCapacity().
+        
+        static constexpr size_t     capacity() { return N; }
+        
+        void                        setWindow(std::chrono::milliseconds window) { _window = window; }
+        constexpr std::chrono::milliseconds window() const { return _window; }
+        
+        // Add a value as of the current time, or as of the specified time,
+        // as for RunningAverage<T>.
+        
+        void                        add(const T& x) { add(x, Clock::now()); }
+        
+        void                        add(const T& x, typename Clock::time_point t)
+        {
+            // A slot that holds no value holds T(), so the sum can always
+            // include all N slots.
+            
+            while ((_count > 0) && (t - _times[_first] > _window))
+            {
+                _values[_first] = T();
+                _first = (_first + 1) % N;
+                _count--;
+            }
+            
+            size_t i;
+            if (_count == N)
+            {
+                i = _first;
+                _first = (_first + 1) % N;
+            }
+            else
+            {
+                i = (_first + _count) % N;
+                _count++;
+            }
+            _values[i] = x;
+            _times[i] = t;
+        }
+        
+        // Return the running average, or T() if no values have been added.
+        // The sum is computed afresh from the N slots, which for a small N is
+        // about as fast as updating a running sum, and never accumulates
+        // rounding error.
+        
+        constexpr T                 operator()() const
+        {
+            return (_count == 0) ? T() : PairwiseSum<T, 0, N>::of(_values) / _count;
+        }
+        
+        constexpr size_t            size() const { return _count; }
+        
+    private:
+        T                           _values[N];
+        typename Clock::time_point  _times[N];
+        size_t                      _first;
+        size_t                      _count;
+        std::chrono::milliseconds   _window;
+    };
+    
+}
+
+#endif
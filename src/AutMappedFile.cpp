@@ -0,0 +1,115 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutMappedFile.cpp
+//
+
+#include "AutMappedFile.h"
+#include "AutAlert.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Aut
+{
+    
+    class MappedFile::Imp
+    {
+    public:
+        Imp() : valid(false), data(0), size(0) {}
+        
+        bool    valid;
+        void*   data;
+        size_t  size;
+    };
+    
+    MappedFile::MappedFile(const std::string& path) : _m(new Imp)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            error("Cannot open \"" + path + "\": " + strerror(errno));
+            return;
+        }
+        
+        struct stat info;
+        if (fstat(fd, &info) != 0)
+        {
+            error("Cannot get the size of \"" + path + "\": " + strerror(errno));
+            close(fd);
+            return;
+        }
+        
+        // An empty file cannot be mapped, but is still a valid (empty) file.
+        
+        _m->size = size_t(info.st_size);
+        if (_m->size > 0)
+        {
+            void* data = mmap(0, _m->size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED)
+            {
+                error("Cannot map \"" + path + "\": " + strerror(errno));
+                _m->size = 0;
+                close(fd);
+                return;
+            }
+            _m->data = data;
+            
+            // Clip files are checked from start to end as soon as they are
+            // opened, so start reading all of the file rather than faulting
+            // it in a page at a time.
+            
+            madvise(data, _m->size, MADV_WILLNEED);
+        }
+        
+        // The mapping stays valid after the file is closed.
+        
+        close(fd);
+        _m->valid = true;
+    }
+    
+    MappedFile::~MappedFile()
+    {
+        if (_m->data)
+            munmap(_m->data, _m->size);
+    }
+    
+    bool MappedFile::valid() const
+    {
+        return _m->valid;
+    }
+    
+    const void* MappedFile::data() const
+    {
+        return _m->data;
+    }
+    
+    size_t MappedFile::size() const
+    {
+        return _m->size;
+    }
+    
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutMappedFile.h
+//
+// A read-only memory mapping of a whole file, so the file's contents can be
+// used in place without being read into allocated memory.  Pages are loaded
+// by the operating system as they are first touched.
+//
+
+#ifndef __AutMappedFile__
+#define __AutMappedFile__
+
+#include <memory>
+#include <string>
+
+namespace Aut
+{
+    
+    class MappedFile
+    {
+    public:
+        
+        // Map the file at the specified path.  Failure is reported with
+        // Aut::error(), and leaves the mapping invalid.
+        
+        MappedFile(const std::string& path);
+        ~MappedFile();
+        
+        // Return whether the file was mapped.
+        
+        bool        valid() const;
+        
+        // Access the file's contents, which remain valid for the lifetime
+        // of this instance.  The data is 0 for an invalid mapping (or an
+        // empty file).
+        
+        const void* data() const;
+        size_t      size() const;
+        
+    private:
+        
+        // Details of the class' data are "hidden" in the .cpp file.
+        
+        class Imp;
+        std::unique_ptr<Imp> _m;
+    };
+    
+}
+
+#endif
@@ -0,0 +1,97 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutMultiRunningAverage.h
+//
+// A template class to compute running averages of many channels of float
+// values that are added together, in frames (e.g., the x and y coordinates
+// of dozens of tracked points).  It behaves like one RunningAverage<float>
+// per channel with the same capacity and time window, but stores the frames
+// in one contiguous array, reads the clock once per frame, and updates the
+// sums of all the channels together, four at a time with SSE when it is
+// available.
+//
+
+#ifndef __AutMultiRunningAverage__
+#define __AutMultiRunningAverage__
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace Aut
+{
+    
+    template <typename Clock = std::chrono::steady_clock>
+    class MultiRunningAverage
+    {
+    public:
+        
+        // The number of channels is fixed.  The capacity (in frames) and the
+        // time window are as for RunningAverage<T>.
+        
+        MultiRunningAverage(size_t channels, size_t capacity = 5,
+                            std::chrono::milliseconds window =
+                            std::chrono::milliseconds(500));
+        ~MultiRunningAverage();
+        
+        size_t                      channels() const;
+        
+        void                        setCapacity(size_t);
+        size_t                      capacity() const;
+        
+        void                        setWindow(std::chrono::milliseconds);
+        std::chrono::milliseconds   window() const;
+        
+        // Add a frame, an array with a value for each channel, as of the
+        // current time or as of the specified time.
+        
+        void                        add(const float* frame);
+        void                        add(const float* frame, typename Clock::time_point);
+        
+        // Return the number of frames in the averages.
+        
+        size_t                      size() const;
+        
+        // Return the running averages of all the channels, or zeros if no
+        // frames have been added.  The reference remains valid, and is
+        // updated by later calls, for the life of this object.
+        
+        const std::vector<float>&   operator()();
+        
+    private:
+        
+        // Details of the class' data are "hidden" in the Imp.h file.
+        
+        class Imp;
+        std::unique_ptr<Imp> _m;
+    };
+    
+}
+
+// The template definitions in the following header file should be considered
+// private implementation details.
+
+#include "AutMultiRunningAverageImp.h"
+
+#endif
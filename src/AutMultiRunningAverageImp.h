@@ -0,0 +1,306 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutMultiRunningAverageImp.h
+//
+// The template definitions in the this header file should be considered
+// private implementation details.
+//
+
+#ifndef __AutMultiRunningAverageImp_h
+#define __AutMultiRunningAverageImp_h
+
+#include "AutMultiRunningAverage.h"
+#include <algorithm>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+namespace Aut
+{
+    template <typename Clock>
+    class MultiRunningAverage<Clock>::Imp
+    {
+    public:
+        Imp(size_t chans, size_t cap, std::chrono::milliseconds win);
+        
+        float*  row(size_t i) { return history.data() + i * stride; }
+        void    push(const float* frame, typename Clock::time_point);
+        void    pop();
+        void    resum();
+        
+        size_t                                      channels;
+        size_t                                      stride;
+        std::chrono::milliseconds                   window;
+        
+        // The frames are stored in a ring of rows, each padded with zeros to
+        // a multiple of four channels, from the oldest, at index first, to
+        // the newest.
+        
+        std::vector<float>                          history;
+        std::vector<typename Clock::time_point>     times;
+        size_t                                      capacity;
+        size_t                                      first;
+        size_t                                      count;
+        
+        // The sums of each channel, updated as frames are added and removed.
+        // They are recomputed from the rows after every max(capacity,
+        // refresh) frames, so rounding error does not accumulate.
+        
+        static const size_t                         refresh = 256;
+        std::vector<float>                          sums;
+        size_t                                      pushed;
+        
+        // The new frame, padded like the rows, and the averages.
+        
+        std::vector<float>                          incoming;
+        std::vector<float>                          averages;
+    };
+    
+    template <typename Clock>
+    const size_t MultiRunningAverage<Clock>::Imp::refresh;
+    
+    template <typename Clock>
+    MultiRunningAverage<Clock>::Imp::Imp(size_t chans, size_t cap, std::chrono::milliseconds win) :
+        channels(chans), stride((chans + 3) & ~size_t(3)), window(win),
+        history(cap * stride), times(cap), capacity(cap), first(0), count(0),
+        sums(stride), pushed(0), incoming(stride), averages(chans)
+    {
+    }
+    
+    template <typename Clock>
+    void MultiRunningAverage<Clock>::Imp::push(const float* frame, typename Clock::time_point t)
+    {
+        if (capacity == 0)
+            return;
+        
+        while ((count > 0) && (t - times[first] > window))
+            pop();
+        
+        // When the ring is full, the new frame replaces the oldest, and one
+        // pass adds the one and subtracts the other.
+        
+        size_t i;
+        bool full = (count == capacity);
+        if (full)
+        {
+            i = first;
+            if (++first == capacity)
+                first = 0;
+        }
+        else
+        {
+            i = first + count;
+            if (i >= capacity)
+                i -= capacity;
+            count++;
+        }
+        times[i] = t;
+        
+        std::copy(frame, frame + channels, incoming.begin());
+        float* dst = row(i);
+        float* sum = sums.data();
+        const float* src = incoming.data();
+        for (size_t c = 0; c < stride; c += 4)
+        {
+#if defined(__SSE__)
+            __m128 x = _mm_loadu_ps(src + c);
+            __m128 s = _mm_loadu_ps(sum + c);
+            if (full)
+                s = _mm_sub_ps(s, _mm_loadu_ps(dst + c));
+            _mm_storeu_ps(sum + c, _mm_add_ps(s, x));
+            _mm_storeu_ps(dst + c, x);
+#else
+            for (size_t j = c; j < c + 4; j++)
+            {
+                if (full)
+                    sum[j] -= dst[j];
+                sum[j] += src[j];
+                dst[j] = src[j];
+            }
+#endif
+        }
+        
+        if (++pushed >= std::max(capacity, refresh))
+            resum();
+    }
+    
+    template <typename Clock>
+    void MultiRunningAverage<Clock>::Imp::pop()
+    {
+        const float* src = row(first);
+        float* sum = sums.data();
+        for (size_t c = 0; c < stride; c += 4)
+        {
+#if defined(__SSE__)
+            _mm_storeu_ps(sum + c, _mm_sub_ps(_mm_loadu_ps(sum + c), _mm_loadu_ps(src + c)));
+#else
+            for (size_t j = c; j < c + 4; j++)
+                sum[j] -= src[j];
+#endif
+        }
+        if (++first == capacity)
+            first = 0;
+        
+        // Starting afresh when the ring empties, as RunningAverage<T> does.
+        
+        if (--count == 0)
+        {
+            first = 0;
+            std::fill(sums.begin(), sums.end(), 0.0f);
+        }
+    }
+    
+    template <typename Clock>
+    void MultiRunningAverage<Clock>::Imp::resum()
+    {
+        std::fill(sums.begin(), sums.end(), 0.0f);
+        float* sum = sums.data();
+        for (size_t k = 0; k < count; k++)
+        {
+            const float* src = row((first + k) % capacity);
+            for (size_t c = 0; c < stride; c += 4)
+            {
+#if defined(__SSE__)
+                _mm_storeu_ps(sum + c, _mm_add_ps(_mm_loadu_ps(sum + c), _mm_loadu_ps(src + c)));
+#else
+                for (size_t j = c; j < c + 4; j++)
+                    sum[j] += src[j];
+#endif
+            }
+        }
+        pushed = 0;
+    }
+    
+    template <typename Clock>
+    MultiRunningAverage<Clock>::MultiRunningAverage(size_t chans, size_t cap,
+                                                    std::chrono::milliseconds win) :
+        _m(new Imp(chans, cap, win))
+    {
+    }
+    
+    template <typename Clock>
+    MultiRunningAverage<Clock>::~MultiRunningAverage()
+    {
+    }
+    
+    template <typename Clock>
+    size_t MultiRunningAverage<Clock>::channels() const
+    {
+        return _m->channels;
+    }
+    
+    template <typename Clock>
+    void MultiRunningAverage<Clock>::setCapacity(size_t cap)
+    {
+        if (cap == _m->capacity)
+            return;
+        
+        // Copy the newest frames to the start of new rings.
+        
+        size_t kept = std::min(_m->count, cap);
+        size_t skipped = _m->count - kept;
+        std::vector<float> history(cap * _m->stride);
+        std::vector<typename Clock::time_point> times(cap);
+        for (size_t i = 0; i < kept; i++)
+        {
+            size_t j = (_m->first + skipped + i) % _m->capacity;
+            std::copy(_m->row(j), _m->row(j) + _m->stride, history.data() + i * _m->stride);
+            times[i] = _m->times[j];
+        }
+        _m->history.swap(history);
+        _m->times.swap(times);
+        _m->capacity = cap;
+        _m->first = 0;
+        _m->count = kept;
+        _m->resum();
+    }
+    
+    template <typename Clock>
+    size_t MultiRunningAverage<Clock>::capacity() const
+    {
+        return _m->capacity;
+    }
+    
+    template <typename Clock>
+    void MultiRunningAverage<Clock>::setWindow(std::chrono::milliseconds win)
+    {
+        _m->window = win;
+    }
+    
+    template <typename Clock>
+    std::chrono::milliseconds MultiRunningAverage<Clock>::window() const
+    {
+        return _m->window;
+    }
+    
+    template <typename Clock>
+    void MultiRunningAverage<Clock>::add(const float* frame)
+    {
+        _m->push(frame, Clock::now());
+    }
+    
+    template <typename Clock>
+    void MultiRunningAverage<Clock>::add(const float* frame, typename Clock::time_point t)
+    {
+        _m->push(frame, t);
+    }
+    
+    template <typename Clock>
+    size_t MultiRunningAverage<Clock>::size() const
+    {
+        return _m->count;
+    }
+    
+    template <typename Clock>
+    const std::vector<float>& MultiRunningAverage<Clock>::operator()()
+    {
+        std::vector<float>& averages = _m->averages;
+        if (_m->count == 0)
+        {
+            std::fill(averages.begin(), averages.end(), 0.0f);
+            return averages;
+        }
+        
+        // The sums are divided rather than multiplied by the reciprocal of
+        // the count, for correctly rounded quotients.  The sums themselves
+        // are plain, periodically recomputed float sums rather than the
+        // compensated sums of RunningAverage<float>, so the averages agree
+        // with its averages only to within rounding error.
+        
+        const float* sum = _m->sums.data();
+        float n = float(_m->count);
+        size_t c = 0;
+#if defined(__SSE__)
+        for (; c + 4 <= _m->channels; c += 4)
+            _mm_storeu_ps(&averages[c], _mm_div_ps(_mm_loadu_ps(sum + c), _mm_set1_ps(n)));
+#endif
+        for (; c < _m->channels; c++)
+            averages[c] = sum[c] / n;
+        return averages;
+    }
+    
+}
+
+#endif
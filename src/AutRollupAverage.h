@@ -0,0 +1,106 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutRollupAverage.h
+//
+// A template class to compute averages, minimums and maximums of values over
+// long time windows (e.g., minutes or hours of values added a thousand times
+// a second) with little memory.  The values are summarized in buckets of
+// time: the newest bucket keeps the values themselves, and older buckets
+// keep only the sum, count, minimum and maximum of their values.  Buckets
+// are rolled up into buckets twice as long as they age, in levels, so the
+// memory grows with the logarithm of the longest window, and a statistic
+// over any window takes time proportional to the number of levels.
+//
+
+#ifndef __AutRollupAverage__
+#define __AutRollupAverage__
+
+#include <chrono>
+#include <memory>
+
+namespace Aut
+{
+    
+    template <typename T, typename Clock = std::chrono::steady_clock>
+    class RollupAverage
+    {
+    public:
+        
+        // The resolution is the duration of the newest buckets, the longest
+        // window is the longest for which statistics are kept, and the
+        // number of buckets per level controls the precision at the edges
+        // of windows, explained below.
+        
+        RollupAverage(std::chrono::milliseconds resolution = std::chrono::milliseconds(10),
+                      std::chrono::milliseconds longestWindow = std::chrono::hours(1),
+                      size_t bucketsPerLevel = 8);
+        ~RollupAverage();
+        
+        std::chrono::milliseconds   resolution() const;
+        std::chrono::milliseconds   longestWindow() const;
+        size_t                      bucketsPerLevel() const;
+        
+        // Return the number of levels of buckets.
+        
+        size_t                      levels() const;
+        
+        // Add a value as of the current time, or as of the specified time,
+        // as for RunningAverage<T>.  Times should not decrease from one
+        // value to the next.
+        
+        void                        add(const T&);
+        void                        add(const T&, typename Clock::time_point);
+        
+        // Return statistics of the values added within the specified window
+        // before the time of the newest value, or T() (or 0) if there are
+        // none.  Within the newest bucket the values themselves are used.
+        // A window that starts inside an older bucket uses the finest
+        // bucket that spans its start; that bucket's sum and count are
+        // apportioned by the fraction of its time inside the window, as if
+        // its values were spread evenly, and its minimum and maximum are
+        // used whole.  Such a bucket is at most a 1 / (bucketsPerLevel - 1)
+        // fraction of the window's length, roughly.  The count may be
+        // fractional for the same reason.
+        
+        T                           average(std::chrono::milliseconds window) const;
+        T                           min(std::chrono::milliseconds window) const;
+        T                           max(std::chrono::milliseconds window) const;
+        double                      count(std::chrono::milliseconds window) const;
+        
+    private:
+        
+        // Details of the class' data are "hidden" in the Imp.h file.
+        
+        class Imp;
+        std::unique_ptr<Imp> _m;
+    };
+    
+}
+
+// The template definitions in the following header file should be considered
+// private implementation details.
+
+#include "AutRollupAverageImp.h"
+
+#endif
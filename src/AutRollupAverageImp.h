@@ -0,0 +1,387 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutRollupAverageImp.h
+//
+// The template definitions in the this header file should be considered
+// private implementation details.
+//
+
+#ifndef __AutRollupAverageImp_h
+#define __AutRollupAverageImp_h
+
+#include "AutRollupAverage.h"
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+namespace Aut
+{
+    template <typename T, typename Clock>
+    class RollupAverage<T, Clock>::Imp
+    {
+    public:
+        Imp(std::chrono::milliseconds res, std::chrono::milliseconds longest, size_t perLevel);
+        
+        typedef typename Clock::time_point      TimePoint;
+        typedef typename Clock::duration        Duration;
+        
+        struct Bucket
+        {
+            TimePoint   start;
+            T           sum;
+            uint64_t    count;
+            T           min;
+            T           max;
+        };
+        
+        // Each level's buckets are twice as long as the previous level's, and
+        // start at multiples of their duration.  A level holds its most
+        // recent complete buckets (those with values) in a ring, newest
+        // first, and the bucket being filled by the previous level.  When a
+        // level's ring overflows, the oldest bucket is dropped; its values
+        // remain in the next level, and the horizon marks the time before
+        // which the level's buckets are incomplete.
+        
+        struct Level
+        {
+            Duration                width;
+            std::vector<Bucket>     ring;
+            size_t                  newest;
+            size_t                  size;
+            bool                    filling;
+            Bucket                  current;
+            bool                    evicted;
+            TimePoint               horizon;
+        };
+        
+        struct Summary
+        {
+            double      sum;
+            double      count;
+            T           min;
+            T           max;
+        };
+        
+        TimePoint   align(TimePoint, Duration) const;
+        void        include(Bucket&, const T&) const;
+        void        merge(Bucket&, const Bucket&) const;
+        void        include(Summary&, const Bucket&, double fraction) const;
+        void        complete(size_t level, const Bucket&);
+        void        push(const T&, TimePoint);
+        Summary     summarize(std::chrono::milliseconds window) const;
+        
+        std::chrono::milliseconds               resolution;
+        std::chrono::milliseconds               longest;
+        std::vector<Level>                      levels;
+        
+        // The values in the newest bucket, and the time of the newest value.
+        
+        std::vector<std::pair<TimePoint, T>>    values;
+        bool                                    any;
+        TimePoint                               last;
+    };
+    
+    template <typename T, typename Clock>
+    RollupAverage<T, Clock>::Imp::Imp(std::chrono::milliseconds res, std::chrono::milliseconds lng,
+                                      size_t perLevel) :
+        resolution(res), longest(lng), any(false)
+    {
+        // Each level needs room for the buckets not yet rolled up into the
+        // next level, and a few more.
+        
+        if (perLevel < 4)
+            perLevel = 4;
+        
+        Duration width = std::chrono::duration_cast<Duration>(res);
+        if (width <= Duration::zero())
+            width = Duration(1);
+        do
+        {
+            Level level;
+            level.width = width;
+            level.ring.resize(perLevel);
+            level.newest = 0;
+            level.size = 0;
+            level.filling = false;
+            level.evicted = false;
+            levels.push_back(level);
+            width *= 2;
+        }
+        while (levels.back().width * typename Duration::rep(perLevel) < lng);
+    }
+    
+    template <typename T, typename Clock>
+    typename RollupAverage<T, Clock>::Imp::TimePoint
+    RollupAverage<T, Clock>::Imp::align(TimePoint t, Duration width) const
+    {
+        Duration d = t.time_since_epoch();
+        Duration r = d % width;
+        if (r < Duration::zero())
+            r += width;
+        return TimePoint(d - r);
+    }
+    
+    template <typename T, typename Clock>
+    void RollupAverage<T, Clock>::Imp::include(Bucket& bucket, const T& x) const
+    {
+        if (bucket.count == 0)
+        {
+            bucket.sum = x;
+            bucket.min = x;
+            bucket.max = x;
+        }
+        else
+        {
+            bucket.sum += x;
+            if (x < bucket.min)
+                bucket.min = x;
+            if (bucket.max < x)
+                bucket.max = x;
+        }
+        bucket.count++;
+    }
+    
+    template <typename T, typename Clock>
+    void RollupAverage<T, Clock>::Imp::merge(Bucket& bucket, const Bucket& other) const
+    {
+        bucket.sum += other.sum;
+        bucket.count += other.count;
+        if (other.min < bucket.min)
+            bucket.min = other.min;
+        if (bucket.max < other.max)
+            bucket.max = other.max;
+    }
+    
+    template <typename T, typename Clock>
+    void RollupAverage<T, Clock>::Imp::include(Summary& summary, const Bucket& bucket,
+                                               double fraction) const
+    {
+        if (summary.count == 0.0)
+        {
+            summary.min = bucket.min;
+            summary.max = bucket.max;
+        }
+        else
+        {
+            if (bucket.min < summary.min)
+                summary.min = bucket.min;
+            if (summary.max < bucket.max)
+                summary.max = bucket.max;
+        }
+        summary.sum += double(bucket.sum) * fraction;
+        summary.count += double(bucket.count) * fraction;
+    }
+    
+    template <typename T, typename Clock>
+    void RollupAverage<T, Clock>::Imp::complete(size_t i, const Bucket& bucket)
+    {
+        Level& level = levels[i];
+        if (level.size == level.ring.size())
+        {
+            const Bucket& oldest = level.ring[(level.newest + 1) % level.ring.size()];
+            level.horizon = oldest.start + level.width;
+            level.evicted = true;
+            level.size--;
+        }
+        level.newest = (level.newest + 1) % level.ring.size();
+        level.ring[level.newest] = bucket;
+        level.size++;
+        
+        // Roll the bucket up into the next level's bucket that contains it,
+        // completing that bucket first if this one is past it.
+        
+        if (i + 1 == levels.size())
+            return;
+        Level& next = levels[i + 1];
+        TimePoint start = align(bucket.start, next.width);
+        if (next.filling && (next.current.start != start))
+        {
+            next.filling = false;
+            complete(i + 1, next.current);
+        }
+        if (!next.filling)
+        {
+            next.current = bucket;
+            next.current.start = start;
+            next.filling = true;
+        }
+        else
+        {
+            merge(next.current, bucket);
+        }
+    }
+    
+    template <typename T, typename Clock>
+    void RollupAverage<T, Clock>::Imp::push(const T& x, TimePoint t)
+    {
+        Level& first = levels[0];
+        TimePoint start = align(t, first.width);
+        if (first.filling && (first.current.start != start))
+        {
+            first.filling = false;
+            complete(0, first.current);
+            values.clear();
+        }
+        if (!first.filling)
+        {
+            first.current.start = start;
+            first.current.count = 0;
+            first.filling = true;
+        }
+        include(first.current, x);
+        values.push_back(std::make_pair(t, x));
+        last = t;
+        any = true;
+    }
+    
+    template <typename T, typename Clock>
+    typename RollupAverage<T, Clock>::Imp::Summary
+    RollupAverage<T, Clock>::Imp::summarize(std::chrono::milliseconds window) const
+    {
+        Summary summary = { 0.0, 0.0, T(), T() };
+        if (!any)
+            return summary;
+        
+        TimePoint windowStart = last - std::chrono::duration_cast<Duration>(window);
+        for (const std::pair<TimePoint, T>& value : values)
+        {
+            if (value.first >= windowStart)
+            {
+                Bucket one = { value.first, value.second, 1, value.second, value.second };
+                include(summary, one, 1.0);
+            }
+        }
+        
+        // Then go back in time from the newest bucket, through each level's
+        // complete buckets until reaching either the window's start or the
+        // start of the next level's buckets that are entirely older.
+        
+        TimePoint covered = levels[0].current.start;
+        for (size_t i = 0; (i < levels.size()) && (windowStart < covered); i++)
+        {
+            const Level& level = levels[i];
+            bool deepest = (i + 1 == levels.size()) || !level.evicted;
+            TimePoint stop = deepest ? TimePoint::min() :
+                align(level.horizon + levels[i + 1].width - Duration(1), levels[i + 1].width);
+            
+            for (size_t k = 0; k < level.size; k++)
+            {
+                const Bucket& bucket = level.ring[(level.newest + level.ring.size() - k) % level.ring.size()];
+                TimePoint end = bucket.start + level.width;
+                if (end > covered)
+                    continue;
+                if ((bucket.start < stop) || (end <= windowStart))
+                    break;
+                if (bucket.start < windowStart)
+                {
+                    include(summary, bucket, double((end - windowStart).count()) /
+                            double(level.width.count()));
+                    return summary;
+                }
+                include(summary, bucket, 1.0);
+            }
+            if (deepest)
+                break;
+            covered = stop;
+        }
+        return summary;
+    }
+    
+    template <typename T, typename Clock>
+    RollupAverage<T, Clock>::RollupAverage(std::chrono::milliseconds resolution,
+                                           std::chrono::milliseconds longestWindow,
+                                           size_t bucketsPerLevel) :
+        _m(new Imp(resolution, longestWindow, bucketsPerLevel))
+    {
+    }
+    
+    template <typename T, typename Clock>
+    RollupAverage<T, Clock>::~RollupAverage()
+    {
+    }
+    
+    template <typename T, typename Clock>
+    std::chrono::milliseconds RollupAverage<T, Clock>::resolution() const
+    {
+        return _m->resolution;
+    }
+    
+    template <typename T, typename Clock>
+    std::chrono::milliseconds RollupAverage<T, Clock>::longestWindow() const
+    {
+        return _m->longest;
+    }
+    
+    template <typename T, typename Clock>
+    size_t RollupAverage<T, Clock>::bucketsPerLevel() const
+    {
+        return _m->levels[0].ring.size();
+    }
+    
+    template <typename T, typename Clock>
+    size_t RollupAverage<T, Clock>::levels() const
+    {
+        return _m->levels.size();
+    }
+    
+    template <typename T, typename Clock>
+    void RollupAverage<T, Clock>::add(const T& x)
+    {
+        _m->push(x, Clock::now());
+    }
+    
+    template <typename T, typename Clock>
+    void RollupAverage<T, Clock>::add(const T& x, typename Clock::time_point t)
+    {
+        _m->push(x, t);
+    }
+    
+    template <typename T, typename Clock>
+    T RollupAverage<T, Clock>::average(std::chrono::milliseconds window) const
+    {
+        typename Imp::Summary summary = _m->summarize(window);
+        return (summary.count > 0.0) ? T(summary.sum / summary.count) : T();
+    }
+    
+    template <typename T, typename Clock>
+    T RollupAverage<T, Clock>::min(std::chrono::milliseconds window) const
+    {
+        return _m->summarize(window).min;
+    }
+    
+    template <typename T, typename Clock>
+    T RollupAverage<T, Clock>::max(std::chrono::milliseconds window) const
+    {
+        return _m->summarize(window).max;
+    }
+    
+    template <typename T, typename Clock>
+    double RollupAverage<T, Clock>::count(std::chrono::milliseconds window) const
+    {
+        return _m->summarize(window).count;
+    }
+    
+}
+
+#endif
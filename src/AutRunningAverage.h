@@ -24,7 +24,9 @@
 // AutRunningAverage.h
 //
 // A template class to compute running averages, with a time window to prevent
-// out-of-date values from skewing recent values.
+// out-of-date values from skewing recent values.  The times of values come
+// from the clock that is the second template parameter, by default the
+// monotonic std::chrono::steady_clock, or are supplied by the caller.
 //
 
 #ifndef _AutRunningAverage_h
@@ -32,11 +34,12 @@
 
 #include <chrono>
 #include <memory>
+#include <string>
 
 namespace Aut
 {
     
-    template <typename T>
+    template <typename T, typename Clock = std::chrono::steady_clock>
     class RunningAverage
     {
     public:
@@ -50,28 +53,49 @@ namespace Aut
         ~RunningAverage();
         
         // Set and get the number of the most recent values that will be used in
-        // the average, assuming that the time between values does not exceed the
-        // time window.
+        // the average, assuming that they are all within the time window.
         
         void                        setCapacity(size_t);
         size_t                      capacity() const;
         
-        // Set and get the time window.  If a value is added and the time since
-        // the previously added value exceeds the time window, then the average
-        // is reset to just the most recently added value (so the older values
+        // Set and get the time window.  When a value is added, the values added
+        // more than the time window before it are dropped (so the older values
         // do not skew the average).
         
         void                        setWindow(std::chrono::milliseconds);
         std::chrono::milliseconds   window() const;
         
-        // Add a value to be used in the running average.
+        // Add a value to be used in the running average, as of the current
+        // time.
         
         void                        add(const T&);
         
-        // Return the running average.
+        // Add a value as of the specified time, which saves reading the
+        // clock when the time is already known (e.g., for a batch of values
+        // from one frame).  Times should not decrease from one value to the
+        // next.
+        
+        void                        add(const T&, typename Clock::time_point);
+        
+        // Return the running average, or T() if no values have been added.
+        // The sum of the values is kept up to date as values are added and
+        // dropped, so this routine does not depend on the capacity.
         
         T                           operator()();
         
+        // Save the values, their times and their sum to a snapshot file (see
+        // AutSnapshot.h), with the times as ages before the specified time.
+        // Or restore them, along with the capacity and time window, making
+        // the ages before the specified time.  T must be trivially copyable.
+        // Return false (after reporting the problem with Aut::error()) if
+        // the file cannot be written or read, in which case restoring leaves
+        // the averager unchanged.
+        
+        bool                        save(const std::string& path,
+                                         typename Clock::time_point t = Clock::now()) const;
+        bool                        restore(const std::string& path,
+                                            typename Clock::time_point t = Clock::now());
+        
     private:
 
         // Details of the class' data are "hidden" in the Imp.h file.
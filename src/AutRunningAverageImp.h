@@ -30,81 +30,274 @@
 #ifndef _AutRunningAverageImp_h
 #define _AutRunningAverageImp_h
 
-#include <deque>
+#include "AutRunningSum.h"
+#include "AutSnapshot.h"
+#include "AutAlert.h"
+#include <algorithm>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include <stdint.h>
+#include <string.h>
 
 namespace Aut
 {
-    template <typename T>
-    class RunningAverage<T>::Imp
+    template <typename T, typename Clock>
+    class RunningAverage<T, Clock>::Imp
     {
     public:
-        Imp(size_t cap, std::chrono::milliseconds win) : capacity(cap), window(win) {}
+        Imp(size_t cap, std::chrono::milliseconds win) :
+            window(win), ring(cap), times(cap), first(0), count(0) {}
+        
+        void push(const T&, typename Clock::time_point);
+        void pop();
+        void clear();
+        
         std::chrono::milliseconds                           window;
-        size_t                                              capacity;
-        std::chrono::time_point<std::chrono::system_clock>  time;
-        std::deque<T>                                       deque;
+        
+        // The values and the times they were added are stored in ring buffers
+        // whose size is the capacity, from the oldest, at index first, to the
+        // newest.  The buffers are allocated only when the capacity changes.
+        
+        std::vector<T>                                      ring;
+        std::vector<typename Clock::time_point>             times;
+        size_t                                              first;
+        size_t                                              count;
+        
+        // The sum of the values in the ring, updated as values are added and
+        // removed, so computing the average does not walk the ring.
+        
+        RunningSum<T>                                       sum;
     };
+    
+    template <typename T, typename Clock>
+    void RunningAverage<T, Clock>::Imp::push(const T& x, typename Clock::time_point t)
+    {
+        if (ring.empty())
+            return;
+        
+        // Values older than the window, as of the new value's time, expire
+        // one by one, from the oldest.
+        
+        while ((count > 0) && (t - times[first] > window))
+            pop();
+        
+        // When the ring is full, the newest value replaces the oldest.
+        
+        if (count == ring.size())
+        {
+            sum.subtract(ring[first]);
+            sum.add(x);
+            ring[first] = x;
+            times[first] = t;
+            if (++first == ring.size())
+                first = 0;
+            return;
+        }
+        size_t i = first + count;
+        if (i >= ring.size())
+            i -= ring.size();
+        ring[i] = x;
+        times[i] = t;
+        count++;
+        sum.add(x);
+    }
+    
+    template <typename T, typename Clock>
+    void RunningAverage<T, Clock>::Imp::pop()
+    {
+        sum.subtract(ring[first]);
+        if (++first == ring.size())
+            first = 0;
+        
+        // Starting afresh when the ring empties keeps any error that does
+        // accumulate from persisting.
+        
+        if (--count == 0)
+            clear();
+    }
+    
+    template <typename T, typename Clock>
+    void RunningAverage<T, Clock>::Imp::clear()
+    {
+        first = 0;
+        count = 0;
+        sum.clear();
+    }
 
-    template <typename T>
-    RunningAverage<T>::RunningAverage(size_t cap, std::chrono::milliseconds win) :
+    template <typename T, typename Clock>
+    RunningAverage<T, Clock>::RunningAverage(size_t cap, std::chrono::milliseconds win) :
         _m(new Imp(cap, win))
     {
     }
 
-    template <typename T>
-    RunningAverage<T>::~RunningAverage()
+    template <typename T, typename Clock>
+    RunningAverage<T, Clock>::~RunningAverage()
     {
     }
 
-    template <typename T>
-    void RunningAverage<T>::setCapacity(size_t cap)
+    template <typename T, typename Clock>
+    void RunningAverage<T, Clock>::setCapacity(size_t cap)
     {
-        _m->capacity = cap;
-        while (_m->deque.size() > _m->capacity)
-            _m->deque.pop_front();
+        if (cap == _m->ring.size())
+            return;
+        
+        while (_m->count > cap)
+            _m->pop();
+        
+        // Copy the remaining values to the start of new rings.
+        
+        std::vector<T> ring(cap);
+        std::vector<typename Clock::time_point> times(cap);
+        for (size_t i = 0; i < _m->count; i++)
+        {
+            size_t j = (_m->first + i) % _m->ring.size();
+            ring[i] = _m->ring[j];
+            times[i] = _m->times[j];
+        }
+        _m->ring.swap(ring);
+        _m->times.swap(times);
+        _m->first = 0;
     }
 
-    template <typename T>
-    size_t RunningAverage<T>::capacity() const
+    template <typename T, typename Clock>
+    size_t RunningAverage<T, Clock>::capacity() const
     {
-        return _m->capacity;
+        return _m->ring.size();
     }
     
-    template <typename T>
-    void RunningAverage<T>::setWindow(std::chrono::milliseconds win)
+    template <typename T, typename Clock>
+    void RunningAverage<T, Clock>::setWindow(std::chrono::milliseconds win)
     {
         _m->window = win;
     }
     
-    template <typename T>
-    std::chrono::milliseconds RunningAverage<T>::window() const
+    template <typename T, typename Clock>
+    std::chrono::milliseconds RunningAverage<T, Clock>::window() const
     {
         return _m->window;
     }
 
-    template <typename T>
-    void RunningAverage<T>::add(const T& x)
+    template <typename T, typename Clock>
+    void RunningAverage<T, Clock>::add(const T& x)
+    {
+        _m->push(x, Clock::now());
+    }
+
+    template <typename T, typename Clock>
+    void RunningAverage<T, Clock>::add(const T& x, typename Clock::time_point t)
     {
-        std::chrono::time_point<std::chrono::system_clock> now =
-            std::chrono::system_clock::now();
+        _m->push(x, t);
+    }
+
+    template <typename T, typename Clock>
+    T RunningAverage<T, Clock>::operator()()
+    {
+        if (_m->count == 0)
+            return T();
+        return _m->sum() / _m->count;
+    }
 
-        if (now - _m->time > _m->window)
-            _m->deque.clear();
+    template <typename T, typename Clock>
+    bool RunningAverage<T, Clock>::save(const std::string& path, typename Clock::time_point t) const
+    {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "Saved values must be trivially copyable");
+        
+        SnapshotHeader header;
+        memset(&header, 0, sizeof(header));
+        header.kind = SnapshotRunningAverage;
+        header.valueSize = sizeof(T);
+        header.recordSize = sizeof(RunningSum<T>);
+        header.capacity = _m->ring.size();
+        header.window = _m->window.count();
+        header.streams = 1;
+        header.values = _m->count;
+        
+        std::vector<int64_t> ages(_m->count);
+        for (size_t i = 0; i < _m->count; i++)
+        {
+            typename Clock::time_point time = _m->times[(_m->first + i) % _m->ring.size()];
+            ages[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(t - time).count();
+        }
         
-        _m->time = now;
+        // The values are written from the ring in place, in two pieces if it
+        // wraps around.
         
-        _m->deque.push_back(x);
-        if (_m->deque.size() > _m->capacity)
-            _m->deque.pop_front();
+        size_t head = std::min(_m->count, _m->ring.size() - _m->first);
+        std::vector<SnapshotBlock> blocks;
+        SnapshotBlock sum = { &_m->sum, sizeof(RunningSum<T>) };
+        SnapshotBlock times = { ages.data(), ages.size() * sizeof(int64_t) };
+        SnapshotBlock newer = { _m->ring.data() + _m->first, head * sizeof(T) };
+        SnapshotBlock older = { _m->ring.data(), (_m->count - head) * sizeof(T) };
+        blocks.push_back(sum);
+        blocks.push_back(times);
+        blocks.push_back(newer);
+        blocks.push_back(older);
+        return writeSnapshot(path, header, blocks);
     }
-
-    template <typename T>
-    T RunningAverage<T>::operator()()
+    
+    template <typename T, typename Clock>
+    bool RunningAverage<T, Clock>::restore(const std::string& path, typename Clock::time_point t)
     {
-        T sum = T();
-        for (auto x : _m->deque)
-            sum += x;
-        return sum / _m->deque.size();
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "Restored values must be trivially copyable");
+        
+        SnapshotFile file(path, SnapshotRunningAverage, sizeof(T), 0, sizeof(RunningSum<T>),
+                          sizeof(int64_t) + sizeof(T));
+        if (!file.valid())
+            return false;
+        const SnapshotHeader& header = file.header();
+        if ((header.streams != 1) || (header.values > header.capacity))
+        {
+            error("Snapshot file \"" + path + "\" has more values than its capacity");
+            return false;
+        }
+        if (header.window < 0)
+        {
+            error("Snapshot file \"" + path + "\" has a negative time window");
+            return false;
+        }
+        
+        // The capacity is not bounded by the file's size, since an averager
+        // need not be full, so one too large to allocate is reported rather
+        // than left to end the process.
+        
+        if (header.capacity > std::min(std::vector<T>().max_size(),
+                                       std::vector<typename Clock::time_point>().max_size()))
+        {
+            error("Snapshot file \"" + path + "\" has a capacity too large to allocate");
+            return false;
+        }
+        
+        // The state is built apart, and replaces the current state only when
+        // it is complete.
+        
+        size_t count = size_t(header.values);
+        std::unique_ptr<Imp> m;
+        try
+        {
+            m.reset(new Imp(size_t(header.capacity), std::chrono::milliseconds(header.window)));
+        }
+        catch (const std::bad_alloc&)
+        {
+            error("Snapshot file \"" + path + "\" has a capacity too large to allocate");
+            return false;
+        }
+        const char* body = file.body();
+        memcpy(static_cast<void*>(&m->sum), body, sizeof(RunningSum<T>));
+        body += sizeof(RunningSum<T>);
+        for (size_t i = 0; i < count; i++)
+        {
+            int64_t age;
+            memcpy(&age, body + i * sizeof(int64_t), sizeof(int64_t));
+            m->times[i] = t - std::chrono::duration_cast<typename Clock::duration>(std::chrono::nanoseconds(age));
+        }
+        if (count > 0)
+            memcpy(static_cast<void*>(m->ring.data()), body + count * sizeof(int64_t), count * sizeof(T));
+        m->count = count;
+        _m.swap(m);
+        return true;
     }
 
 }
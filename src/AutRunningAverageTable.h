@@ -0,0 +1,148 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutRunningAverageTable.h
+//
+// A template class to compute running averages of many independent streams
+// of values, each identified by a key.  The streams are stored in flat
+// arrays, found with an open-addressed hash table, and their values are
+// stored in one slab, so each stream costs little more than its values.
+// Unlike RunningAverage<T>, which keeps the time of each value and drops
+// values one by one as they leave the time window, a stream keeps only the
+// time of its newest value, and starts over when a value arrives after a
+// gap longer than the time window.  Streams to which no value has been
+// added for longer than the time window can be removed with expire().
+//
+
+#ifndef __AutRunningAverageTable__
+#define __AutRunningAverageTable__
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Aut
+{
+    
+    template <typename Key, typename T, typename Hash = std::hash<Key>>
+    class RunningAverageTable
+    {
+    public:
+        
+        // The capacity and time window apply to every stream.  The capacity
+        // is fixed, and limits each stream's average to its most recent
+        // values, as for RunningAverage<T>; the time window works as below.
+        
+        RunningAverageTable(size_t capacity = 5,
+                            std::chrono::milliseconds window =
+                            std::chrono::milliseconds(500));
+        ~RunningAverageTable();
+        
+        size_t                      capacity() const;
+        
+        // Set and get the time window.  If a value is added to a stream and
+        // the time since the previous value was added exceeds the time
+        // window, the stream's average is reset to just the new value.
+        // Otherwise all the stream's values (up to the capacity) are kept,
+        // however long ago the older ones were added.
+        
+        void                        setWindow(std::chrono::milliseconds);
+        std::chrono::milliseconds   window() const;
+        
+        // Add a value to the stream with the specified key, as of the
+        // specified time, making a stream if there is none.
+        
+        void                        add(const Key&, const T&,
+                                        std::chrono::steady_clock::time_point t =
+                                        std::chrono::steady_clock::now());
+        
+        // Add a batch of values, each to the stream with the corresponding
+        // key, all as of the same time.  Room for new streams is made once
+        // for the whole batch.
+        
+        void                        add(const std::vector<Key>& keys,
+                                        const std::vector<T>& values,
+                                        std::chrono::steady_clock::time_point t =
+                                        std::chrono::steady_clock::now());
+        
+        // Return the running average of the stream with the specified key,
+        // or T() if there is no such stream.
+        
+        T                           operator()(const Key&) const;
+        
+        // Return whether there is a stream with the specified key.
+        
+        bool                        contains(const Key&) const;
+        
+        // Remove the stream with the specified key, if any.
+        
+        void                        remove(const Key&);
+        
+        // Remove the streams to which no value has been added for longer
+        // than the time window, as of the specified time, returning the
+        // number removed.
+        
+        size_t                      expire(std::chrono::steady_clock::time_point t =
+                                           std::chrono::steady_clock::now());
+        
+        // Return the number of streams.
+        
+        size_t                      size() const;
+        
+        // Reserve room for a number of streams.
+        
+        void                        reserve(size_t count);
+        
+        // Save all the streams to a snapshot file (see AutSnapshot.h), with
+        // the times of their newest values as ages before the specified
+        // time, or restore them, along with the capacity and time window,
+        // making the ages before the specified time.  Key and T must be
+        // trivially copyable.  Return false (after reporting the problem
+        // with Aut::error()) if the file cannot be written or read, in which
+        // case restoring leaves the table unchanged.
+        
+        bool                        save(const std::string& path,
+                                         std::chrono::steady_clock::time_point t =
+                                         std::chrono::steady_clock::now()) const;
+        bool                        restore(const std::string& path,
+                                            std::chrono::steady_clock::time_point t =
+                                            std::chrono::steady_clock::now());
+        
+    private:
+        
+        // Details of the class' data are "hidden" in the Imp.h file.
+        
+        class Imp;
+        std::unique_ptr<Imp> _m;
+    };
+    
+}
+
+// The template definitions in the following header file should be considered
+// private implementation details.
+
+#include "AutRunningAverageTableImp.h"
+
+#endif
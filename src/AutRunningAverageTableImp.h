@@ -0,0 +1,476 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutRunningAverageTableImp.h
+//
+// The template definitions in the this header file should be considered
+// private implementation details.
+//
+
+#ifndef __AutRunningAverageTableImp_h
+#define __AutRunningAverageTableImp_h
+
+#include "AutRunningAverageTable.h"
+#include "AutRunningSum.h"
+#include "AutSnapshot.h"
+#include "AutAlert.h"
+#include <algorithm>
+#include <type_traits>
+#include <stdint.h>
+#include <string.h>
+
+namespace Aut
+{
+    template <typename Key, typename T, typename Hash>
+    class RunningAverageTable<Key, T, Hash>::Imp
+    {
+    public:
+        Imp(size_t cap, std::chrono::milliseconds win) :
+            capacity(cap), window(win), shift(64) {}
+        
+        static const uint32_t empty = uint32_t(-1);
+        
+        // A stream's values are in a ring in the slab, at capacity times the
+        // stream's index, from the oldest, at first, to the newest.
+        
+        struct Stream
+        {
+            Key                                     key;
+            std::chrono::steady_clock::time_point   time;
+            uint32_t                                first;
+            uint32_t                                count;
+            RunningSum<T>                           sum;
+        };
+        
+        // A stream as saved in a snapshot file, with its time as an age in
+        // nanoseconds.
+        
+        struct Record
+        {
+            Key                                     key;
+            int64_t                                 age;
+            uint32_t                                first;
+            uint32_t                                count;
+            RunningSum<T>                           sum;
+        };
+        
+        size_t      home(const Key&) const;
+        size_t      find(const Key&) const;
+        uint32_t    insert(const Key&, std::chrono::steady_clock::time_point);
+        void        push(uint32_t stream, const T&, std::chrono::steady_clock::time_point);
+        void        erase(size_t bucket);
+        void        grow(size_t count);
+        
+        size_t                                      capacity;
+        std::chrono::milliseconds                   window;
+        Hash                                        hash;
+        
+        // The buckets hold the indices of the streams, with linear probing
+        // from each key's home bucket.  Their number is a power of two, and
+        // they are at most three quarters full.
+        
+        std::vector<uint32_t>                       buckets;
+        size_t                                      shift;
+        std::vector<Stream>                         streams;
+        std::vector<T>                              slab;
+    };
+    
+    template <typename Key, typename T, typename Hash>
+    const uint32_t RunningAverageTable<Key, T, Hash>::Imp::empty;
+    
+    template <typename Key, typename T, typename Hash>
+    size_t RunningAverageTable<Key, T, Hash>::Imp::home(const Key& key) const
+    {
+        // Fibonacci hashing spreads the hash's bits, since hashes of
+        // integers are often the integers themselves.
+        
+        return size_t((uint64_t(hash(key)) * 0x9E3779B97F4A7C15ull) >> shift);
+    }
+    
+    template <typename Key, typename T, typename Hash>
+    size_t RunningAverageTable<Key, T, Hash>::Imp::find(const Key& key) const
+    {
+        if (buckets.empty())
+            return size_t(-1);
+        
+        size_t mask = buckets.size() - 1;
+        for (size_t i = home(key); ; i = (i + 1) & mask)
+        {
+            if (buckets[i] == empty)
+                return size_t(-1);
+            if (streams[buckets[i]].key == key)
+                return i;
+        }
+    }
+    
+    template <typename Key, typename T, typename Hash>
+    uint32_t RunningAverageTable<Key, T, Hash>::Imp::insert(const Key& key,
+                                                            std::chrono::steady_clock::time_point t)
+    {
+        size_t mask = buckets.size() - 1;
+        size_t i = home(key);
+        for (; buckets[i] != empty; i = (i + 1) & mask)
+        {
+            if (streams[buckets[i]].key == key)
+                return buckets[i];
+        }
+        
+        Stream stream;
+        stream.key = key;
+        stream.time = t;
+        stream.first = 0;
+        stream.count = 0;
+        streams.push_back(stream);
+        slab.resize(streams.size() * capacity);
+        buckets[i] = uint32_t(streams.size() - 1);
+        return buckets[i];
+    }
+    
+    template <typename Key, typename T, typename Hash>
+    void RunningAverageTable<Key, T, Hash>::Imp::push(uint32_t index, const T& x,
+                                                      std::chrono::steady_clock::time_point t)
+    {
+        Stream& stream = streams[index];
+        if (t - stream.time > window)
+        {
+            stream.first = 0;
+            stream.count = 0;
+            stream.sum.clear();
+        }
+        stream.time = t;
+        
+        if (capacity == 0)
+            return;
+        
+        T* ring = &slab[index * capacity];
+        if (stream.count == capacity)
+        {
+            stream.sum.subtract(ring[stream.first]);
+            ring[stream.first] = x;
+            if (++stream.first == capacity)
+                stream.first = 0;
+        }
+        else
+        {
+            size_t i = stream.first + stream.count;
+            ring[(i < capacity) ? i : i - capacity] = x;
+            stream.count++;
+        }
+        stream.sum.add(x);
+    }
+    
+    template <typename Key, typename T, typename Hash>
+    void RunningAverageTable<Key, T, Hash>::Imp::erase(size_t bucket)
+    {
+        uint32_t index = buckets[bucket];
+        
+        // Shift later entries of the probe sequence back into the hole, so
+        // lookups need no markers for removed entries.
+        
+        size_t mask = buckets.size() - 1;
+        size_t i = bucket;
+        for (size_t j = (i + 1) & mask; buckets[j] != empty; j = (j + 1) & mask)
+        {
+            size_t k = home(streams[buckets[j]].key);
+            if (((j - k) & mask) >= ((j - i) & mask))
+            {
+                buckets[i] = buckets[j];
+                i = j;
+            }
+        }
+        buckets[i] = empty;
+        
+        // Move the last stream into the removed stream's place.
+        
+        uint32_t last = uint32_t(streams.size() - 1);
+        if (index != last)
+        {
+            for (size_t j = home(streams[last].key); ; j = (j + 1) & mask)
+            {
+                if (buckets[j] == last)
+                {
+                    buckets[j] = index;
+                    break;
+                }
+            }
+            streams[index] = streams[last];
+            std::copy(slab.begin() + last * capacity, slab.begin() + (last + 1) * capacity,
+                      slab.begin() + index * capacity);
+        }
+        streams.pop_back();
+        slab.resize(streams.size() * capacity);
+    }
+    
+    template <typename Key, typename T, typename Hash>
+    void RunningAverageTable<Key, T, Hash>::Imp::grow(size_t count)
+    {
+        if (count * 4 <= buckets.size() * 3)
+            return;
+        
+        size_t size = 16;
+        size_t bits = 4;
+        while (count * 4 > size * 3)
+        {
+            size *= 2;
+            bits++;
+        }
+        buckets.assign(size, empty);
+        shift = 64 - bits;
+        
+        size_t mask = size - 1;
+        for (size_t s = 0; s < streams.size(); s++)
+        {
+            size_t i = home(streams[s].key);
+            while (buckets[i] != empty)
+                i = (i + 1) & mask;
+            buckets[i] = uint32_t(s);
+        }
+        streams.reserve(count);
+        slab.reserve(count * capacity);
+    }
+    
+    template <typename Key, typename T, typename Hash>
+    RunningAverageTable<Key, T, Hash>::RunningAverageTable(size_t cap, std::chrono::milliseconds win) :
+        _m(new Imp(cap, win))
+    {
+    }
+    
+    template <typename Key, typename T, typename Hash>
+    RunningAverageTable<Key, T, Hash>::~RunningAverageTable()
+    {
+    }
+    
+    template <typename Key, typename T, typename Hash>
+    size_t RunningAverageTable<Key, T, Hash>::capacity() const
+    {
+        return _m->capacity;
+    }
+    
+    template <typename Key, typename T, typename Hash>
+    void RunningAverageTable<Key, T, Hash>::setWindow(std::chrono::milliseconds win)
+    {
+        _m->window = win;
+    }
+    
+    template <typename Key, typename T, typename Hash>
+    std::chrono::milliseconds RunningAverageTable<Key, T, Hash>::window() const
+    {
+        return _m->window;
+    }
+    
+    template <typename Key, typename T, typename Hash>
+    void RunningAverageTable<Key, T, Hash>::add(const Key& key, const T& x,
+                                                std::chrono::steady_clock::time_point t)
+    {
+        _m->grow(_m->streams.size() + 1);
+        _m->push(_m->insert(key, t), x, t);
+    }
+    
+    template <typename Key, typename T, typename Hash>
+    void RunningAverageTable<Key, T, Hash>::add(const std::vector<Key>& keys,
+                                                const std::vector<T>& values,
+                                                std::chrono::steady_clock::time_point t)
+    {
+        _m->grow(_m->streams.size() + keys.size());
+        for (size_t i = 0; i < keys.size(); i++)
+            _m->push(_m->insert(keys[i], t), values[i], t);
+    }
+    
+    template <typename Key, typename T, typename Hash>
+    T RunningAverageTable<Key, T, Hash>::operator()(const Key& key) const
+    {
+        size_t i = _m->find(key);
+        if (i == size_t(-1))
+            return T();
+        const typename Imp::Stream& stream = _m->streams[_m->buckets[i]];
+        if (stream.count == 0)
+            return T();
+        return stream.sum() / stream.count;
+    }
+    
+    template <typename Key, typename T, typename Hash>
+    bool RunningAverageTable<Key, T, Hash>::contains(const Key& key) const
+    {
+        return _m->find(key) != size_t(-1);
+    }
+    
+    template <typename Key, typename T, typename Hash>
+    void RunningAverageTable<Key, T, Hash>::remove(const Key& key)
+    {
+        size_t i = _m->find(key);
+        if (i != size_t(-1))
+            _m->erase(i);
+    }
+    
+    template <typename Key, typename T, typename Hash>
+    size_t RunningAverageTable<Key, T, Hash>::expire(std::chrono::steady_clock::time_point t)
+    {
+        // Going backwards, the stream moved into a removed stream's place
+        // has already been checked.
+        
+        size_t removed = 0;
+        for (size_t s = _m->streams.size(); s-- > 0; )
+        {
+            if (t - _m->streams[s].time > _m->window)
+            {
+                _m->erase(_m->find(_m->streams[s].key));
+                removed++;
+            }
+        }
+        return removed;
+    }
+    
+    template <typename Key, typename T, typename Hash>
+    size_t RunningAverageTable<Key, T, Hash>::size() const
+    {
+        return _m->streams.size();
+    }
+    
+    template <typename Key, typename T, typename Hash>
+    void RunningAverageTable<Key, T, Hash>::reserve(size_t count)
+    {
+        _m->grow(count);
+    }
+    
+    template <typename Key, typename T, typename Hash>
+    bool RunningAverageTable<Key, T, Hash>::save(const std::string& path,
+                                                 std::chrono::steady_clock::time_point t) const
+    {
+        static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<T>::value,
+                      "Saved keys and values must be trivially copyable");
+        
+        SnapshotHeader header;
+        memset(&header, 0, sizeof(header));
+        header.kind = SnapshotRunningAverageTable;
+        header.valueSize = sizeof(T);
+        header.keySize = sizeof(Key);
+        header.recordSize = sizeof(typename Imp::Record);
+        header.capacity = _m->capacity;
+        header.window = _m->window.count();
+        header.streams = _m->streams.size();
+        header.values = _m->slab.size();
+        
+        // Clearing the records first keeps their padding from writing
+        // whatever happened to be in memory.  The slab is written in place.
+        
+        std::vector<typename Imp::Record> records(_m->streams.size());
+        memset(static_cast<void*>(records.data()), 0, records.size() * sizeof(typename Imp::Record));
+        for (size_t s = 0; s < records.size(); s++)
+        {
+            const typename Imp::Stream& stream = _m->streams[s];
+            records[s].key = stream.key;
+            records[s].age = std::chrono::duration_cast<std::chrono::nanoseconds>(t - stream.time).count();
+            records[s].first = stream.first;
+            records[s].count = stream.count;
+            records[s].sum = stream.sum;
+        }
+        
+        std::vector<SnapshotBlock> blocks;
+        SnapshotBlock streams = { records.data(), records.size() * sizeof(typename Imp::Record) };
+        SnapshotBlock slab = { _m->slab.data(), _m->slab.size() * sizeof(T) };
+        blocks.push_back(streams);
+        blocks.push_back(slab);
+        return writeSnapshot(path, header, blocks);
+    }
+    
+    template <typename Key, typename T, typename Hash>
+    bool RunningAverageTable<Key, T, Hash>::restore(const std::string& path,
+                                                    std::chrono::steady_clock::time_point t)
+    {
+        static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<T>::value,
+                      "Restored keys and values must be trivially copyable");
+        
+        SnapshotFile file(path, SnapshotRunningAverageTable, sizeof(T), sizeof(Key),
+                          sizeof(typename Imp::Record), sizeof(T));
+        if (!file.valid())
+            return false;
+        const SnapshotHeader& header = file.header();
+        size_t cap = size_t(header.capacity);
+        if ((cap == 0) ? (header.values != 0) :
+            ((header.values % cap != 0) || (header.values / cap != header.streams)))
+        {
+            error("Snapshot file \"" + path + "\" has streams of the wrong size");
+            return false;
+        }
+        if (header.window < 0)
+        {
+            error("Snapshot file \"" + path + "\" has a negative time window");
+            return false;
+        }
+        
+        // With no streams, the capacity is not bounded by the file's size,
+        // but each stream added later takes that many values in the slab.
+        
+        if (header.capacity > std::vector<T>().max_size())
+        {
+            error("Snapshot file \"" + path + "\" has a capacity too large to allocate");
+            return false;
+        }
+        
+        // The state is built apart, and replaces the current state only when
+        // it is complete.  The slab is copied in one piece, and the buckets
+        // are rebuilt from the keys.
+        
+        std::unique_ptr<Imp> m(new Imp(cap, std::chrono::milliseconds(header.window)));
+        m->hash = _m->hash;
+        m->streams.resize(size_t(header.streams));
+        const char* body = file.body();
+        for (size_t s = 0; s < m->streams.size(); s++)
+        {
+            typename Imp::Record record;
+            memcpy(static_cast<void*>(&record), body + s * sizeof(record), sizeof(record));
+            if ((record.count > cap) || ((record.first >= cap) && (record.first > 0)))
+            {
+                error("Snapshot file \"" + path + "\" has an invalid stream");
+                return false;
+            }
+            typename Imp::Stream& stream = m->streams[s];
+            stream.key = record.key;
+            stream.time = t - std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::nanoseconds(record.age));
+            stream.first = record.first;
+            stream.count = record.count;
+            stream.sum = record.sum;
+        }
+        m->slab.resize(size_t(header.values));
+        if (!m->slab.empty())
+            memcpy(static_cast<void*>(m->slab.data()), body + m->streams.size() * sizeof(typename Imp::Record),
+                   m->slab.size() * sizeof(T));
+        
+        m->grow(m->streams.size());
+        for (size_t s = 0; s < m->streams.size(); s++)
+        {
+            if (m->buckets[m->find(m->streams[s].key)] != s)
+            {
+                error("Snapshot file \"" + path + "\" has a key more than once");
+                return false;
+            }
+        }
+        
+        _m.swap(m);
+        return true;
+    }
+    
+}
+
+#endif
@@ -0,0 +1,113 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutRunningQuantile.h
+//
+// A template class to estimate quantiles (e.g., the median or the 99th
+// percentile) of the values added most recently, with the capacity and time
+// window of RunningAverage<T>.  Unlike the mean, quantiles are not skewed by
+// a few outliers.  The values are counted in logarithmically spaced buckets,
+// as in the DDSketch algorithm, so each estimate is within a specified
+// relative error of the exact quantile, and the memory used depends on the
+// capacity and on the range of magnitudes of the values, not on how many
+// values have been added.
+//
+
+#ifndef __AutRunningQuantile__
+#define __AutRunningQuantile__
+
+#include <chrono>
+#include <memory>
+
+namespace Aut
+{
+    
+    template <typename T, typename Clock = std::chrono::steady_clock>
+    class RunningQuantile
+    {
+    public:
+        
+        // The capacity and time window are as for RunningAverage<T>.  The
+        // relative error is explained below, and must be between 1e-4 and
+        // 0.5; a value outside that range is reported with Aut::error() and
+        // clamped into it.
+        
+        RunningQuantile(size_t capacity = 100,
+                        std::chrono::milliseconds window =
+                        std::chrono::milliseconds(500),
+                        double relativeError = 0.01);
+        ~RunningQuantile();
+        
+        // Set and get the number of the most recent values used, assuming
+        // that they are all within the time window.
+        
+        void                        setCapacity(size_t);
+        size_t                      capacity() const;
+        
+        // Set and get the time window.  When a value is added, the values
+        // added more than the time window before it are dropped.
+        
+        void                        setWindow(std::chrono::milliseconds);
+        std::chrono::milliseconds   window() const;
+        
+        // Return the relative error, a, of the estimates: the estimate of a
+        // quantile whose exact value is x is within a * |x| of x.  Values
+        // with magnitudes below 1e-9 are treated as 0.
+        
+        double                      relativeError() const;
+        
+        // Add a value as of the current time, or as of the specified time,
+        // as for RunningAverage<T>.
+        
+        void                        add(const T&);
+        void                        add(const T&, typename Clock::time_point);
+        
+        // Return the number of values currently used.
+        
+        size_t                      size() const;
+        
+        // Return an estimate of the q quantile, for q between 0 and 1, of
+        // the values currently used, or T() if there are none.  The exact
+        // q quantile of n values is the one at (zero-based) position
+        // floor(q * (n - 1)) when they are sorted.  Estimating takes time
+        // logarithmic in the number of buckets.
+        
+        T                           quantile(double q) const;
+        T                           median() const;
+        
+    private:
+        
+        // Details of the class' data are "hidden" in the Imp.h file.
+        
+        class Imp;
+        std::unique_ptr<Imp> _m;
+    };
+    
+}
+
+// The template definitions in the following header file should be considered
+// private implementation details.
+
+#include "AutRunningQuantileImp.h"
+
+#endif
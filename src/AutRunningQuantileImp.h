@@ -0,0 +1,344 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutRunningQuantileImp.h
+//
+// The template definitions in the this header file should be considered
+// private implementation details.
+//
+
+#ifndef __AutRunningQuantileImp_h
+#define __AutRunningQuantileImp_h
+
+#include "AutRunningQuantile.h"
+#include "AutAlert.h"
+#include <algorithm>
+#include <sstream>
+#include <vector>
+#include <math.h>
+#include <stdint.h>
+
+namespace Aut
+{
+    template <typename T, typename Clock>
+    class RunningQuantile<T, Clock>::Imp
+    {
+    public:
+        Imp(size_t cap, std::chrono::milliseconds win, double error);
+        
+        // A relative error outside the supported range is reported and
+        // clamped into it.  At 0 or 1 and beyond, gamma is meaningless, and
+        // below the range, the buckets between small and large values would
+        // take hundreds of megabytes.
+        
+        static double checkError(double);
+        
+        // Each value goes in a bucket identified by a signed position.  A
+        // value x with |x| >= minMagnitude has key ceil(log(|x|) / log(gamma)),
+        // so the bucket holds values from gamma^(key - 1) to gamma^key, and
+        // every value in it is within the relative error of the bucket's
+        // representative value.  Positive values have positive positions,
+        // increasing with the key; negative values have the mirror-image
+        // positions; and position 0 holds the values treated as 0.
+        
+        int32_t position(const T&) const;
+        T       representative(int32_t) const;
+        
+        // The counts of the buckets from position low, in a Fenwick tree,
+        // which gives the bucket holding the value of any rank in time
+        // logarithmic in the number of buckets.  The range of positions
+        // grows as needed to hold new values.
+        
+        void    tally(int32_t position, int32_t delta);
+        void    cover(int32_t position);
+        int32_t find(size_t rank) const;
+        
+        void    push(const T&, typename Clock::time_point);
+        void    pop();
+        void    resize(size_t cap);
+        
+        static const double                         minMagnitude;
+        static const double                         minError;
+        static const double                         maxError;
+        
+        std::chrono::milliseconds                   window;
+        double                                      error;
+        double                                      gamma;
+        double                                      invLogGamma;
+        int32_t                                     minKey;
+        
+        // The positions of the values and their times, in rings the size of
+        // the capacity, from the oldest, at index first.
+        
+        std::vector<int32_t>                        positions;
+        std::vector<typename Clock::time_point>     times;
+        size_t                                      first;
+        size_t                                      count;
+        
+        int32_t                                     low;
+        std::vector<uint32_t>                       tree;
+    };
+    
+    template <typename T, typename Clock>
+    const double RunningQuantile<T, Clock>::Imp::minMagnitude = 1.0e-9;
+    
+    template <typename T, typename Clock>
+    const double RunningQuantile<T, Clock>::Imp::minError = 1.0e-4;
+    
+    template <typename T, typename Clock>
+    const double RunningQuantile<T, Clock>::Imp::maxError = 0.5;
+    
+    template <typename T, typename Clock>
+    double RunningQuantile<T, Clock>::Imp::checkError(double err)
+    {
+        if ((err >= minError) && (err <= maxError))
+            return err;
+        
+        double clamped = (err > maxError) ? maxError : minError;
+        std::stringstream text;
+        text << "RunningQuantile relative error " << err << " is outside ["
+             << minError << ", " << maxError << "], so " << clamped << " is used";
+        Aut::error(text.str());
+        return clamped;
+    }
+    
+    template <typename T, typename Clock>
+    RunningQuantile<T, Clock>::Imp::Imp(size_t cap, std::chrono::milliseconds win, double err) :
+        window(win), error(checkError(err)), gamma((1.0 + error) / (1.0 - error)),
+        invLogGamma(1.0 / log(gamma)), first(0), count(0), low(0)
+    {
+        minKey = int32_t(ceil(log(minMagnitude) * invLogGamma));
+        positions.resize(cap);
+        times.resize(cap);
+    }
+    
+    template <typename T, typename Clock>
+    int32_t RunningQuantile<T, Clock>::Imp::position(const T& x) const
+    {
+        double m = fabs(double(x));
+        if (!(m >= minMagnitude))
+            return 0;
+        if (m > 1.0e300)
+            m = 1.0e300;
+        int32_t p = int32_t(ceil(log(m) * invLogGamma)) - minKey + 1;
+        return (x < T()) ? -p : p;
+    }
+    
+    template <typename T, typename Clock>
+    T RunningQuantile<T, Clock>::Imp::representative(int32_t p) const
+    {
+        if (p == 0)
+            return T();
+        
+        // The point between the bucket's bounds with equal relative errors
+        // to both.
+        
+        int32_t key = ((p > 0) ? p : -p) + minKey - 1;
+        double m = 2.0 * pow(gamma, double(key)) / (gamma + 1.0);
+        return T((p > 0) ? m : -m);
+    }
+    
+    template <typename T, typename Clock>
+    void RunningQuantile<T, Clock>::Imp::tally(int32_t p, int32_t delta)
+    {
+        for (size_t i = size_t(p - low) + 1; i <= tree.size(); i += i & (~i + 1))
+            tree[i - 1] += uint32_t(delta);
+    }
+    
+    template <typename T, typename Clock>
+    void RunningQuantile<T, Clock>::Imp::cover(int32_t p)
+    {
+        int32_t high = low + int32_t(tree.size());
+        if (!tree.empty() && (p >= low) && (p < high))
+            return;
+        
+        // Grow the range to a power of two at least twice as large, which
+        // keeps the rebuilding rare, and recount the values in use.
+        
+        int32_t newLow = tree.empty() ? p : std::min(low, p);
+        int32_t newHigh = tree.empty() ? p + 1 : std::max(high, p + 1);
+        size_t size = 64;
+        while (size < 2 * size_t(newHigh - newLow))
+            size *= 2;
+        int32_t slack = int32_t(size) - (newHigh - newLow);
+        low = newLow - slack / 2;
+        tree.assign(size, 0);
+        for (size_t i = 0; i < count; i++)
+        {
+            size_t j = first + i;
+            tally(positions[(j < positions.size()) ? j : j - positions.size()], 1);
+        }
+    }
+    
+    template <typename T, typename Clock>
+    int32_t RunningQuantile<T, Clock>::Imp::find(size_t rank) const
+    {
+        // Descend the tree for the first bucket whose cumulative count
+        // exceeds the rank.
+        
+        size_t i = 0;
+        size_t step = 1;
+        while (step * 2 <= tree.size())
+            step *= 2;
+        for (; step > 0; step /= 2)
+        {
+            if ((i + step <= tree.size()) && (tree[i + step - 1] <= rank))
+            {
+                i += step;
+                rank -= tree[i - 1];
+            }
+        }
+        return low + int32_t(i);
+    }
+    
+    template <typename T, typename Clock>
+    void RunningQuantile<T, Clock>::Imp::push(const T& x, typename Clock::time_point t)
+    {
+        if (positions.empty())
+            return;
+        
+        while ((count > 0) && (t - times[first] > window))
+            pop();
+        if (count == positions.size())
+            pop();
+        
+        int32_t p = position(x);
+        cover(p);
+        tally(p, 1);
+        size_t i = first + count;
+        if (i >= positions.size())
+            i -= positions.size();
+        positions[i] = p;
+        times[i] = t;
+        count++;
+    }
+    
+    template <typename T, typename Clock>
+    void RunningQuantile<T, Clock>::Imp::pop()
+    {
+        tally(positions[first], -1);
+        if (++first == positions.size())
+            first = 0;
+        if (--count == 0)
+            first = 0;
+    }
+    
+    template <typename T, typename Clock>
+    void RunningQuantile<T, Clock>::Imp::resize(size_t cap)
+    {
+        while (count > cap)
+            pop();
+        
+        std::vector<int32_t> newPositions(cap);
+        std::vector<typename Clock::time_point> newTimes(cap);
+        for (size_t i = 0; i < count; i++)
+        {
+            size_t j = (first + i) % positions.size();
+            newPositions[i] = positions[j];
+            newTimes[i] = times[j];
+        }
+        positions.swap(newPositions);
+        times.swap(newTimes);
+        first = 0;
+    }
+    
+    template <typename T, typename Clock>
+    RunningQuantile<T, Clock>::RunningQuantile(size_t cap, std::chrono::milliseconds win,
+                                               double error) :
+        _m(new Imp(cap, win, error))
+    {
+    }
+    
+    template <typename T, typename Clock>
+    RunningQuantile<T, Clock>::~RunningQuantile()
+    {
+    }
+    
+    template <typename T, typename Clock>
+    void RunningQuantile<T, Clock>::setCapacity(size_t cap)
+    {
+        if (cap != _m->positions.size())
+            _m->resize(cap);
+    }
+    
+    template <typename T, typename Clock>
+    size_t RunningQuantile<T, Clock>::capacity() const
+    {
+        return _m->positions.size();
+    }
+    
+    template <typename T, typename Clock>
+    void RunningQuantile<T, Clock>::setWindow(std::chrono::milliseconds win)
+    {
+        _m->window = win;
+    }
+    
+    template <typename T, typename Clock>
+    std::chrono::milliseconds RunningQuantile<T, Clock>::window() const
+    {
+        return _m->window;
+    }
+    
+    template <typename T, typename Clock>
+    double RunningQuantile<T, Clock>::relativeError() const
+    {
+        return _m->error;
+    }
+    
+    template <typename T, typename Clock>
+    void RunningQuantile<T, Clock>::add(const T& x)
+    {
+        _m->push(x, Clock::now());
+    }
+    
+    template <typename T, typename Clock>
+    void RunningQuantile<T, Clock>::add(const T& x, typename Clock::time_point t)
+    {
+        _m->push(x, t);
+    }
+    
+    template <typename T, typename Clock>
+    size_t RunningQuantile<T, Clock>::size() const
+    {
+        return _m->count;
+    }
+    
+    template <typename T, typename Clock>
+    T RunningQuantile<T, Clock>::quantile(double q) const
+    {
+        if (_m->count == 0)
+            return T();
+        q = (q < 0.0) ? 0.0 : ((q > 1.0) ? 1.0 : q);
+        size_t rank = size_t(floor(q * double(_m->count - 1)));
+        return _m->representative(_m->find(rank));
+    }
+    
+    template <typename T, typename Clock>
+    T RunningQuantile<T, Clock>::median() const
+    {
+        return quantile(0.5);
+    }
+    
+}
+
+#endif
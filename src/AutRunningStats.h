@@ -0,0 +1,113 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutRunningStats.h
+//
+// A template class to compute running statistics of floating-point values:
+// the mean, variance, minimum, maximum and an exponentially weighted moving
+// average, over the same capacity and time window as RunningAverage<T>.
+// Each statistic is updated as values are added and dropped, so adding a
+// value and reading any statistic take constant (amortized) time.
+//
+
+#ifndef __AutRunningStats__
+#define __AutRunningStats__
+
+#include <chrono>
+#include <memory>
+
+namespace Aut
+{
+    
+    template <typename T, typename Clock = std::chrono::steady_clock>
+    class RunningStats
+    {
+    public:
+        
+        // The capacity and time window are as for RunningAverage<T>.  The
+        // EWMA weight is explained below.
+        
+        RunningStats(size_t capacity = 5,
+                     std::chrono::milliseconds window =
+                     std::chrono::milliseconds(500),
+                     T ewmaWeight = T(0.25));
+        ~RunningStats();
+        
+        // Set and get the number of the most recent values used in the
+        // statistics, assuming that they are all within the time window.
+        
+        void                        setCapacity(size_t);
+        size_t                      capacity() const;
+        
+        // Set and get the time window.  When a value is added, the values
+        // added more than the time window before it are dropped.
+        
+        void                        setWindow(std::chrono::milliseconds);
+        std::chrono::milliseconds   window() const;
+        
+        // Set and get the weight of each new value in the exponentially
+        // weighted moving average, between 0 and 1.  Higher weights follow
+        // the values more closely.
+        
+        void                        setEwmaWeight(T);
+        T                           ewmaWeight() const;
+        
+        // Add a value as of the current time, or as of the specified time,
+        // as for RunningAverage<T>.
+        
+        void                        add(const T&);
+        void                        add(const T&, typename Clock::time_point);
+        
+        // Return the number of values currently used.
+        
+        size_t                      size() const;
+        
+        // Return the statistics of the values currently used, or T() if
+        // there are none.  The variance is the sample variance (dividing
+        // by one less than the number of values), and is 0 for one value.
+        // The moving average starts afresh from the first value added after
+        // all the values have been dropped by the time window; values
+        // dropped for the capacity remain in it.
+        
+        T                           mean() const;
+        T                           variance() const;
+        T                           min() const;
+        T                           max() const;
+        T                           ewma() const;
+        
+    private:
+        
+        // Details of the class' data are "hidden" in the Imp.h file.
+        
+        class Imp;
+        std::unique_ptr<Imp> _m;
+    };
+    
+}
+
+// The template definitions in the following header file should be considered
+// private implementation details.
+
+#include "AutRunningStatsImp.h"
+
+#endif
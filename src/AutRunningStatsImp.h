@@ -0,0 +1,356 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutRunningStatsImp.h
+//
+// The template definitions in the this header file should be considered
+// private implementation details.
+//
+
+#ifndef __AutRunningStatsImp_h
+#define __AutRunningStatsImp_h
+
+#include "AutRunningStats.h"
+#include <algorithm>
+#include <vector>
+#include <stdint.h>
+
+namespace Aut
+{
+    template <typename T, typename Clock>
+    class RunningStats<T, Clock>::Imp
+    {
+    public:
+        Imp(size_t cap, std::chrono::milliseconds win, T weight);
+        
+        // The candidates for the minimum (or maximum): the values, identified
+        // by the numbers in which they were added, that are less than (or
+        // greater than) all the values added after them, from the oldest.
+        // The oldest candidate is the minimum (or maximum).  Each value
+        // enters and leaves once, so updates take constant amortized time.
+        // The candidates are kept in a ring the size of the capacity.
+        
+        class Candidates
+        {
+        public:
+            Candidates() : first(0), count(0) {}
+            
+            void        resize(size_t cap)  { seqs.assign(cap, 0); first = 0; count = 0; }
+            bool        empty() const       { return count == 0; }
+            uint64_t    front() const       { return seqs[first]; }
+            uint64_t    back() const        { return seqs[index(count - 1)]; }
+            void        popFront()          { first = index(1); count--; }
+            void        popBack()           { count--; }
+            void        pushBack(uint64_t s) { seqs[index(count)] = s; count++; }
+            
+        private:
+            size_t      index(size_t i) const
+            {
+                i += first;
+                return (i < seqs.size()) ? i : i - seqs.size();
+            }
+            
+            std::vector<uint64_t>   seqs;
+            size_t                  first;
+            size_t                  count;
+        };
+        
+        const T& value(uint64_t seq) const  { return ring[seq % ring.size()]; }
+        
+        void push(const T&, typename Clock::time_point);
+        void pop();
+        void clear();
+        void recompute();
+        void resize(size_t cap);
+        
+        std::chrono::milliseconds                   window;
+        T                                           weight;
+        
+        // The values and their times, in rings the size of the capacity,
+        // with the value numbered seq at index seq modulo the capacity.
+        // The values in use are numbered from next - count to next - 1.
+        
+        std::vector<T>                              ring;
+        std::vector<typename Clock::time_point>     times;
+        uint64_t                                    next;
+        size_t                                      count;
+        
+        // Welford's updates of the mean and the sum of squared differences
+        // from the mean, extended to remove values.  Removing a value whose
+        // magnitude exceeds that of all the remaining values together, or
+        // whose term is most of the sum, loses precision to cancellation,
+        // so then they are recomputed from the values.  Comparing with the
+        // magnitude rather than with the mean keeps values near 0 from
+        // triggering that walk.  They are also recomputed after every
+        // max(capacity, refresh) values, so smaller rounding errors (and
+        // those of the magnitude) do not accumulate.
+        
+        static const size_t                         refresh = 256;
+        T                                           mean;
+        T                                           m2;
+        T                                           magnitude;
+        size_t                                      pushed;
+        Candidates                                  mins;
+        Candidates                                  maxes;
+        
+        // The moving average starts afresh when all the values expire.
+        
+        T                                           ewma;
+        bool                                        started;
+    };
+    
+    template <typename T, typename Clock>
+    const size_t RunningStats<T, Clock>::Imp::refresh;
+    
+    template <typename T, typename Clock>
+    RunningStats<T, Clock>::Imp::Imp(size_t cap, std::chrono::milliseconds win, T w) :
+        window(win), weight(w), next(0), count(0), mean(), m2(), magnitude(), pushed(0), ewma(), started(false)
+    {
+        resize(cap);
+    }
+    
+    template <typename T, typename Clock>
+    void RunningStats<T, Clock>::Imp::push(const T& x, typename Clock::time_point t)
+    {
+        if (ring.empty())
+            return;
+        
+        while ((count > 0) && (t - times[(next - count) % ring.size()] > window))
+            pop();
+        if (count == 0)
+            started = false;
+        if (count == ring.size())
+            pop();
+        
+        uint64_t seq = next++;
+        ring[seq % ring.size()] = x;
+        times[seq % ring.size()] = t;
+        count++;
+        
+        T d = x - mean;
+        mean += d / T(count);
+        m2 += d * (x - mean);
+        magnitude += (x < T()) ? -x : x;
+        
+        while (!mins.empty() && !(value(mins.back()) < x))
+            mins.popBack();
+        mins.pushBack(seq);
+        while (!maxes.empty() && !(x < value(maxes.back())))
+            maxes.popBack();
+        maxes.pushBack(seq);
+        
+        ewma = started ? ewma + weight * (x - ewma) : x;
+        started = true;
+        
+        if (++pushed >= std::max(ring.size(), refresh))
+            recompute();
+    }
+    
+    template <typename T, typename Clock>
+    void RunningStats<T, Clock>::Imp::pop()
+    {
+        uint64_t seq = next - count;
+        const T& x = value(seq);
+        if (--count == 0)
+        {
+            clear();
+            return;
+        }
+        
+        T oldM2 = m2;
+        T d = x - mean;
+        mean -= d / T(count);
+        m2 -= d * (x - mean);
+        T size = (x < T()) ? -x : x;
+        magnitude -= size;
+        if (count == 1)
+        {
+            mean = value(seq + 1);
+            m2 = T();
+            magnitude = (mean < T()) ? -mean : mean;
+        }
+        else if ((size > magnitude) || (m2 < oldM2 / T(2)))
+        {
+            recompute();
+        }
+        
+        if (mins.front() == seq)
+            mins.popFront();
+        if (maxes.front() == seq)
+            maxes.popFront();
+    }
+    
+    template <typename T, typename Clock>
+    void RunningStats<T, Clock>::Imp::clear()
+    {
+        count = 0;
+        mean = T();
+        m2 = T();
+        magnitude = T();
+        mins.resize(ring.size());
+        maxes.resize(ring.size());
+    }
+    
+    template <typename T, typename Clock>
+    void RunningStats<T, Clock>::Imp::recompute()
+    {
+        mean = T();
+        m2 = T();
+        magnitude = T();
+        for (size_t i = 0; i < count; i++)
+        {
+            const T& x = value(next - count + i);
+            T d = x - mean;
+            mean += d / T(i + 1);
+            m2 += d * (x - mean);
+            magnitude += (x < T()) ? -x : x;
+        }
+        pushed = 0;
+    }
+    
+    template <typename T, typename Clock>
+    void RunningStats<T, Clock>::Imp::resize(size_t cap)
+    {
+        // Keep the most recent values that fit, adding them again in order.
+        
+        size_t kept = (count < cap) ? count : cap;
+        std::vector<T> values(kept);
+        std::vector<typename Clock::time_point> keptTimes(kept);
+        for (size_t i = 0; i < kept; i++)
+        {
+            uint64_t seq = next - kept + i;
+            values[i] = value(seq);
+            keptTimes[i] = times[seq % ring.size()];
+        }
+        T keptEwma = ewma;
+        bool keptStarted = started;
+        
+        ring.assign(cap, T());
+        times.assign(cap, typename Clock::time_point());
+        next = 0;
+        clear();
+        for (size_t i = 0; i < kept; i++)
+            push(values[i], keptTimes[i]);
+        ewma = keptEwma;
+        started = keptStarted && (kept > 0);
+    }
+    
+    template <typename T, typename Clock>
+    RunningStats<T, Clock>::RunningStats(size_t cap, std::chrono::milliseconds win, T weight) :
+        _m(new Imp(cap, win, weight))
+    {
+    }
+    
+    template <typename T, typename Clock>
+    RunningStats<T, Clock>::~RunningStats()
+    {
+    }
+    
+    template <typename T, typename Clock>
+    void RunningStats<T, Clock>::setCapacity(size_t cap)
+    {
+        if (cap != _m->ring.size())
+            _m->resize(cap);
+    }
+    
+    template <typename T, typename Clock>
+    size_t RunningStats<T, Clock>::capacity() const
+    {
+        return _m->ring.size();
+    }
+    
+    template <typename T, typename Clock>
+    void RunningStats<T, Clock>::setWindow(std::chrono::milliseconds win)
+    {
+        _m->window = win;
+    }
+    
+    template <typename T, typename Clock>
+    std::chrono::milliseconds RunningStats<T, Clock>::window() const
+    {
+        return _m->window;
+    }
+    
+    template <typename T, typename Clock>
+    void RunningStats<T, Clock>::setEwmaWeight(T weight)
+    {
+        _m->weight = weight;
+    }
+    
+    template <typename T, typename Clock>
+    T RunningStats<T, Clock>::ewmaWeight() const
+    {
+        return _m->weight;
+    }
+    
+    template <typename T, typename Clock>
+    void RunningStats<T, Clock>::add(const T& x)
+    {
+        _m->push(x, Clock::now());
+    }
+    
+    template <typename T, typename Clock>
+    void RunningStats<T, Clock>::add(const T& x, typename Clock::time_point t)
+    {
+        _m->push(x, t);
+    }
+    
+    template <typename T, typename Clock>
+    size_t RunningStats<T, Clock>::size() const
+    {
+        return _m->count;
+    }
+    
+    template <typename T, typename Clock>
+    T RunningStats<T, Clock>::mean() const
+    {
+        return _m->mean;
+    }
+    
+    template <typename T, typename Clock>
+    T RunningStats<T, Clock>::variance() const
+    {
+        return (_m->count > 1) ? _m->m2 / T(_m->count - 1) : T();
+    }
+    
+    template <typename T, typename Clock>
+    T RunningStats<T, Clock>::min() const
+    {
+        return (_m->count > 0) ? _m->value(_m->mins.front()) : T();
+    }
+    
+    template <typename T, typename Clock>
+    T RunningStats<T, Clock>::max() const
+    {
+        return (_m->count > 0) ? _m->value(_m->maxes.front()) : T();
+    }
+    
+    template <typename T, typename Clock>
+    T RunningStats<T, Clock>::ewma() const
+    {
+        return (_m->count > 0) ? _m->ewma : T();
+    }
+    
+}
+
+#endif
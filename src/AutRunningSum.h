@@ -0,0 +1,86 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutRunningSum.h
+//
+// A sum of values of type T that supports removing values as well as adding
+// them, as needed by running averages.  For floating-point types, the sum is
+// compensated (with Neumaier's variant of Kahan summation): the rounding
+// error of each addition is accumulated separately and added back when the
+// sum is read, so a sum updated by millions of additions and removals stays
+// as accurate as one computed afresh from the values it holds.  For other
+// types, the sum is plain.
+//
+
+#ifndef __AutRunningSum__
+#define __AutRunningSum__
+
+#include <type_traits>
+#include <math.h>
+
+namespace Aut
+{
+    
+    template <typename T, bool Compensated = std::is_floating_point<T>::value>
+    class RunningSum
+    {
+    public:
+        RunningSum() : _sum() {}
+        
+        void    add(const T& x)         { _sum += x; }
+        void    subtract(const T& x)    { _sum -= x; }
+        void    clear()                 { _sum = T(); }
+        T       operator()() const      { return _sum; }
+        
+    private:
+        T       _sum;
+    };
+    
+    template <typename T>
+    class RunningSum<T, true>
+    {
+    public:
+        RunningSum() : _sum(), _compensation() {}
+        
+        void    add(const T& x)
+        {
+            T t = _sum + x;
+            if (fabs(_sum) >= fabs(x))
+                _compensation += (_sum - t) + x;
+            else
+                _compensation += (x - t) + _sum;
+            _sum = t;
+        }
+        
+        void    subtract(const T& x)    { add(-x); }
+        void    clear()                 { _sum = T(); _compensation = T(); }
+        T       operator()() const      { return _sum + _compensation; }
+        
+    private:
+        T       _sum;
+        T       _compensation;
+    };
+    
+}
+
+#endif
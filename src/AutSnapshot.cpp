@@ -0,0 +1,128 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutSnapshot.cpp
+//
+
+#include "AutSnapshot.h"
+#include "AutAlert.h"
+#include <fstream>
+#include <sstream>
+#include <string.h>
+
+namespace Aut
+{
+    
+    static const char     snapshotFileMagic[4] = { 'A', 'u', 't', 'S' };
+    static const uint16_t snapshotFileVersion = 1;
+    
+    bool writeSnapshot(const std::string& path, SnapshotHeader header,
+                       const std::vector<SnapshotBlock>& blocks)
+    {
+        memcpy(header.magic, snapshotFileMagic, sizeof(header.magic));
+        header.version = snapshotFileVersion;
+        header.reserved = 0;
+        
+        std::ofstream file(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            error("Cannot create snapshot file \"" + path + "\"");
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const SnapshotBlock& block : blocks)
+            file.write(static_cast<const char*>(block.data), block.size);
+        file.close();
+        if (!file)
+        {
+            error("Cannot write snapshot file \"" + path + "\"");
+            return false;
+        }
+        return true;
+    }
+    
+    SnapshotFile::SnapshotFile(const std::string& path, SnapshotKind kind, size_t valueSize,
+                               size_t keySize, size_t recordSize, size_t bytesPerValue) :
+        _file(path), _valid(false)
+    {
+        _valid = check(path, kind, valueSize, keySize, recordSize, bytesPerValue);
+    }
+    
+    bool SnapshotFile::check(const std::string& path, SnapshotKind kind, size_t valueSize,
+                             size_t keySize, size_t recordSize, size_t bytesPerValue)
+    {
+        if (!_file.valid())
+            return false;
+        
+        const SnapshotHeader* header = static_cast<const SnapshotHeader*>(_file.data());
+        if ((_file.size() < sizeof(SnapshotHeader)) ||
+            (memcmp(header->magic, snapshotFileMagic, sizeof(snapshotFileMagic)) != 0))
+        {
+            error("\"" + path + "\" is not a snapshot file");
+            return false;
+        }
+        if (header->version != snapshotFileVersion)
+        {
+            std::stringstream text;
+            text << "Snapshot file \"" << path << "\" has version " << header->version
+                 << ", but version " << snapshotFileVersion << " is expected";
+            error(text.str());
+            return false;
+        }
+        if ((header->kind != kind) || (header->valueSize != valueSize) ||
+            (header->keySize != keySize) || (header->recordSize != recordSize))
+        {
+            error("Snapshot file \"" + path + "\" is of a different kind of averager");
+            return false;
+        }
+        
+        // The counts are checked against the file's size in a way that
+        // cannot overflow.
+        
+        uint64_t rest = _file.size() - sizeof(SnapshotHeader);
+        if ((header->streams > rest / recordSize) ||
+            (header->values != (rest - header->streams * recordSize) / bytesPerValue) ||
+            ((rest - header->streams * recordSize) % bytesPerValue != 0))
+        {
+            error("Snapshot file \"" + path + "\" has the wrong size");
+            return false;
+        }
+        return true;
+    }
+    
+    bool SnapshotFile::valid() const
+    {
+        return _valid;
+    }
+    
+    const SnapshotHeader& SnapshotFile::header() const
+    {
+        return *static_cast<const SnapshotHeader*>(_file.data());
+    }
+    
+    const char* SnapshotFile::body() const
+    {
+        return static_cast<const char*>(_file.data()) + sizeof(SnapshotHeader);
+    }
+    
+}
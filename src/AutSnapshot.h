@@ -0,0 +1,129 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutSnapshot.h
+//
+// Snapshot files, which hold the state of averagers (the values, sums and
+// times of a RunningAverage<T> or of all the streams of a
+// RunningAverageTable<Key, T>) so that it can be restored, e.g., when a
+// process restarts, without waiting for the averages to settle again.  A
+// snapshot file is a versioned header followed by the averager's arrays,
+// which are written and read as they are stored in memory.  Reading maps
+// the file and copies each array out of the mapping in one piece.
+//
+// As with clip files, the format uses the native byte order and layout of
+// the value (and key) types, so a file is portable only between similar
+// platforms.  Times are stored as ages, in nanoseconds, before the time of
+// the snapshot, since the epoch of a monotonic clock can change from one
+// run to the next; restoring a snapshot makes them ages before the time of
+// the restore.
+//
+
+#ifndef __AutSnapshot__
+#define __AutSnapshot__
+
+#include "AutMappedFile.h"
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace Aut
+{
+    
+    // The kinds of averagers.  The values are part of the file format.
+    
+    enum SnapshotKind
+    {
+        SnapshotRunningAverage = 1,
+        SnapshotRunningAverageTable = 2
+    };
+    
+    // A snapshot file's header.  The body holds a record for each stream,
+    // then the values, which for a RunningAverage<T> are preceded by their
+    // ages.
+    
+    struct SnapshotHeader
+    {
+        char        magic[4];
+        uint16_t    version;
+        uint16_t    kind;
+        uint32_t    valueSize;
+        uint32_t    keySize;
+        uint32_t    recordSize;
+        uint32_t    reserved;
+        uint64_t    capacity;
+        int64_t     window;
+        uint64_t    streams;
+        uint64_t    values;
+    };
+    
+    // A piece of a snapshot file's body.
+    
+    struct SnapshotBlock
+    {
+        const void* data;
+        size_t      size;
+    };
+    
+    // Write a snapshot file with the specified header, whose magic and
+    // version are filled in, followed by the blocks.  Return false (after
+    // reporting the problem with Aut::error()) if the file cannot be written.
+    
+    bool writeSnapshot(const std::string& path, SnapshotHeader header,
+                       const std::vector<SnapshotBlock>& blocks);
+    
+    // Reading a snapshot file.
+    
+    class SnapshotFile
+    {
+    public:
+        
+        // Map the file at the specified path, and check that its header
+        // matches the format, version, kind and sizes, and that its size
+        // matches the records of the specified size and the values, each of
+        // which takes the specified number of bytes.  Problems are reported
+        // with Aut::error(), and leave the file invalid.
+        
+        SnapshotFile(const std::string& path, SnapshotKind kind, size_t valueSize,
+                     size_t keySize, size_t recordSize, size_t bytesPerValue);
+        
+        bool                    valid() const;
+        
+        // The header, and the body that follows it, which are valid for the
+        // lifetime of this instance.  The body need not be aligned for the
+        // records and values, which should be copied out with memcpy().
+        
+        const SnapshotHeader&   header() const;
+        const char*             body() const;
+        
+    private:
+        bool                    check(const std::string& path, SnapshotKind kind, size_t valueSize,
+                                      size_t keySize, size_t recordSize, size_t bytesPerValue);
+        
+        MappedFile              _file;
+        bool                    _valid;
+    };
+    
+}
+
+#endif
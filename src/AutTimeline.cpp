@@ -0,0 +1,447 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutTimeline.cpp
+//
+
+#include "AutTimeline.h"
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <stdint.h>
+
+namespace Aut
+{
+    class Timeline::Node
+    {
+    public:
+        enum Kind { Animate, Delay, Call, Sequence, Parallel };
+        
+        Kind                                    kind;
+        std::chrono::steady_clock::duration     duration;
+        std::function<void(float)>              animate;
+        std::function<void()>                   call;
+        std::vector<std::shared_ptr<const Node>> children;
+    };
+    
+    namespace
+    {
+        // The time of a script's next event.  The serial number of the
+        // script's play orders scripts with events at the same time, and
+        // tells a wake for a script that has finished, whose storage may
+        // since have been reused.
+        
+        struct Wake
+        {
+            std::chrono::steady_clock::time_point   t;
+            uint64_t                                serial;
+            size_t                                  script;
+            
+            bool operator>(const Wake& other) const
+            {
+                return (t > other.t) || ((t == other.t) && (serial > other.serial));
+            }
+        };
+    }
+    
+    class Timeline::Imp
+    {
+    public:
+        
+        // Playing a script turns its tree of steps into a list of events,
+        // sorted by time, for the beginnings and ends of its animations, for
+        // its calls, and for its end.
+        
+        enum EventKind { Begin, End, Invoke, Finish };
+        
+        struct Event
+        {
+            std::chrono::steady_clock::duration     time;
+            EventKind                               kind;
+            const Node*                             node;
+            size_t                                  leaf;
+        };
+        
+        struct Script
+        {
+            std::shared_ptr<const Node>             root;
+            std::vector<Event>                      events;
+            size_t                                  next;
+            std::chrono::steady_clock::time_point   t0;
+            
+            // For each animation of the script, its index in the list of
+            // animations under way, or none.
+            
+            std::vector<size_t>                     activeIndex;
+            bool                                    playing;
+            
+            // The generation of the storage, counting the scripts that
+            // have finished in it, and the serial number of the play.
+            
+            size_t                                  generation;
+            uint64_t                                serial;
+        };
+        
+        struct Active
+        {
+            const Node*                             node;
+            size_t                                  script;
+            size_t                                  leaf;
+            std::chrono::steady_clock::time_point   begin;
+            float                                   invDuration;
+        };
+        
+        Imp() : playingCount(0), serials(0) {}
+        
+        void compile(const Node* node, std::chrono::steady_clock::duration time, Script& script);
+        void schedule(size_t script);
+        void begin(size_t script, const Event& event);
+        void end(size_t script, const Event& event);
+        void remove(size_t script, size_t leaf);
+        void finish(size_t script);
+        
+        // An index is a script's storage in the low half of its bits and the
+        // storage's generation in the high half.
+        
+        static size_t index(size_t script, size_t generation);
+        size_t find(size_t index) const;
+        
+        static const size_t none = size_t(-1);
+        static const unsigned scriptBits = sizeof(size_t) * 4;
+        static const size_t scriptMask = (size_t(1) << scriptBits) - 1;
+        
+        std::vector<Script>                     scripts;
+        std::vector<size_t>                     freeScripts;
+        std::vector<Active>                     active;
+        std::priority_queue<Wake, std::vector<Wake>, std::greater<Wake>> wakes;
+        size_t                                  playingCount;
+        uint64_t                                serials;
+    };
+    
+    const size_t Timeline::Imp::none;
+    const unsigned Timeline::Imp::scriptBits;
+    const size_t Timeline::Imp::scriptMask;
+    
+    void Timeline::Imp::compile(const Node* node, std::chrono::steady_clock::duration time,
+                                Script& script)
+    {
+        switch (node->kind)
+        {
+            case Node::Animate:
+            {
+                size_t leaf = script.activeIndex.size();
+                script.activeIndex.push_back(none);
+                Event begin = { time, Begin, node, leaf };
+                Event end = { time + node->duration, End, node, leaf };
+                script.events.push_back(begin);
+                script.events.push_back(end);
+                break;
+            }
+            case Node::Delay:
+                break;
+            case Node::Call:
+            {
+                Event invoke = { time, Invoke, node, 0 };
+                script.events.push_back(invoke);
+                break;
+            }
+            case Node::Sequence:
+                for (const std::shared_ptr<const Node>& child : node->children)
+                {
+                    compile(child.get(), time, script);
+                    time += child->duration;
+                }
+                break;
+            case Node::Parallel:
+                for (const std::shared_ptr<const Node>& child : node->children)
+                    compile(child.get(), time, script);
+                break;
+        }
+    }
+    
+    void Timeline::Imp::schedule(size_t script)
+    {
+        Script& s = scripts[script];
+        if (s.next < s.events.size())
+        {
+            Wake wake = { s.t0 + s.events[s.next].time, s.serial, script };
+            wakes.push(wake);
+        }
+    }
+    
+    void Timeline::Imp::begin(size_t script, const Event& event)
+    {
+        const Node* node = event.node;
+        Active a;
+        a.node = node;
+        a.script = script;
+        a.leaf = event.leaf;
+        a.begin = scripts[script].t0 + event.time;
+        float seconds = std::chrono::duration<float>(node->duration).count();
+        a.invDuration = (seconds > 0.0f) ? 1.0f / seconds : 0.0f;
+        scripts[script].activeIndex[event.leaf] = active.size();
+        active.push_back(a);
+    }
+    
+    void Timeline::Imp::end(size_t script, const Event& event)
+    {
+        event.node->animate(1.0f);
+        remove(script, event.leaf);
+    }
+    
+    void Timeline::Imp::remove(size_t script, size_t leaf)
+    {
+        size_t i = scripts[script].activeIndex[leaf];
+        if (i == none)
+            return;
+        const Active& moved = active.back();
+        scripts[moved.script].activeIndex[moved.leaf] = i;
+        active[i] = moved;
+        active.pop_back();
+        scripts[script].activeIndex[leaf] = none;
+    }
+    
+    void Timeline::Imp::finish(size_t script)
+    {
+        Script& s = scripts[script];
+        for (size_t leaf = 0; leaf < s.activeIndex.size(); leaf++)
+            remove(script, leaf);
+        s.playing = false;
+        playingCount--;
+        
+        // A finished script's steps can be released, and its storage reused.
+        
+        s.root.reset();
+        std::vector<Event>().swap(s.events);
+        std::vector<size_t>().swap(s.activeIndex);
+        s.generation = (s.generation + 1) & scriptMask;
+        freeScripts.push_back(script);
+    }
+    
+    size_t Timeline::Imp::index(size_t script, size_t generation)
+    {
+        return (generation << scriptBits) | script;
+    }
+    
+    // Return the storage of the script playing with the specified index, or
+    // none.
+    
+    size_t Timeline::Imp::find(size_t index) const
+    {
+        size_t script = index & scriptMask;
+        if ((script < scripts.size()) && scripts[script].playing &&
+            (scripts[script].generation == (index >> scriptBits)))
+            return script;
+        return none;
+    }
+    
+    //
+    
+    Timeline::Step::Step(std::shared_ptr<const Node> node) :
+        _node(node)
+    {
+    }
+    
+    std::chrono::steady_clock::duration Timeline::Step::duration() const
+    {
+        return _node->duration;
+    }
+    
+    Timeline::Timeline() :
+        _m(new Imp)
+    {
+    }
+    
+    Timeline::~Timeline()
+    {
+    }
+    
+    Timeline::Step Timeline::animate(std::chrono::steady_clock::duration duration,
+                                     std::function<void(float)> func)
+    {
+        std::shared_ptr<Node> node(new Node);
+        node->kind = Node::Animate;
+        node->duration = duration;
+        node->animate = func;
+        return Step(node);
+    }
+    
+    Timeline::Step Timeline::delay(std::chrono::steady_clock::duration duration)
+    {
+        std::shared_ptr<Node> node(new Node);
+        node->kind = Node::Delay;
+        node->duration = duration;
+        return Step(node);
+    }
+    
+    Timeline::Step Timeline::call(std::function<void()> func)
+    {
+        std::shared_ptr<Node> node(new Node);
+        node->kind = Node::Call;
+        node->duration = std::chrono::steady_clock::duration::zero();
+        node->call = func;
+        return Step(node);
+    }
+    
+    Timeline::Step Timeline::sequence(std::initializer_list<Step> steps)
+    {
+        return sequence(std::vector<Step>(steps));
+    }
+    
+    Timeline::Step Timeline::sequence(const std::vector<Step>& steps)
+    {
+        std::shared_ptr<Node> node(new Node);
+        node->kind = Node::Sequence;
+        node->duration = std::chrono::steady_clock::duration::zero();
+        for (const Step& step : steps)
+        {
+            node->children.push_back(step._node);
+            node->duration += step._node->duration;
+        }
+        return Step(node);
+    }
+    
+    Timeline::Step Timeline::parallel(std::initializer_list<Step> steps)
+    {
+        return parallel(std::vector<Step>(steps));
+    }
+    
+    Timeline::Step Timeline::parallel(const std::vector<Step>& steps)
+    {
+        std::shared_ptr<Node> node(new Node);
+        node->kind = Node::Parallel;
+        node->duration = std::chrono::steady_clock::duration::zero();
+        for (const Step& step : steps)
+        {
+            node->children.push_back(step._node);
+            node->duration = std::max(node->duration, step._node->duration);
+        }
+        return Step(node);
+    }
+    
+    size_t Timeline::play(const Step& script, std::chrono::steady_clock::time_point t0)
+    {
+        size_t index;
+        if (_m->freeScripts.empty())
+        {
+            index = _m->scripts.size();
+            _m->scripts.push_back(Imp::Script());
+            _m->scripts.back().generation = 0;
+        }
+        else
+        {
+            index = _m->freeScripts.back();
+            _m->freeScripts.pop_back();
+        }
+        Imp::Script& s = _m->scripts[index];
+        s.root = script._node;
+        s.next = 0;
+        s.t0 = t0;
+        s.playing = true;
+        s.serial = _m->serials++;
+        _m->playingCount++;
+        
+        // The stable sort keeps events at the same time in the order of the
+        // steps in the script, with the end of the script last.
+        
+        _m->compile(s.root.get(), std::chrono::steady_clock::duration::zero(), s);
+        Imp::Event finish = { s.root->duration, Imp::Finish, s.root.get(), 0 };
+        s.events.push_back(finish);
+        std::stable_sort(s.events.begin(), s.events.end(),
+                         [](const Imp::Event& a, const Imp::Event& b) { return a.time < b.time; });
+        _m->schedule(index);
+        return Imp::index(index, s.generation);
+    }
+    
+    void Timeline::stop(size_t index)
+    {
+        size_t script = _m->find(index);
+        if (script != Imp::none)
+            _m->finish(script);
+    }
+    
+    bool Timeline::playing(size_t index) const
+    {
+        return _m->find(index) != Imp::none;
+    }
+    
+    void Timeline::eval(std::chrono::steady_clock::time_point t)
+    {
+        // Events are handled one at a time, in order of their times across
+        // all the scripts.  Wakes for stopped scripts are discarded, as is the
+        // wake of a script whose storage a call reuses for another.
+        
+        while (!_m->wakes.empty() && (_m->wakes.top().t <= t))
+        {
+            size_t script = _m->wakes.top().script;
+            uint64_t serial = _m->wakes.top().serial;
+            _m->wakes.pop();
+            if (!_m->scripts[script].playing || (_m->scripts[script].serial != serial))
+                continue;
+            
+            Imp::Event event = _m->scripts[script].events[_m->scripts[script].next++];
+            switch (event.kind)
+            {
+                case Imp::Begin:
+                    _m->begin(script, event);
+                    break;
+                case Imp::End:
+                    _m->end(script, event);
+                    break;
+                case Imp::Invoke:
+                {
+                    // The function may stop its own script, which releases
+                    // the steps, so they are kept until the call returns.
+                    
+                    std::shared_ptr<const Node> root = _m->scripts[script].root;
+                    event.node->call();
+                    break;
+                }
+                case Imp::Finish:
+                    _m->finish(script);
+                    break;
+            }
+            if (_m->scripts[script].playing && (_m->scripts[script].serial == serial))
+                _m->schedule(script);
+        }
+        
+        for (const Imp::Active& a : _m->active)
+            a.node->animate(std::chrono::duration<float>(t - a.begin).count() * a.invDuration);
+    }
+    
+    size_t Timeline::size() const
+    {
+        return _m->playingCount;
+    }
+    
+    size_t Timeline::active() const
+    {
+        return _m->active.size();
+    }
+    
+    size_t Timeline::capacity() const
+    {
+        return _m->scripts.size();
+    }
+    
+}
@@ -0,0 +1,163 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutTimeline.h
+//
+// A class for playing scripts that compose animations of several variables.
+// A script is a tree of steps: animating a variable between two values,
+// waiting, calling a function, and running steps in sequence or in parallel.
+// Each step's duration is known when the script is built, so playing a script
+// schedules when each of its steps begins and ends.  Evaluation wakes only
+// the scripts with a step beginning or ending by the time being evaluated,
+// and evaluates only the animations under way, so its cost depends on the
+// work being done, not on the number of scripts playing.
+//
+
+#ifndef __AutTimeline__
+#define __AutTimeline__
+
+#include "AutAnimTraits.h"
+#include "AutEase.h"
+#include <chrono>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+namespace Aut
+{
+    
+    class Timeline
+    {
+        // The data of a step, "hidden" in the .cpp file.
+        
+        class Node;
+        
+    public:
+        
+        Timeline();
+        ~Timeline();
+        
+        // A step of a script.  Steps are immutable and cheap to copy, so
+        // a step can appear in any number of scripts (or more than once in
+        // one script).
+        
+        class Step
+        {
+        public:
+            
+            // Return the time from the beginning of the step to its end.
+            
+            std::chrono::steady_clock::duration duration() const;
+            
+        private:
+            
+            Step(std::shared_ptr<const Node> node);
+            
+            std::shared_ptr<const Node> _node;
+            
+            friend class Timeline;
+        };
+        
+        // Make a step that animates a variable from one value to another over
+        // the specified duration, with the specified easing policy.
+        
+        template <typename Ease = FastCosineEase, typename T>
+        static Step animate(T* val, const T& val0, const T& val1,
+                            std::chrono::steady_clock::duration duration);
+        
+        // Make a step that waits for the specified duration.
+        
+        static Step delay(std::chrono::steady_clock::duration duration);
+        
+        // Make a step that calls a function, taking no time.  The function
+        // may play and stop scripts.
+        
+        static Step call(std::function<void()> func);
+        
+        // Make a step that runs steps one after another, or one that runs
+        // steps at the same time, ending when the longest one ends.
+        
+        static Step sequence(std::initializer_list<Step> steps);
+        static Step sequence(const std::vector<Step>& steps);
+        static Step parallel(std::initializer_list<Step> steps);
+        static Step parallel(const std::vector<Step>& steps);
+        
+        // Play a script starting at the specified time, returning the index
+        // that identifies it in the other routines.  A finished script's
+        // storage is reused by a later one, but not its index: the index
+        // also carries a generation, so an index kept after its script has
+        // finished never identifies another script.
+        
+        size_t  play(const Step& script, std::chrono::steady_clock::time_point t0 =
+                     std::chrono::steady_clock::now());
+        
+        // Stop a script, leaving its variables as they are.
+        
+        void    stop(size_t index);
+        
+        // Return whether a script is still playing.
+        
+        bool    playing(size_t index) const;
+        
+        // Advance the scripts to the specified time.  The steps that begin
+        // and end by that time do so in order of their times, with a step
+        // that follows another in a sequence coming after it.  The animations
+        // under way are then evaluated.
+        
+        void    eval(std::chrono::steady_clock::time_point t =
+                     std::chrono::steady_clock::now());
+        
+        // Return the number of scripts playing, and the number of animation
+        // steps under way.
+        
+        size_t  size() const;
+        size_t  active() const;
+        
+        // Return the number of scripts the timeline has storage for, which
+        // is the most that have been playing at once.
+        
+        size_t  capacity() const;
+        
+    private:
+        
+        static Step animate(std::chrono::steady_clock::duration duration,
+                            std::function<void(float)> func);
+        
+        // Details of the class' data are "hidden" in the .cpp file.
+        
+        class Imp;
+        std::unique_ptr<Imp> _m;
+    };
+    
+    template <typename Ease, typename T>
+    Timeline::Step Timeline::animate(T* val, const T& val0, const T& val1,
+                                     std::chrono::steady_clock::duration duration)
+    {
+        return animate(duration, [=](float s)
+                       { *val = AnimTraits<T>::interp(val0, val1, Ease::eval(s)); });
+    }
+    
+}
+
+#endif
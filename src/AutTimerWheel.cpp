@@ -0,0 +1,270 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutTimerWheel.cpp
+//
+
+#include "AutTimerWheel.h"
+#include <stdint.h>
+
+namespace Aut
+{
+    namespace
+    {
+        // Each level of the wheel has 256 slots, each covering 256 times as
+        // many ticks as a slot of the level below.  Items too far in the future
+        // for the top level wait in an overflow list.
+        
+        const unsigned  bits = 8;
+        const size_t    slots = size_t(1) << bits;
+        const size_t    slotMask = slots - 1;
+        const unsigned  levels = 4;
+        const size_t    dueList = levels * slots;
+        const size_t    overflowList = dueList + 1;
+        const size_t    none = size_t(-1);
+    }
+    
+    class TimerWheel::Imp
+    {
+    public:
+        Imp(std::chrono::steady_clock::duration d,
+            std::chrono::steady_clock::time_point t) :
+            tick(d), start(t), current(0), heads(overflowList + 1, none), count(0)
+        {
+            for (uint64_t& word : occupied)
+                word = 0;
+        }
+        
+        struct Node
+        {
+            size_t      next;
+            size_t      prev;
+            size_t      list;
+            uint64_t    expiry;
+        };
+        
+        uint64_t ticks(std::chrono::steady_clock::time_point t, bool roundUp) const;
+        void     link(size_t item, size_t list);
+        void     unlink(size_t item);
+        void     place(size_t item);
+        void     cascade(size_t list);
+        void     take(size_t list, std::vector<size_t>& due);
+        size_t   nextOccupied(size_t slot) const;
+        
+        std::chrono::steady_clock::duration     tick;
+        std::chrono::steady_clock::time_point   start;
+        uint64_t                                current;
+        std::vector<Node>                       nodes;
+        std::vector<size_t>                     heads;
+        size_t                                  count;
+        
+        // A bit for each slot of the lowest level, set if the slot has items,
+        // allows skipping over empty slots.
+        
+        uint64_t                                occupied[slots / 64];
+    };
+    
+    uint64_t TimerWheel::Imp::ticks(std::chrono::steady_clock::time_point t, bool roundUp) const
+    {
+        if (t <= start)
+            return 0;
+        std::chrono::steady_clock::duration d = t - start;
+        uint64_t n = d / tick;
+        if (roundUp && (d % tick != std::chrono::steady_clock::duration::zero()))
+            n++;
+        return n;
+    }
+    
+    void TimerWheel::Imp::link(size_t item, size_t list)
+    {
+        Node& node = nodes[item];
+        node.list = list;
+        node.prev = none;
+        node.next = heads[list];
+        if (node.next != none)
+            nodes[node.next].prev = item;
+        heads[list] = item;
+        if (list < slots)
+            occupied[list / 64] |= uint64_t(1) << (list % 64);
+    }
+    
+    void TimerWheel::Imp::unlink(size_t item)
+    {
+        Node& node = nodes[item];
+        if (node.prev != none)
+            nodes[node.prev].next = node.next;
+        else
+            heads[node.list] = node.next;
+        if (node.next != none)
+            nodes[node.next].prev = node.prev;
+        if ((node.list < slots) && (heads[node.list] == none))
+            occupied[node.list / 64] &= ~(uint64_t(1) << (node.list % 64));
+        node.list = none;
+    }
+    
+    void TimerWheel::Imp::place(size_t item)
+    {
+        uint64_t expiry = nodes[item].expiry;
+        if (expiry <= current)
+        {
+            link(item, dueList);
+            return;
+        }
+        
+        uint64_t delta = expiry - current;
+        for (unsigned level = 0; level < levels; level++)
+        {
+            if (delta < (uint64_t(1) << (bits * (level + 1))))
+            {
+                link(item, level * slots + ((expiry >> (bits * level)) & slotMask));
+                return;
+            }
+        }
+        link(item, overflowList);
+    }
+    
+    void TimerWheel::Imp::cascade(size_t list)
+    {
+        size_t item = heads[list];
+        while (item != none)
+        {
+            size_t next = nodes[item].next;
+            unlink(item);
+            place(item);
+            item = next;
+        }
+    }
+    
+    void TimerWheel::Imp::take(size_t list, std::vector<size_t>& due)
+    {
+        while (heads[list] != none)
+        {
+            size_t item = heads[list];
+            unlink(item);
+            due.push_back(item);
+            count--;
+        }
+    }
+    
+    size_t TimerWheel::Imp::nextOccupied(size_t slot) const
+    {
+        for (size_t word = slot / 64; word < slots / 64; word++)
+        {
+            uint64_t bitsLeft = occupied[word];
+            if (word == slot / 64)
+                bitsLeft &= ~uint64_t(0) << (slot % 64);
+            if (bitsLeft != 0)
+            {
+                size_t bit = 0;
+                while (!(bitsLeft & (uint64_t(1) << bit)))
+                    bit++;
+                return word * 64 + bit;
+            }
+        }
+        return slots;
+    }
+    
+    TimerWheel::TimerWheel(std::chrono::steady_clock::duration tick,
+                           std::chrono::steady_clock::time_point start) :
+        _m(new Imp(tick, start))
+    {
+    }
+    
+    TimerWheel::~TimerWheel()
+    {
+    }
+    
+    void TimerWheel::schedule(size_t item, std::chrono::steady_clock::time_point t)
+    {
+        if (item >= _m->nodes.size())
+        {
+            Imp::Node node = { none, none, none, 0 };
+            _m->nodes.resize(item + 1, node);
+        }
+        if (_m->nodes[item].list != none)
+            _m->unlink(item);
+        else
+            _m->count++;
+        _m->nodes[item].expiry = _m->ticks(t, true);
+        _m->place(item);
+    }
+    
+    void TimerWheel::cancel(size_t item)
+    {
+        if (scheduled(item))
+        {
+            _m->unlink(item);
+            _m->count--;
+        }
+    }
+    
+    bool TimerWheel::scheduled(size_t item) const
+    {
+        return (item < _m->nodes.size()) && (_m->nodes[item].list != none);
+    }
+    
+    size_t TimerWheel::size() const
+    {
+        return _m->count;
+    }
+    
+    void TimerWheel::advance(std::chrono::steady_clock::time_point t,
+                             std::vector<size_t>& due)
+    {
+        uint64_t target = _m->ticks(t, false);
+        _m->take(dueList, due);
+        
+        while ((_m->current < target) && (_m->count > 0))
+        {
+            // Skip to the next occupied slot of the lowest level, or to the
+            // next time the higher levels need to be cascaded down.
+            
+            uint64_t base = _m->current & ~uint64_t(slotMask);
+            size_t slot = _m->nextOccupied((_m->current & slotMask) + 1);
+            uint64_t next = base + slot;
+            if (next > target)
+                next = target;
+            _m->current = next;
+            
+            if ((_m->current & slotMask) == 0)
+            {
+                for (unsigned level = 1; level < levels; level++)
+                {
+                    uint64_t index = _m->current >> (bits * level);
+                    _m->cascade(level * slots + (index & slotMask));
+                    if ((index & slotMask) != 0)
+                        break;
+                    if (level == levels - 1)
+                        _m->cascade(overflowList);
+                }
+            }
+            
+            _m->take(_m->current & slotMask, due);
+            _m->take(dueList, due);
+        }
+        
+        if (_m->current < target)
+            _m->current = target;
+    }
+    
+}
@@ -0,0 +1,91 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutTimerWheel.h
+//
+// A hierarchical timer wheel, which keeps track of when each of a set of items
+// is due, so that advancing time costs little more than the work of finding
+// the items that have come due, however many items are waiting.  Items are
+// identified by small integers (e.g., indices into the caller's own arrays).
+//
+
+#ifndef __AutTimerWheel__
+#define __AutTimerWheel__
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace Aut
+{
+    
+    class TimerWheel
+    {
+    public:
+        
+        // Times are rounded to the specified tick, measured from the specified
+        // starting time.  An item comes due on the first call to advance()
+        // with a time at or after the item's time, rounded up to a tick.
+        
+        TimerWheel(std::chrono::steady_clock::duration tick =
+                   std::chrono::milliseconds(1),
+                   std::chrono::steady_clock::time_point start =
+                   std::chrono::steady_clock::now());
+        ~TimerWheel();
+        
+        // Schedule an item for the specified time, replacing any time for
+        // which it was already scheduled.  An item scheduled for a time that
+        // has already passed comes due on the next call to advance().
+        
+        void    schedule(size_t item, std::chrono::steady_clock::time_point t);
+        
+        // Cancel the scheduling of an item, if it is scheduled.
+        
+        void    cancel(size_t item);
+        
+        // Return whether an item is scheduled.
+        
+        bool    scheduled(size_t item) const;
+        
+        // Return the number of items scheduled.
+        
+        size_t  size() const;
+        
+        // Advance to the specified time, appending the items that have come
+        // due to the vector, in the order of their times.  They are no longer
+        // scheduled.
+        
+        void    advance(std::chrono::steady_clock::time_point t,
+                        std::vector<size_t>& due);
+        
+    private:
+        
+        // Details of the class' data are "hidden" in the .cpp file.
+        
+        class Imp;
+        std::unique_ptr<Imp> _m;
+    };
+    
+}
+
+#endif
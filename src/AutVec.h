@@ -0,0 +1,328 @@
+// Copyright (c) 2013 Philip M. Hubbard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// http://opensource.org/licenses/MIT
+
+//
+// AutVec.h
+//
+// Small value types for animating more than one float at once: Vec<N>, a
+// vector of N floats (e.g., a position or a color), and Quat, a quaternion
+// for orientations.  Both are stored in groups of four floats, aligned to
+// 16 bytes, so their arithmetic uses SSE when it is available, and animating
+// a four-component value costs about the same as animating one float.
+// Quaternions are interpolated along the shorter arc, with normalized linear
+// interpolation (nlerp), which follows the same path as spherical linear
+// interpolation (slerp) at a slightly varying speed; slerp() is available
+// for code that needs constant angular speed.
+//
+
+#ifndef __AutVec__
+#define __AutVec__
+
+#include "AutAnimTraits.h"
+#include <initializer_list>
+#include <stddef.h>
+#include <math.h>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+namespace Aut
+{
+    
+    template <size_t N>
+    struct alignas(16) Vec
+    {
+        // The components beyond N, which pad the storage to a multiple of
+        // four, are kept at zero.
+        
+        static const size_t padded = (N + 3) & ~size_t(3);
+        
+        float v[padded];
+        
+        Vec()
+        {
+            for (size_t i = 0; i < padded; i++)
+                v[i] = 0.0f;
+        }
+        
+        Vec(std::initializer_list<float> values)
+        {
+            size_t i = 0;
+            for (const float* it = values.begin(); (it != values.end()) && (i < N); ++it)
+                v[i++] = *it;
+            for (; i < padded; i++)
+                v[i] = 0.0f;
+        }
+        
+        float&          operator[](size_t i)        { return v[i]; }
+        const float&    operator[](size_t i) const  { return v[i]; }
+    };
+    
+    // Component-wise arithmetic, four components at a time.
+    
+    template <size_t N>
+    inline Vec<N> operator+(const Vec<N>& a, const Vec<N>& b)
+    {
+        Vec<N> r;
+        for (size_t i = 0; i < Vec<N>::padded; i += 4)
+        {
+#if defined(__SSE__)
+            _mm_store_ps(r.v + i, _mm_add_ps(_mm_load_ps(a.v + i), _mm_load_ps(b.v + i)));
+#else
+            for (size_t j = i; j < i + 4; j++)
+                r.v[j] = a.v[j] + b.v[j];
+#endif
+        }
+        return r;
+    }
+    
+    template <size_t N>
+    inline Vec<N> operator-(const Vec<N>& a, const Vec<N>& b)
+    {
+        Vec<N> r;
+        for (size_t i = 0; i < Vec<N>::padded; i += 4)
+        {
+#if defined(__SSE__)
+            _mm_store_ps(r.v + i, _mm_sub_ps(_mm_load_ps(a.v + i), _mm_load_ps(b.v + i)));
+#else
+            for (size_t j = i; j < i + 4; j++)
+                r.v[j] = a.v[j] - b.v[j];
+#endif
+        }
+        return r;
+    }
+    
+    template <size_t N>
+    inline Vec<N> operator*(float s, const Vec<N>& a)
+    {
+        // The padding is multiplied too, which keeps it at zero for finite s.
+        
+        Vec<N> r;
+        for (size_t i = 0; i < Vec<N>::padded; i += 4)
+        {
+#if defined(__SSE__)
+            _mm_store_ps(r.v + i, _mm_mul_ps(_mm_set1_ps(s), _mm_load_ps(a.v + i)));
+#else
+            for (size_t j = i; j < i + 4; j++)
+                r.v[j] = s * a.v[j];
+#endif
+        }
+        return r;
+    }
+    
+    template <size_t N>
+    inline Vec<N> operator*(const Vec<N>& a, float s)
+    {
+        return s * a;
+    }
+    
+    template <size_t N>
+    inline bool operator==(const Vec<N>& a, const Vec<N>& b)
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            if (a.v[i] != b.v[i])
+                return false;
+        }
+        return true;
+    }
+    
+    template <size_t N>
+    inline bool operator!=(const Vec<N>& a, const Vec<N>& b)
+    {
+        return !(a == b);
+    }
+    
+    template <size_t N>
+    inline float dot(const Vec<N>& a, const Vec<N>& b)
+    {
+        float d = 0.0f;
+        for (size_t i = 0; i < N; i++)
+            d += a.v[i] * b.v[i];
+        return d;
+    }
+    
+    // Linear interpolation needs no temporaries beyond the registers.
+    
+    template <size_t N>
+    struct AnimTraits<Vec<N>>
+    {
+        static Vec<N> interp(const Vec<N>& val0, const Vec<N>& val1, float w)
+        {
+            Vec<N> r;
+            for (size_t i = 0; i < Vec<N>::padded; i += 4)
+            {
+#if defined(__SSE__)
+                __m128 a = _mm_load_ps(val0.v + i);
+                __m128 b = _mm_load_ps(val1.v + i);
+                _mm_store_ps(r.v + i, _mm_add_ps(a, _mm_mul_ps(_mm_set1_ps(w), _mm_sub_ps(b, a))));
+#else
+                for (size_t j = i; j < i + 4; j++)
+                    r.v[j] = val0.v[j] + w * (val1.v[j] - val0.v[j]);
+#endif
+            }
+            return r;
+        }
+        
+        static float distance(const Vec<N>& val0, const Vec<N>& val1)
+        {
+            Vec<N> d = val1 - val0;
+            return sqrtf(dot(d, d));
+        }
+
+        static Vec<N> add(const Vec<N>& val, const Vec<N>& delta, float w)
+        {
+            return val + w * delta;
+        }
+    };
+    
+    //
+    
+    // A quaternion x i + y j + z k + w.  The default is the identity rotation.
+    
+    struct alignas(16) Quat
+    {
+        float x, y, z, w;
+        
+        Quat() : x(0.0f), y(0.0f), z(0.0f), w(1.0f) {}
+        Quat(float qx, float qy, float qz, float qw) : x(qx), y(qy), z(qz), w(qw) {}
+        
+        // The rotation by an angle (in radians) around a unit-length axis.
+        
+        static Quat axisAngle(float ax, float ay, float az, float angle)
+        {
+            float s = sinf(angle / 2.0f);
+            return Quat(ax * s, ay * s, az * s, cosf(angle / 2.0f));
+        }
+    };
+    
+    inline bool operator==(const Quat& a, const Quat& b)
+    {
+        return (a.x == b.x) && (a.y == b.y) && (a.z == b.z) && (a.w == b.w);
+    }
+    
+    inline bool operator!=(const Quat& a, const Quat& b)
+    {
+        return !(a == b);
+    }
+    
+    inline float dot(const Quat& a, const Quat& b)
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+    }
+    
+    // The product, which is the rotation b followed by the rotation a.
+    
+    inline Quat operator*(const Quat& a, const Quat& b)
+    {
+        return Quat(a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+                    a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+                    a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+                    a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z);
+    }
+    
+    // Normalized linear interpolation, along the shorter arc.
+    
+    inline Quat nlerp(const Quat& q0, const Quat& q1, float t)
+    {
+        Quat r;
+#if defined(__SSE__)
+        __m128 a = _mm_load_ps(&q0.x);
+        __m128 b = _mm_load_ps(&q1.x);
+        
+        // Negating q1 when it is on the far side gives the same rotation
+        // along the shorter arc.  The sign bit of the dot product does that.
+        
+        __m128 d = _mm_mul_ps(a, b);
+        d = _mm_add_ps(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 3, 0, 1)));
+        d = _mm_add_ps(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(1, 0, 3, 2)));
+        b = _mm_xor_ps(b, _mm_and_ps(d, _mm_set1_ps(-0.0f)));
+        
+        __m128 q = _mm_add_ps(a, _mm_mul_ps(_mm_set1_ps(t), _mm_sub_ps(b, a)));
+        __m128 n = _mm_mul_ps(q, q);
+        n = _mm_add_ps(n, _mm_shuffle_ps(n, n, _MM_SHUFFLE(2, 3, 0, 1)));
+        n = _mm_add_ps(n, _mm_shuffle_ps(n, n, _MM_SHUFFLE(1, 0, 3, 2)));
+        _mm_store_ps(&r.x, _mm_div_ps(q, _mm_sqrt_ps(n)));
+#else
+        float s = (dot(q0, q1) < 0.0f) ? -1.0f : 1.0f;
+        r.x = q0.x + t * (s * q1.x - q0.x);
+        r.y = q0.y + t * (s * q1.y - q0.y);
+        r.z = q0.z + t * (s * q1.z - q0.z);
+        r.w = q0.w + t * (s * q1.w - q0.w);
+        float n = sqrtf(dot(r, r));
+        r.x /= n;
+        r.y /= n;
+        r.z /= n;
+        r.w /= n;
+#endif
+        return r;
+    }
+    
+    // Spherical linear interpolation, along the shorter arc.  Nearly equal
+    // rotations fall back to nlerp, which is then just as accurate.
+    
+    inline Quat slerp(const Quat& q0, const Quat& q1, float t)
+    {
+        float d = dot(q0, q1);
+        float s = (d < 0.0f) ? -1.0f : 1.0f;
+        d *= s;
+        if (d > 0.9995f)
+            return nlerp(q0, q1, t);
+        
+        float angle = acosf(d);
+        float sin0 = sinf((1.0f - t) * angle);
+        float sin1 = s * sinf(t * angle);
+        float inv = 1.0f / sinf(angle);
+        return Quat((sin0 * q0.x + sin1 * q1.x) * inv, (sin0 * q0.y + sin1 * q1.y) * inv,
+                    (sin0 * q0.z + sin1 * q1.z) * inv, (sin0 * q0.w + sin1 * q1.w) * inv);
+    }
+    
+    template <>
+    struct AnimTraits<Quat>
+    {
+        static Quat interp(const Quat& val0, const Quat& val1, float w)
+        {
+            return nlerp(val0, val1, w);
+        }
+        
+        // The distance is the angle (in radians) of the rotation between
+        // the two orientations.
+        
+        static float distance(const Quat& val0, const Quat& val1)
+        {
+            float d = fabsf(dot(val0, val1));
+            return 2.0f * acosf((d < 1.0f) ? d : 1.0f);
+        }
+        
+        // An additive rotation is applied after the value, scaled by w
+        // along the arc from the identity.
+        
+        static Quat add(const Quat& val, const Quat& delta, float w)
+        {
+            return nlerp(Quat(), delta, w) * val;
+        }
+    };
+    
+}
+
+#endif